@@ -0,0 +1,91 @@
+// autotune.cpp - 离线调度调优
+// 对用例文件中的每个 (N, P) 搜索 算法 × 环数 × 流水深度，按评分器取通信时间最小的参数，
+// 写入调优表（见 schedule_tuner.h）；test_simple --tuning <path> 或 Solution::SetTuningTable 使用该表。
+// 调优按默认代价模型进行，调优表只以 (N, P) 为键。
+#include "solution.h"
+#include "cost_model.h"
+#include "schedule_tuner.h"
+#include "test_case_loader.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    // --cases <path>: 提供形状的用例文件，默认sample.json，无法打开时使用内置用例
+    // --out <path>: 调优表输出路径，默认tuning_table.txt
+    // --threads <T>: 并行调优的形状数（0为全部硬件线程）
+    // --max-depth <D>: CHUNKED_RING尝试的最大流水深度
+    // --slack <S>: 只打分闭式估计不超过最优估计S倍的候选
+    // --parallel-edges: 按度数预算内的并行边拓扑估计与评分
+    string cases_path = "sample.json";
+    string out_path = "tuning_table.txt";
+    ScheduleOptions options;
+    TunerOptions tuner_options;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--cases" && i + 1 < argc) {
+            cases_path = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            tuner_options.threadNum = static_cast<uint32_t>(stoul(argv[++i]));
+        } else if (arg == "--max-depth" && i + 1 < argc) {
+            tuner_options.maxPipelineDepth = static_cast<uint32_t>(stoul(argv[++i]));
+        } else if (arg == "--slack" && i + 1 < argc) {
+            tuner_options.pruneSlack = stod(argv[++i]);
+        } else if (arg == "--parallel-edges") {
+            options.parallelEdges = true;
+        }
+    }
+
+    vector<TestCase> test_cases;
+    string error;
+    if (!LoadTestCases(cases_path, test_cases, &error)) {
+        cerr << error << endl;
+        if (test_cases.empty()) {
+            test_cases = DefaultTestCases();
+            cerr << "使用内置测试用例" << endl;
+        }
+    }
+    vector<pair<uint32_t, uint32_t>> shapes;
+    for (const TestCase& test_case : test_cases) {
+        shapes.push_back({test_case.rankSize, test_case.planeNum});
+    }
+
+    CostModel cost_model;
+    ScheduleTuner tuner(cost_model, options, tuner_options);
+    TuningTable table;
+    auto start = chrono::high_resolution_clock::now();
+    TuneStats stats = tuner.TuneAll(shapes, table);
+    auto end = chrono::high_resolution_clock::now();
+
+    // 与按代价模型自动选择的结果对比
+    Solution solution(cost_model);
+    solution.SetScheduleOptions(options);
+    cout.precision(4);
+    for (const auto& shape : shapes) {
+        TunedSchedule tuned;
+        if (!table.Find(shape.first, shape.second, tuned)) {
+            cout << "N=" << shape.first << " P=" << shape.second << ": 没有可行的调度" << endl;
+            continue;
+        }
+        ScheduleAlgorithm selected = solution.SelectAlgorithm(shape.first, shape.second);
+        cout << "N=" << shape.first << " P=" << shape.second << ": " << ScheduleAlgorithmName(tuned.algorithm)
+             << " depth=" << tuned.pipelineDepth << " rings=" << tuned.ringNum << " T=" << tuned.time
+             << " ms（auto: " << ScheduleAlgorithmName(selected) << " 估计 "
+             << solution.EstimateTime(shape.first, shape.second, selected) << " ms）" << endl;
+    }
+    cout << "候选 " << stats.candidateNum << " 个，实际打分 " << stats.scoredNum << " 个，耗时 "
+         << chrono::duration_cast<chrono::milliseconds>(end - start).count() << " ms" << endl;
+
+    if (!table.Save(out_path, &error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    cout << "调优表已写入 " << out_path << "（" << table.size() << " 个形状）" << endl;
+    return 0;
+}
@@ -0,0 +1,99 @@
+//
+// 批量评测实现
+//
+
+#include "batch_evaluator.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+BatchEvaluator::BatchEvaluator(uint32_t jobNum, size_t windowSize)
+{
+    if (jobNum == 0) {
+        jobNum = thread::hardware_concurrency();
+    }
+    jobNum_ = (jobNum == 0) ? 1 : jobNum;
+    windowSize_ = (windowSize == 0) ? 2 * static_cast<size_t>(jobNum_) : windowSize;
+    if (windowSize_ < jobNum_) {
+        windowSize_ = jobNum_;  // 窗口小于线程数时多余的线程只会空等
+    }
+}
+
+size_t BatchEvaluator::Run(const CaseSource& source, const CaseWorker& worker, const ResultSink& sink) const
+{
+    if (jobNum_ == 1) {
+        CaseResult result;
+        size_t caseNum = 0;
+        while (source(result.testCase)) {
+            result.index = caseNum++;
+            result.score = 0.0;
+            result.report.clear();
+            worker(0, result);
+            sink(result);
+        }
+        return caseNum;
+    }
+
+    // 第i个用例的结果放在slots[i % windowSize_]，
+    // 领取条件 nextFetch - nextEmit < windowSize_ 保证槽位不会被覆盖
+    mutex lock;
+    condition_variable windowFreed;
+    vector<CaseResult> slots(windowSize_);
+    vector<char> ready(windowSize_, 0);
+    size_t nextFetch = 0;
+    size_t nextEmit = 0;
+    bool exhausted = false;
+
+    auto run = [&](uint32_t workerId) {
+        CaseResult result;
+        while (true) {
+            {
+                unique_lock<mutex> guard(lock);
+                windowFreed.wait(guard, [&] { return exhausted || nextFetch - nextEmit < windowSize_; });
+                if (exhausted || !source(result.testCase)) {
+                    exhausted = true;
+                    windowFreed.notify_all();
+                    return;
+                }
+                result.index = nextFetch++;
+            }
+
+            result.score = 0.0;
+            result.report.clear();
+            worker(workerId, result);
+
+            lock_guard<mutex> guard(lock);
+            size_t slot = result.index % windowSize_;
+            slots[slot].index = result.index;
+            slots[slot].testCase = result.testCase;
+            slots[slot].score = result.score;
+            slots[slot].report.swap(result.report);
+            ready[slot] = 1;
+            // 依次输出已完成的队首用例
+            bool emitted = false;
+            while (ready[nextEmit % windowSize_] != 0) {
+                size_t head = nextEmit % windowSize_;
+                sink(slots[head]);
+                ready[head] = 0;
+                ++nextEmit;
+                emitted = true;
+            }
+            if (emitted) {
+                windowFreed.notify_all();
+            }
+        }
+    };
+
+    vector<thread> threads;
+    for (uint32_t workerId = 1; workerId < jobNum_; ++workerId) {
+        threads.emplace_back(run, workerId);
+    }
+    run(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+    return nextFetch;
+}
@@ -0,0 +1,48 @@
+//
+// 批量评测：jobNum个工作线程从同一个用例来源领取用例，各自独立地生成、校验与评分，
+// 结果严格按用例顺序交给输出回调，输出与线程数无关。
+// 已领取但尚未输出的用例不超过windowSize个，因此同时驻留的Blueprint不超过jobNum个，
+// 等待输出的只有各用例的结果（得分与报告文本）。
+//
+
+#ifndef CPP_BATCH_EVALUATOR_H
+#define CPP_BATCH_EVALUATOR_H
+
+#include "test_case_loader.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+struct CaseResult {
+    size_t index{0};  // 用例序号，从0开始
+    TestCase testCase;
+    double score{0.0};
+    std::string report;  // 该用例的输出文本
+};
+
+class BatchEvaluator {
+public:
+    // 取下一个用例，没有更多用例时返回false；调用时已持锁，来源无需线程安全
+    using CaseSource = std::function<bool(TestCase& testCase)>;
+    // 评测单个用例并填写score与report；workerId ∈ [0, JobNum())，
+    // 同一workerId不会被并发调用，可用于索引各线程独立的评分器等状态
+    using CaseWorker = std::function<void(uint32_t workerId, CaseResult& result)>;
+    // 按index递增的顺序调用，调用时已持锁
+    using ResultSink = std::function<void(const CaseResult& result)>;
+
+    // jobNum为0时使用全部硬件线程；windowSize为0时取2 * jobNum
+    explicit BatchEvaluator(uint32_t jobNum = 1, size_t windowSize = 0);
+
+    uint32_t JobNum() const { return jobNum_; }
+    size_t WindowSize() const { return windowSize_; }
+
+    // 返回评测的用例数；jobNum为1时在调用线程上顺序执行，不创建线程
+    size_t Run(const CaseSource& source, const CaseWorker& worker, const ResultSink& sink) const;
+
+private:
+    uint32_t jobNum_;
+    size_t windowSize_;
+};
+
+#endif // CPP_BATCH_EVALUATOR_H
@@ -0,0 +1,310 @@
+// benchmark.cpp - 生成/校验/评分基准测试
+// 扫描 N ∈ {4, 8, ..., 8192} × P ∈ {2, 4, ..., 64} 以及sample.json中的形状，
+// 对每个形状分别计时Blueprint生成、校验与评分，统计中位数、p99、内存分配次数与峰值RSS，
+// 以及生成与评分按中位数计的吞吐（action/ns），
+// --cache时另计时BlueprintCache命中路径，结束时输出缓存的命中/未命中/淘汰统计，
+// 以JSON Lines输出到标准输出（首行为运行参数，之后每行一个形状），进度输出到标准错误。
+#include "solution.h"
+#include "flat_blueprint.h"
+#include "compact_blueprint.h"
+#include "cost_model.h"
+#include "blueprint_scorer.h"
+#include "lazy_blueprint.h"
+#include "blueprint_cache.h"
+#include "schedule_generators.h"
+#include "simd_kernels.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 统计全局operator new的调用次数与字节数
+atomic<uint64_t> ALLOC_COUNT(0);
+atomic<uint64_t> ALLOC_BYTES(0);
+
+void* operator new(size_t size) {
+    ALLOC_COUNT.fetch_add(1, memory_order_relaxed);
+    ALLOC_BYTES.fetch_add(size, memory_order_relaxed);
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+const CostModel COST_MODEL;
+BlueprintScorer SCORER(COST_MODEL);
+BlueprintCache CACHE;
+
+// 与sample.json相同的形状
+const vector<pair<uint32_t, uint32_t>> SAMPLE_CASES = {
+    {4, 2}, {4, 6}, {5, 2}, {5, 4}, {10, 4},
+    {10, 10}, {32, 6}, {33, 4}, {64, 8}, {128, 18}
+};
+
+// 与test_simple相同的结构校验（不输出错误信息）
+template <typename BlueprintT>
+bool ValidateBlueprint(const BlueprintT& bp, uint32_t N, uint32_t P) {
+    if (bp.size() != P || bp.empty()) {
+        return false;
+    }
+    size_t expected_phases = bp[0].size();
+    for (size_t p = 0; p < bp.size(); ++p) {
+        if (bp[p].size() != expected_phases) {
+            return false;
+        }
+        for (size_t ph = 0; ph < bp[p].size(); ++ph) {
+            for (const auto& action : bp[p][ph]) {
+                if (action.srcRank >= N || action.dstRank >= N || action.sliceId >= N ||
+                    action.planeId != p || action.chunkNum == 0 || action.chunkId >= action.chunkNum) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// 单个阶段（生成/校验/评分）多次运行的统计
+struct StageStats {
+    vector<double> samples_us;
+    uint64_t alloc_count = 0;
+    uint64_t alloc_bytes = 0;
+
+    // 最近秩法求分位数
+    double Percentile(double q) const {
+        vector<double> sorted = samples_us;
+        sort(sorted.begin(), sorted.end());
+        size_t rank = static_cast<size_t>(ceil(q * sorted.size()));
+        return sorted[(rank == 0) ? 0 : rank - 1];
+    }
+
+    string ToJson() const {
+        double sum = 0.0;
+        for (double sample : samples_us) {
+            sum += sample;
+        }
+        size_t runs = samples_us.size();
+        ostringstream out;
+        out.precision(3);
+        out << fixed;
+        out << "{\"median_us\":" << Percentile(0.5) << ",\"p99_us\":" << Percentile(0.99)
+            << ",\"min_us\":" << Percentile(0.0) << ",\"mean_us\":" << sum / runs
+            << ",\"allocs\":" << alloc_count / runs << ",\"alloc_bytes\":" << alloc_bytes / runs << "}";
+        return out.str();
+    }
+};
+
+// 计时并统计一次调用中的分配
+template <typename Fn>
+void Measure(StageStats& stats, Fn fn) {
+    uint64_t count_before = ALLOC_COUNT.load(memory_order_relaxed);
+    uint64_t bytes_before = ALLOC_BYTES.load(memory_order_relaxed);
+    auto start = chrono::steady_clock::now();
+    fn();
+    auto end = chrono::steady_clock::now();
+    stats.alloc_count += ALLOC_COUNT.load(memory_order_relaxed) - count_before;
+    stats.alloc_bytes += ALLOC_BYTES.load(memory_order_relaxed) - bytes_before;
+    stats.samples_us.push_back(chrono::duration<double, micro>(end - start).count());
+}
+
+// 进程至今的峰值RSS（KB）
+long PeakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// 不构造Blueprint，按生成器计算action总数
+size_t CountActions(const Solution& solution, uint32_t N, uint32_t P, ScheduleAlgorithm algorithm) {
+    LazyBlueprint lazy = solution.ConstructLazyBluePrint(N, P, algorithm);
+    size_t total = 0;
+    for (uint32_t plane = 0; plane < lazy.PlaneNum(); ++plane) {
+        for (uint32_t phase = 0; phase < lazy.PhaseNum(); ++phase) {
+            total += lazy.PhaseActionNum(plane, phase);
+        }
+    }
+    return total;
+}
+
+struct BenchConfig {
+    uint32_t repeat = 5;
+    size_t max_actions = size_t(1) << 25;
+    uint32_t max_rank = 8192;
+    bool compact = false;
+    bool cache = false;
+    bool sweep = true;
+    bool sample = true;
+    ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO;
+};
+
+template <typename BlueprintT>
+void RunStages(Solution& solution, uint32_t N, uint32_t P, const BenchConfig& config,
+               StageStats& generate, StageStats& validate, StageStats& score, bool& valid, double& time) {
+    for (uint32_t run = 0; run < config.repeat; ++run) {
+        // 每次生成都使用新的Blueprint，分配统计包含存储本身
+        BlueprintT bp;
+        Measure(generate, [&]() { solution.ConstructBluePrint(N, P, bp, config.algorithm); });
+        Measure(validate, [&]() { valid = ValidateBlueprint(bp, N, P); });
+        Measure(score, [&]() { time = SCORER.CalculateCommunicationTime(bp, N, P); });
+    }
+}
+
+// 按中位数计的吞吐
+double ActionsPerNs(size_t actions, const StageStats& stats) {
+    double median_ns = stats.Percentile(0.5) * 1000.0;
+    return (median_ns > 0.0) ? actions / median_ns : 0.0;
+}
+
+void RunCase(Solution& solution, uint32_t N, uint32_t P, const char* source, const BenchConfig& config) {
+    // 实际生成的算法：不可行的算法与生成时一样退回MULTI_RING或RING
+    ScheduleOptions resolved_options;
+    ScheduleAlgorithm selected = solution.ResolveSchedule(N, P, config.algorithm, resolved_options);
+    selected = SolutionUtils::ResolveFeasibleAlgorithm(N, P, selected, resolved_options);
+    size_t actions = CountActions(solution, N, P, config.algorithm);
+
+    ostringstream line;
+    line << "{\"type\":\"case\",\"source\":\"" << source << "\",\"n\":" << N << ",\"p\":" << P
+         << ",\"algorithm\":\"" << ScheduleAlgorithmName(selected) << "\",\"actions\":" << actions;
+    if (actions > config.max_actions || (config.compact && N > COMPACT_MAX_VALUE)) {
+        line << ",\"skipped\":true}";
+        cout << line.str() << endl;
+        cerr << "  跳过 N=" << N << " P=" << P << "（" << actions << " 个action）" << endl;
+        return;
+    }
+
+    StageStats generate;
+    StageStats validate;
+    StageStats score;
+    bool valid = false;
+    double time = 0.0;
+    if (config.compact) {
+        RunStages<CompactBlueprint>(solution, N, P, config, generate, validate, score, valid, time);
+    } else {
+        RunStages<FlatBlueprint>(solution, N, P, config, generate, validate, score, valid, time);
+    }
+
+    // 缓存阶段：首次调用构造（或命中之前的形状），之后的每次调用都应命中且不分配内存
+    StageStats cache_hit;
+    if (config.cache) {
+        CACHE.GetOrConstruct(solution, N, P, config.algorithm);
+        for (uint32_t run = 0; run < config.repeat; ++run) {
+            Measure(cache_hit, [&]() { CACHE.GetOrConstruct(solution, N, P, config.algorithm); });
+        }
+    }
+
+    line.precision(6);
+    line << ",\"skipped\":false,\"repeat\":" << config.repeat << ",\"valid\":" << (valid ? "true" : "false")
+         << ",\"communication_time_ms\":" << time
+         << ",\"generate\":" << generate.ToJson() << ",\"validate\":" << validate.ToJson()
+         << ",\"score\":" << score.ToJson() << (config.cache ? ",\"cache_hit\":" + cache_hit.ToJson() : string()) << ",\"generate_actions_per_ns\":" << ActionsPerNs(actions, generate)
+         << ",\"score_actions_per_ns\":" << ActionsPerNs(actions, score) << ",\"peak_rss_kb\":" << PeakRssKb() << "}";
+    cout << line.str() << endl;
+    cerr << "  N=" << N << " P=" << P << " 生成中位数 " << generate.Percentile(0.5) / 1000.0 << " ms（"
+         << ActionsPerNs(actions, generate) << " action/ns），评分 " << ActionsPerNs(actions, score) << " action/ns"
+         << endl;
+}
+
+int main(int argc, char* argv[]) {
+    // --repeat <R>: 每个形状的重复次数（默认5）
+    // --max-actions <A>: action数超过A的形状只输出skipped（默认2^25）
+    // --max-rank <N>: 扫描的最大N（默认8192）
+    // --algo <auto|ring|halving|multiring|chunkedring|hierarchical>: 调度算法族
+    // --threads <T>: 生成Blueprint的线程数
+    // --compact: 使用CompactBlueprint（默认FlatBlueprint）
+    // --sweep-only / --sample-only: 只运行扫描 / sample.json中的形状
+    // --cache: 另计时BlueprintCache::GetOrConstruct的命中路径，结束时输出缓存统计
+    // --cache-capacity <MB>: 缓存容量（默认256MB），容量小于扫描的总内存时可观察LRU淘汰
+    // --simd <auto|scalar|avx2|avx512>: 限制生成与评分内核使用的指令集（见 simd_kernels.h），默认按CPU检测
+    BenchConfig config;
+    ScheduleOptions options;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) {
+            config.repeat = max<uint32_t>(1, static_cast<uint32_t>(stoul(argv[++i])));
+        } else if (arg == "--max-actions" && i + 1 < argc) {
+            config.max_actions = static_cast<size_t>(stoull(argv[++i]));
+        } else if (arg == "--max-rank" && i + 1 < argc) {
+            config.max_rank = static_cast<uint32_t>(stoul(argv[++i]));
+        } else if (arg == "--algo" && i + 1 < argc) {
+            if (!ParseScheduleAlgorithm(argv[++i], config.algorithm)) {
+                cerr << "未知算法: " << argv[i] << endl;
+                return 1;
+            }
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threadNum = static_cast<uint32_t>(stoul(argv[++i]));
+        } else if (arg == "--simd" && i + 1 < argc) {
+            string name = argv[++i];
+            SimdLevel level = DetectSimdLevel();
+            if (name != "auto" && !ParseSimdLevel(name, level)) {
+                cerr << "未知指令集: " << name << endl;
+                return 1;
+            }
+            SetSimdLevel(level);
+        } else if (arg == "--cache") {
+            config.cache = true;
+        } else if (arg == "--cache-capacity" && i + 1 < argc) {
+            CACHE.SetCapacity(static_cast<size_t>(stoull(argv[++i])) * 1024 * 1024);
+        } else if (arg == "--compact") {
+            config.compact = true;
+        } else if (arg == "--sweep-only") {
+            config.sample = false;
+        } else if (arg == "--sample-only") {
+            config.sweep = false;
+        }
+    }
+
+    Solution solution(COST_MODEL);
+    solution.SetScheduleOptions(options);
+
+    cout << "{\"type\":\"meta\",\"storage\":\"" << (config.compact ? "compact" : "flat")
+         << "\",\"algorithm\":\"" << ScheduleAlgorithmName(config.algorithm) << "\",\"threads\":"
+         << options.threadNum << ",\"simd\":\"" << SimdLevelName(ActiveSimdLevel()) << "\",\"repeat\":" << config.repeat << ",\"max_actions\":" << config.max_actions
+         << "}" << endl;
+
+    if (config.sample) {
+        cerr << "sample.json 形状:" << endl;
+        for (const auto& test_case : SAMPLE_CASES) {
+            RunCase(solution, test_case.first, test_case.second, "sample", config);
+        }
+    }
+    if (config.sweep) {
+        cerr << "扫描 N × P:" << endl;
+        for (uint32_t N = 4; N <= config.max_rank; N *= 2) {
+            for (uint32_t P = 2; P <= 64; P *= 2) {
+                RunCase(solution, N, P, "sweep", config);
+            }
+        }
+    }
+    if (config.cache) {
+        BlueprintCacheStats stats = CACHE.GetStats();
+        cout << "{\"type\":\"cache\",\"hits\":" << stats.hits << ",\"misses\":" << stats.misses
+             << ",\"evictions\":" << stats.evictions << ",\"entries\":" << stats.entryNum
+             << ",\"memory_bytes\":" << stats.memoryBytes << ",\"capacity_bytes\":" << CACHE.Capacity() << "}" << endl;
+        cerr << "缓存: 命中 " << stats.hits << "，未命中 " << stats.misses << "，淘汰 " << stats.evictions << "，"
+             << stats.entryNum << " 个Blueprint共 " << stats.memoryBytes << " 字节" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+//
+// Blueprint缓存实现
+//
+
+#include "blueprint_cache.h"
+#include "instrumentation.h"
+#include "schedule_tuner.h"
+#include "schedule_generators.h"
+
+using namespace std;
+
+BlueprintCacheKey BlueprintCache::MakeKey(const Solution& solution, uint32_t rankSize, uint32_t planeNum,
+                                          ScheduleAlgorithm algorithm)
+{
+    ScheduleOptions options = solution.GetScheduleOptions();
+    const CostModel& costModel = solution.GetCostModel();
+    SolutionUtils::ApplyPlaneWeights(costModel, planeNum, options);
+    SolutionUtils::ApplyNodeTopology(costModel, options);
+    TunedSchedule tuned;
+    const shared_ptr<const TuningTable>& table = solution.GetTuningTable();
+    if (algorithm == ScheduleAlgorithm::AUTO && table && !costModel.Heterogeneous() && !costModel.MultiNode() &&
+        table->Find(rankSize, planeNum, tuned)) {
+        tuned.ApplyTo(options);
+        algorithm = tuned.algorithm;
+    }
+    bool autoSelect = algorithm == ScheduleAlgorithm::AUTO;
+    bool ringBased = autoSelect || algorithm == ScheduleAlgorithm::MULTI_RING ||
+                     algorithm == ScheduleAlgorithm::CHUNKED_RING;
+    BlueprintCacheKey key;
+    key.rankSize = rankSize;
+    key.planeNum = planeNum;
+    key.algorithm = algorithm;
+    key.pipelineDepth = ((autoSelect || algorithm == ScheduleAlgorithm::CHUNKED_RING) && options.pipelineDepth > 1) ?
+                        options.pipelineDepth : 1;
+    key.ringNum = ringBased ? options.ringNum : 0;
+    key.parallelEdges = autoSelect && options.parallelEdges;
+    key.phaseLatency = autoSelect ? costModel.phaseLatency : 0.0;
+    key.dataSize = autoSelect ? costModel.dataSize : 0.0;
+    key.bandwidth = autoSelect ? costModel.bandwidth : 0.0;
+    if (autoSelect || algorithm == ScheduleAlgorithm::CHUNKED_RING) {
+        key.planeWeights = options.planeWeights;
+    }
+    key.ranksPerNode = (autoSelect || algorithm == ScheduleAlgorithm::HIERARCHICAL) ? options.ranksPerNode : 0;
+    key.interNodeLatency = autoSelect ? costModel.interNodeLatency : 0.0;
+    key.interNodeBandwidth = autoSelect ? costModel.interNodeBandwidth : 0.0;
+    if (autoSelect) {
+        key.planes = costModel.planes;
+    }
+    return key;
+}
+
+BlueprintCache::BlueprintPtr BlueprintCache::GetOrConstruct(Solution& solution, uint32_t rankSize,
+                                                            uint32_t planeNum, ScheduleAlgorithm algorithm)
+{
+    BlueprintCacheKey key = MakeKey(solution, rankSize, planeNum, algorithm);
+    BlueprintPtr cached = Find(key);
+    if (cached) {
+        return cached;
+    }
+
+    INSTRUMENT_SCOPE("BlueprintCache::Construct");
+    shared_ptr<FlatBlueprint> blueprint = make_shared<FlatBlueprint>();
+    solution.ConstructBluePrint(rankSize, planeNum, *blueprint, algorithm);
+    return Insert(key, blueprint);
+}
+
+BlueprintCache::BlueprintPtr BlueprintCache::Find(const BlueprintCacheKey& key)
+{
+    lock_guard<mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++stats_.misses;
+        INSTRUMENT_COUNT(CACHE_MISSES, 1);
+        return BlueprintPtr();
+    }
+    ++stats_.hits;
+    INSTRUMENT_COUNT(CACHE_HITS, 1);
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->blueprint;
+}
+
+BlueprintCache::BlueprintPtr BlueprintCache::Insert(const BlueprintCacheKey& key, BlueprintPtr blueprint)
+{
+    size_t memoryBytes = blueprint->MemoryBytes();
+    lock_guard<mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->blueprint;
+    }
+    if (memoryBytes > capacityBytes_) {
+        return blueprint;
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.blueprint = blueprint;
+    entry.memoryBytes = memoryBytes;
+    lru_.push_front(entry);
+    index_[key] = lru_.begin();
+    stats_.memoryBytes += memoryBytes;
+    EvictLocked();
+    return blueprint;
+}
+
+void BlueprintCache::EvictLocked()
+{
+    while (stats_.memoryBytes > capacityBytes_ && !lru_.empty()) {
+        const Entry& victim = lru_.back();
+        stats_.memoryBytes -= victim.memoryBytes;
+        index_.erase(victim.key);
+        lru_.pop_back();
+        ++stats_.evictions;
+    }
+}
+
+void BlueprintCache::SetCapacity(size_t capacityBytes)
+{
+    lock_guard<mutex> lock(mutex_);
+    capacityBytes_ = capacityBytes;
+    EvictLocked();
+}
+
+size_t BlueprintCache::Capacity() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return capacityBytes_;
+}
+
+void BlueprintCache::Clear()
+{
+    lock_guard<mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    stats_.memoryBytes = 0;
+}
+
+BlueprintCacheStats BlueprintCache::GetStats() const
+{
+    lock_guard<mutex> lock(mutex_);
+    BlueprintCacheStats stats = stats_;
+    stats.entryNum = lru_.size();
+    return stats;
+}
@@ -0,0 +1,122 @@
+//
+// Blueprint缓存：以 (rankSize, planeNum, algorithm, pipelineDepth) 为键保存构造好的FlatBlueprint，
+// 多次以相同参数启动时直接共享同一份不可变的Blueprint，命中时不分配内存。
+//
+
+#ifndef CPP_BLUEPRINT_CACHE_H
+#define CPP_BLUEPRINT_CACHE_H
+
+#include "solution.h"
+#include "flat_blueprint.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+constexpr const size_t DEFAULT_CACHE_CAPACITY_BYTES = 256ULL * 1024 * 1024;
+
+// algorithm为调用方请求的算法（可以为AUTO），命中路径不需要重新按代价模型选择算法；
+// AUTO的选择结果取决于代价模型，因此AUTO的键同时包含代价模型参数，其它算法这些字段记为0。
+// 非CHUNKED_RING/AUTO时pipelineDepth不影响结果，统一记为1；ringNum只影响MULTI_RING/CHUNKED_RING/AUTO，
+// 其它算法记为0；parallelEdges同样只影响AUTO。
+// AUTO命中solution的调优表时按表中的算法与参数记键，与直接请求该算法共享缓存。
+// 异构plane时planeWeights只影响CHUNKED_RING/AUTO，planes只影响AUTO，其它情况记为空；
+// ranksPerNode只影响HIERARCHICAL/AUTO，跨节点的时延与带宽只影响AUTO
+struct BlueprintCacheKey {
+    uint32_t rankSize;
+    uint32_t planeNum;
+    ScheduleAlgorithm algorithm;
+    uint32_t pipelineDepth;
+    uint32_t ringNum;
+    bool parallelEdges;
+    double phaseLatency;
+    double dataSize;
+    double bandwidth;
+    std::vector<uint32_t> planeWeights;
+    std::vector<PlaneProfile> planes;
+    uint32_t ranksPerNode;
+    double interNodeLatency;
+    double interNodeBandwidth;
+
+    bool operator==(const BlueprintCacheKey& other) const
+    {
+        return rankSize == other.rankSize && planeNum == other.planeNum && algorithm == other.algorithm &&
+               pipelineDepth == other.pipelineDepth && ringNum == other.ringNum &&
+               parallelEdges == other.parallelEdges &&
+               phaseLatency == other.phaseLatency &&
+               dataSize == other.dataSize && bandwidth == other.bandwidth &&
+               planeWeights == other.planeWeights && planes == other.planes &&
+               ranksPerNode == other.ranksPerNode && interNodeLatency == other.interNodeLatency &&
+               interNodeBandwidth == other.interNodeBandwidth;
+    }
+};
+
+struct BlueprintCacheKeyHash {
+    size_t operator()(const BlueprintCacheKey& key) const
+    {
+        uint64_t value = (static_cast<uint64_t>(key.rankSize) << 32) ^ (static_cast<uint64_t>(key.planeNum) << 8) ^
+                         (static_cast<uint64_t>(key.pipelineDepth) << 16) ^
+                         (static_cast<uint64_t>(key.ringNum) << 24) ^ static_cast<uint64_t>(key.algorithm);
+        return static_cast<size_t>(value * 0x9E3779B97F4A7C15ULL);
+    }
+};
+
+struct BlueprintCacheStats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t evictions{0};
+    size_t entryNum{0};
+    size_t memoryBytes{0};  // 缓存中所有Blueprint的MemoryBytes之和
+};
+
+// 线程安全；总内存超过capacityBytes时按LRU淘汰。
+// 被淘汰的Blueprint在外部仍持有shared_ptr期间保持有效
+class BlueprintCache {
+public:
+    using BlueprintPtr = std::shared_ptr<const FlatBlueprint>;
+
+    explicit BlueprintCache(size_t capacityBytes = DEFAULT_CACHE_CAPACITY_BYTES) : capacityBytes_(capacityBytes) {}
+    BlueprintCache(const BlueprintCache&) = delete;
+    BlueprintCache& operator=(const BlueprintCache&) = delete;
+
+    // 命中时返回缓存的Blueprint；未命中时用solution构造并插入。
+    // 构造在锁外进行，并发的相同未命中可能各自构造一次，最终共享先插入的那份
+    BlueprintPtr GetOrConstruct(Solution& solution, uint32_t rankSize, uint32_t planeNum,
+                                ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO);
+
+    // 只查找不构造，未命中返回空指针（计入misses）
+    BlueprintPtr Find(const BlueprintCacheKey& key);
+    // 插入已构造的Blueprint，键已存在时保留原有的并返回它；单个Blueprint超过容量时不缓存
+    BlueprintPtr Insert(const BlueprintCacheKey& key, BlueprintPtr blueprint);
+
+    // 与GetOrConstruct一致的键，只读取solution的选项与代价模型，不分配内存
+    static BlueprintCacheKey MakeKey(const Solution& solution, uint32_t rankSize, uint32_t planeNum,
+                                     ScheduleAlgorithm algorithm);
+
+    void SetCapacity(size_t capacityBytes);
+    size_t Capacity() const;
+    void Clear();
+    BlueprintCacheStats GetStats() const;
+
+private:
+    struct Entry {
+        BlueprintCacheKey key;
+        BlueprintPtr blueprint;
+        size_t memoryBytes;
+    };
+    using EntryList = std::list<Entry>;
+
+    // 调用方需持有mutex_
+    void EvictLocked();
+
+    mutable std::mutex mutex_;
+    size_t capacityBytes_;
+    EntryList lru_;  // 表头为最近使用
+    std::unordered_map<BlueprintCacheKey, EntryList::iterator, BlueprintCacheKeyHash> index_;
+    BlueprintCacheStats stats_;
+};
+
+#endif // CPP_BLUEPRINT_CACHE_H
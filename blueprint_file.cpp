@@ -0,0 +1,282 @@
+//
+// Blueprint二进制文件的写入与mmap读取
+//
+
+#include "blueprint_file.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static_assert(sizeof(BlueprintFileHeader) == 64, "BlueprintFileHeader must stay 64 bytes");
+
+namespace {
+
+// 各段在文件中的起始位置
+struct FileLayout {
+    uint64_t planeOffsets;
+    uint64_t phaseOffsets;
+    uint64_t columns[5];  // src, dst, slice, chunk, chunkNum
+    uint64_t fileSize;
+};
+
+uint64_t AlignUp(uint64_t value)
+{
+    return (value + 7) & ~static_cast<uint64_t>(7);
+}
+
+FileLayout CalcLayout(uint64_t planeNum, uint64_t totalPhaseNum, uint64_t totalActionNum, bool chunked)
+{
+    FileLayout layout;
+    layout.planeOffsets = sizeof(BlueprintFileHeader);
+    layout.phaseOffsets = layout.planeOffsets + planeNum * sizeof(uint64_t);
+    uint64_t pos = layout.phaseOffsets + totalPhaseNum * sizeof(uint64_t);
+    size_t columnNum = chunked ? 5 : 3;
+    for (size_t column = 0; column < 5; ++column) {
+        layout.columns[column] = pos;
+        if (column < columnNum) {
+            pos = AlignUp(pos + totalActionNum * sizeof(uint16_t));
+        }
+    }
+    layout.fileSize = pos;
+    return layout;
+}
+
+void SetError(string* error, const string& message)
+{
+    if (error != nullptr) {
+        *error = message;
+    }
+}
+
+void WritePadding(ofstream& file)
+{
+    static const char ZEROS[8] = {0};
+    uint64_t pos = static_cast<uint64_t>(file.tellp());
+    file.write(ZEROS, static_cast<streamsize>(AlignUp(pos) - pos));
+}
+
+} // namespace
+
+bool WriteBlueprintFile(const string& path, const CompactBlueprint& blueprint, uint32_t rankSize,
+                        ScheduleAlgorithm algorithm, string* error)
+{
+    bool chunked = false;
+    uint32_t phaseNum = 0;
+    for (size_t planeId = 0; planeId < blueprint.size(); ++planeId) {
+        size_t planePhaseNum = blueprint.PhaseNum(planeId);
+        phaseNum = (planePhaseNum > phaseNum) ? static_cast<uint32_t>(planePhaseNum) : phaseNum;
+        if (planePhaseNum > 0 && blueprint.GetPhase(planeId, 0).ChunkData() != nullptr) {
+            chunked = true;
+        }
+    }
+
+    BlueprintFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BLUEPRINT_FILE_MAGIC, sizeof(header.magic));
+    header.version = BLUEPRINT_FILE_VERSION;
+    header.headerSize = sizeof(BlueprintFileHeader);
+    header.rankSize = rankSize;
+    header.planeNum = static_cast<uint32_t>(blueprint.size());
+    header.phaseNum = phaseNum;
+    header.algorithm = static_cast<uint32_t>(algorithm);
+    header.flags = chunked ? BLUEPRINT_FILE_CHUNKED : 0;
+    header.totalPhaseNum = blueprint.TotalPhaseNum();
+    header.totalActionNum = blueprint.TotalActionNum();
+    header.fileSize = CalcLayout(header.planeNum, header.totalPhaseNum, header.totalActionNum, chunked).fileSize;
+
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        SetError(error, "无法打开文件: " + path);
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // 偏移表
+    vector<uint64_t> offsets;
+    offsets.reserve(blueprint.TotalPhaseNum());
+    uint64_t globalPhaseId = 0;
+    for (size_t planeId = 0; planeId < blueprint.size(); ++planeId) {
+        offsets.push_back(globalPhaseId);
+        globalPhaseId += blueprint.PhaseNum(planeId);
+    }
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    offsets.clear();
+    uint64_t actionId = 0;
+    for (const auto& schedule : blueprint) {
+        for (const auto& phase : schedule) {
+            offsets.push_back(actionId);
+            actionId += phase.size();
+        }
+    }
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+
+    // 各列依次写出，列内按 plane -> phase 顺序拼接各phase的区段
+    size_t columnNum = chunked ? 5 : 3;
+    for (size_t column = 0; column < columnNum; ++column) {
+        for (const auto& schedule : blueprint) {
+            for (const auto& phase : schedule) {
+                const uint16_t* columns[5] = {
+                    phase.SrcData(), phase.DstData(), phase.SliceData(), phase.ChunkData(), phase.ChunkNumData()
+                };
+                file.write(reinterpret_cast<const char*>(columns[column]), phase.size() * sizeof(uint16_t));
+            }
+        }
+        WritePadding(file);
+    }
+
+    if (!file.good()) {
+        SetError(error, "写入文件失败: " + path);
+        return false;
+    }
+    return true;
+}
+
+bool WriteBlueprintFile(const string& path, const FlatBlueprint& blueprint, uint32_t rankSize,
+                        ScheduleAlgorithm algorithm, string* error)
+{
+    CompactBlueprint compact;
+    if (!compact.Assign(blueprint)) {
+        SetError(error, "Blueprint中存在无法用16位表示的值");
+        return false;
+    }
+    return WriteBlueprintFile(path, compact, rankSize, algorithm, error);
+}
+
+MappedBlueprint::~MappedBlueprint()
+{
+    Close();
+}
+
+MappedBlueprint::MappedBlueprint(MappedBlueprint&& other)
+{
+    Swap(other);
+}
+
+MappedBlueprint& MappedBlueprint::operator=(MappedBlueprint&& other)
+{
+    if (this != &other) {
+        Close();
+        Swap(other);
+    }
+    return *this;
+}
+
+void MappedBlueprint::Swap(MappedBlueprint& other)
+{
+    swap(base_, other.base_);
+    swap(mappedBytes_, other.mappedBytes_);
+    swap(header_, other.header_);
+    swap(planeOffsets_, other.planeOffsets_);
+    swap(phaseOffsets_, other.phaseOffsets_);
+    swap(src_, other.src_);
+    swap(dst_, other.dst_);
+    swap(slice_, other.slice_);
+    swap(chunk_, other.chunk_);
+    swap(chunkNum_, other.chunkNum_);
+    swap(planeNum_, other.planeNum_);
+    swap(totalPhaseNum_, other.totalPhaseNum_);
+    swap(totalActionNum_, other.totalActionNum_);
+}
+
+void MappedBlueprint::Close()
+{
+    if (base_ != nullptr) {
+        munmap(base_, mappedBytes_);
+    }
+    base_ = nullptr;
+    mappedBytes_ = 0;
+    header_ = nullptr;
+    planeOffsets_ = nullptr;
+    phaseOffsets_ = nullptr;
+    src_ = nullptr;
+    dst_ = nullptr;
+    slice_ = nullptr;
+    chunk_ = nullptr;
+    chunkNum_ = nullptr;
+    planeNum_ = 0;
+    totalPhaseNum_ = 0;
+    totalActionNum_ = 0;
+}
+
+bool MappedBlueprint::Open(const string& path, string* error)
+{
+    Close();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        SetError(error, "无法打开文件: " + path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BlueprintFileHeader)) {
+        close(fd);
+        SetError(error, "文件过小: " + path);
+        return false;
+    }
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        SetError(error, "mmap失败: " + path);
+        return false;
+    }
+
+    const BlueprintFileHeader* header = static_cast<const BlueprintFileHeader*>(base);
+    string reason;
+    // 先限制计数的范围，避免损坏的文件头使布局计算溢出
+    bool countsInRange = header->totalPhaseNum <= fileSize && header->totalActionNum <= fileSize;
+    FileLayout layout = CalcLayout(header->planeNum, countsInRange ? header->totalPhaseNum : 0,
+                                   countsInRange ? header->totalActionNum : 0,
+                                   (header->flags & BLUEPRINT_FILE_CHUNKED) != 0);
+    if (memcmp(header->magic, BLUEPRINT_FILE_MAGIC, sizeof(header->magic)) != 0) {
+        reason = "文件标识不符";
+    } else if (header->version != BLUEPRINT_FILE_VERSION || header->headerSize != sizeof(BlueprintFileHeader)) {
+        reason = "不支持的文件版本";
+    } else if (!countsInRange || header->fileSize != fileSize || layout.fileSize != fileSize) {
+        reason = "文件长度与文件头不符";
+    }
+    if (!reason.empty()) {
+        munmap(base, fileSize);
+        SetError(error, reason + ": " + path);
+        return false;
+    }
+
+    const char* bytes = static_cast<const char*>(base);
+    base_ = base;
+    mappedBytes_ = fileSize;
+    header_ = header;
+    planeNum_ = header->planeNum;
+    totalPhaseNum_ = header->totalPhaseNum;
+    totalActionNum_ = header->totalActionNum;
+    planeOffsets_ = reinterpret_cast<const uint64_t*>(bytes + layout.planeOffsets);
+    phaseOffsets_ = reinterpret_cast<const uint64_t*>(bytes + layout.phaseOffsets);
+    src_ = reinterpret_cast<const uint16_t*>(bytes + layout.columns[0]);
+    dst_ = reinterpret_cast<const uint16_t*>(bytes + layout.columns[1]);
+    slice_ = reinterpret_cast<const uint16_t*>(bytes + layout.columns[2]);
+    if ((header->flags & BLUEPRINT_FILE_CHUNKED) != 0) {
+        chunk_ = reinterpret_cast<const uint16_t*>(bytes + layout.columns[3]);
+        chunkNum_ = reinterpret_cast<const uint16_t*>(bytes + layout.columns[4]);
+    }
+
+    // 偏移表必须单调且不越界，否则访问时会读到映射区之外
+    bool valid = true;
+    for (size_t planeId = 0; planeId < planeNum_ && valid; ++planeId) {
+        valid = planeOffsets_[planeId] <= totalPhaseNum_ && (planeId == 0 ? planeOffsets_[0] == 0 :
+                                                             planeOffsets_[planeId - 1] <= planeOffsets_[planeId]);
+    }
+    for (size_t phaseId = 0; phaseId < totalPhaseNum_ && valid; ++phaseId) {
+        valid = phaseOffsets_[phaseId] <= totalActionNum_ && (phaseId == 0 ? phaseOffsets_[0] == 0 :
+                                                              phaseOffsets_[phaseId - 1] <= phaseOffsets_[phaseId]);
+    }
+    if (!valid) {
+        Close();
+        SetError(error, "偏移表损坏: " + path);
+        return false;
+    }
+    return true;
+}
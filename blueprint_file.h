@@ -0,0 +1,157 @@
+//
+// Blueprint二进制文件格式：定长文件头 + 偏移表 + 按列存放的16位action字段，
+// 读取时直接mmap整个文件，以零拷贝的CompactPhaseView访问，接口与Blueprint一致。
+//
+// 文件布局（主机字节序，各段起始按8字节对齐）：
+//   BlueprintFileHeader
+//   uint64 planeOffsets[planeNum]        第p个plane的首个phase的全局编号
+//   uint64 phaseOffsets[totalPhaseNum]   第g个phase的首个action的全局编号
+//   uint16 src[totalActionNum]
+//   uint16 dst[totalActionNum]
+//   uint16 slice[totalActionNum]
+//   uint16 chunk[totalActionNum]         仅当flags含BLUEPRINT_FILE_CHUNKED
+//   uint16 chunkNum[totalActionNum]      仅当flags含BLUEPRINT_FILE_CHUNKED
+//
+
+#ifndef CPP_BLUEPRINT_FILE_H
+#define CPP_BLUEPRINT_FILE_H
+
+#include "solution.h"
+#include "flat_blueprint.h"
+#include "compact_blueprint.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+constexpr const char BLUEPRINT_FILE_MAGIC[8] = {'B', 'L', 'U', 'E', 'P', 'R', 'N', 'T'};
+constexpr const uint32_t BLUEPRINT_FILE_VERSION = 1;
+constexpr const uint32_t BLUEPRINT_FILE_CHUNKED = 1u << 0;
+
+struct BlueprintFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;  // sizeof(BlueprintFileHeader)，便于以后扩展
+    uint32_t rankSize;    // N
+    uint32_t planeNum;    // P
+    uint32_t phaseNum;    // K：各plane中最大的phase数
+    uint32_t algorithm;   // 生成该Blueprint的ScheduleAlgorithm，未知时为AUTO
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t totalPhaseNum;
+    uint64_t totalActionNum;
+    uint64_t fileSize;
+};
+
+// 写入文件，失败时返回false并在error中给出原因
+bool WriteBlueprintFile(const std::string& path, const CompactBlueprint& blueprint, uint32_t rankSize,
+                        ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO, std::string* error = nullptr);
+// FlatBlueprint先转换为紧凑列，存在无法用16位表示的值时返回false
+bool WriteBlueprintFile(const std::string& path, const FlatBlueprint& blueprint, uint32_t rankSize,
+                        ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO, std::string* error = nullptr);
+
+class MappedBlueprint;
+
+class MappedScheduleView {
+public:
+    using const_iterator = IndexIterator<MappedScheduleView, CompactPhaseView>;
+
+    MappedScheduleView(const MappedBlueprint* blueprint, uint32_t planeId) : blueprint_(blueprint), planeId_(planeId) {}
+
+    uint32_t PlaneId() const { return planeId_; }
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    CompactPhaseView operator[](size_t phaseId) const;
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+private:
+    const MappedBlueprint* blueprint_;
+    uint32_t planeId_;
+};
+
+// 只读映射的Blueprint文件，打开时只校验文件头与偏移表，不拷贝action数据。
+// 对象可移动不可复制，析构时解除映射
+class MappedBlueprint {
+public:
+    using const_iterator = IndexIterator<MappedBlueprint, MappedScheduleView>;
+
+    MappedBlueprint() = default;
+    ~MappedBlueprint();
+    MappedBlueprint(MappedBlueprint&& other);
+    MappedBlueprint& operator=(MappedBlueprint&& other);
+    MappedBlueprint(const MappedBlueprint&) = delete;
+    MappedBlueprint& operator=(const MappedBlueprint&) = delete;
+
+    // 失败时返回false并在error中给出原因，对象保持为空
+    bool Open(const std::string& path, std::string* error = nullptr);
+    void Close();
+    bool IsOpen() const { return base_ != nullptr; }
+
+    // 以下访问接口要求IsOpen()
+    const BlueprintFileHeader& Header() const { return *header_; }
+    uint32_t RankSize() const { return header_->rankSize; }
+    ScheduleAlgorithm Algorithm() const { return static_cast<ScheduleAlgorithm>(header_->algorithm); }
+    bool Chunked() const { return chunk_ != nullptr; }
+
+    size_t size() const { return planeNum_; }
+    bool empty() const { return size() == 0; }
+    MappedScheduleView operator[](size_t planeId) const
+    {
+        return MappedScheduleView(this, static_cast<uint32_t>(planeId));
+    }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    size_t PhaseNum(size_t planeId) const { return PlaneEnd(planeId) - planeOffsets_[planeId]; }
+    CompactPhaseView GetPhase(size_t planeId, size_t phaseId) const
+    {
+        size_t globalPhaseId = planeOffsets_[planeId] + phaseId;
+        size_t begin = phaseOffsets_[globalPhaseId];
+        return CompactPhaseView(src_ + begin, dst_ + begin, slice_ + begin,
+                                (chunk_ == nullptr) ? nullptr : chunk_ + begin,
+                                (chunkNum_ == nullptr) ? nullptr : chunkNum_ + begin,
+                                PhaseEnd(globalPhaseId) - begin, static_cast<uint32_t>(planeId));
+    }
+
+    size_t TotalPhaseNum() const { return totalPhaseNum_; }
+    size_t TotalActionNum() const { return totalActionNum_; }
+    size_t MappedBytes() const { return mappedBytes_; }
+
+private:
+    void Swap(MappedBlueprint& other);
+
+    size_t PlaneEnd(size_t planeId) const
+    {
+        return (planeId + 1 < planeNum_) ? planeOffsets_[planeId + 1] : totalPhaseNum_;
+    }
+    size_t PhaseEnd(size_t globalPhaseId) const
+    {
+        return (globalPhaseId + 1 < totalPhaseNum_) ? phaseOffsets_[globalPhaseId + 1] : totalActionNum_;
+    }
+
+    void* base_{nullptr};
+    size_t mappedBytes_{0};
+    const BlueprintFileHeader* header_{nullptr};
+    const uint64_t* planeOffsets_{nullptr};
+    const uint64_t* phaseOffsets_{nullptr};
+    const uint16_t* src_{nullptr};
+    const uint16_t* dst_{nullptr};
+    const uint16_t* slice_{nullptr};
+    const uint16_t* chunk_{nullptr};
+    const uint16_t* chunkNum_{nullptr};
+    size_t planeNum_{0};
+    size_t totalPhaseNum_{0};
+    size_t totalActionNum_{0};
+};
+
+inline size_t MappedScheduleView::size() const
+{
+    return blueprint_->PhaseNum(planeId_);
+}
+
+inline CompactPhaseView MappedScheduleView::operator[](size_t phaseId) const
+{
+    return blueprint_->GetPhase(planeId_, phaseId);
+}
+
+#endif // CPP_BLUEPRINT_FILE_H
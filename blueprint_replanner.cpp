@@ -0,0 +1,526 @@
+//
+// 故障后的增量重排实现
+//
+
+#include "blueprint_replanner.h"
+#include "schedule_generators.h"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+using namespace SolutionUtils;
+
+namespace {
+
+void SetError(string* error, const string& message)
+{
+    if (error != nullptr) {
+        *error = message;
+    }
+}
+
+// value与modulus互质，返回 value^-1 (mod modulus)
+uint32_t ModularInverse(uint32_t value, uint32_t modulus)
+{
+    int64_t a = value % modulus;
+    int64_t b = modulus;
+    int64_t x = 1;
+    int64_t y = 0;
+    while (b != 0) {
+        int64_t q = a / b;
+        int64_t t = a - q * b;
+        a = b;
+        b = t;
+        t = x - q * y;
+        x = y;
+        y = t;
+    }
+    x %= static_cast<int64_t>(modulus);
+    return static_cast<uint32_t>((x < 0) ? x + modulus : x);
+}
+
+uint32_t MulMod(uint32_t a, uint32_t b, uint32_t modulus)
+{
+    return static_cast<uint32_t>(static_cast<uint64_t>(a) * b % modulus);
+}
+
+// dst - src (mod N)，两者都小于N，不做除法
+inline uint32_t RankDelta(uint32_t srcRank, uint32_t dstRank, uint32_t rankSize)
+{
+    return (dstRank >= srcRank) ? dstRank - srcRank : dstRank + rankSize - srcRank;
+}
+
+} // namespace
+
+const char* ReplanModeName(ReplanMode mode)
+{
+    switch (mode) {
+        case ReplanMode::UNCHANGED:
+            return "unchanged";
+        case ReplanMode::MOVED:
+            return "moved";
+        case ReplanMode::RESTRIDED:
+            return "restrided";
+    }
+    return "unknown";
+}
+
+uint64_t BlueprintReplanner::LinkKey(uint32_t planeId, uint32_t u, uint32_t v)
+{
+    return (static_cast<uint64_t>(planeId & 0xFFFF) << 48) | (static_cast<uint64_t>(min(u, v)) << 24) | max(u, v);
+}
+
+bool BlueprintReplanner::LinkDead(uint32_t planeId, uint32_t u, uint32_t v) const
+{
+    return !deadLinks_.empty() &&
+           (deadLinks_.count(LinkKey(ALL_PLANES, u, v)) != 0 || deadLinks_.count(LinkKey(planeId, u, v)) != 0);
+}
+
+uint32_t BlueprintReplanner::StrideClass(uint32_t delta) const
+{
+    return min(delta, rankSize_ - delta);
+}
+
+bool BlueprintReplanner::ClassDead(uint32_t planeId, uint32_t stride) const
+{
+    for (const LinkFailure& link : links_) {
+        if ((link.planeId == ALL_PLANES || link.planeId == planeId) &&
+            StrideClass(RankDelta(link.u, link.v, rankSize_)) == stride) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t BlueprintReplanner::MergeDelta(uint32_t delta, uint32_t actionDelta, uint32_t rankSize)
+{
+    if (delta == 0) {
+        return (actionDelta != 0 && Gcd(actionDelta, rankSize) == 1) ? actionDelta : NOT_RING;
+    }
+    return (delta == actionDelta) ? delta : NOT_RING;
+}
+
+void BlueprintReplanner::InspectPlane(const Blueprint& bp, uint32_t planeId)
+{
+    uint32_t delta = 0;
+    size_t actionNum = 0;
+    for (const Phase& phase : bp[planeId]) {
+        actionNum += phase.size();
+        for (size_t i = 0; i < phase.size() && delta != NOT_RING; ++i) {
+            delta = MergeDelta(delta, RankDelta(phase[i].srcRank, phase[i].dstRank, rankSize_), rankSize_);
+        }
+    }
+    delta_[planeId] = delta;
+    actionNum_[planeId] = actionNum;
+}
+
+uint32_t BlueprintReplanner::PairDegree(const Blueprint& bp)
+{
+    // ring流的通信对由步长决定：步长类k占2个端口，N为偶数且k = N/2时占1个
+    bool allRing = true;
+    vector<uint32_t> strides;
+    for (uint32_t delta : delta_) {
+        if (delta == NOT_RING) {
+            allRing = false;
+            break;
+        }
+        if (delta != 0 && find(strides.begin(), strides.end(), StrideClass(delta)) == strides.end()) {
+            strides.push_back(StrideClass(delta));
+        }
+    }
+    if (allRing) {
+        uint32_t degree = 0;
+        for (uint32_t stride : strides) {
+            degree += (2 * stride == rankSize_) ? 1 : 2;
+        }
+        return degree;
+    }
+
+    pairs_.Reset(rankSize_);
+    degree_.assign(rankSize_, 0);
+    for (const Schedule& schedule : bp) {
+        for (const Phase& phase : schedule) {
+            for (const Action& action : phase) {
+                if (action.srcRank == action.dstRank) {
+                    continue;
+                }
+                uint32_t& seen = pairs_.At(min(action.srcRank, action.dstRank), max(action.srcRank, action.dstRank));
+                if (seen == 0) {
+                    seen = 1;
+                    ++degree_[action.srcRank];
+                    ++degree_[action.dstRank];
+                }
+            }
+        }
+    }
+    return degree_.empty() ? 0 : *max_element(degree_.begin(), degree_.end());
+}
+
+void BlueprintReplanner::Prepare(const Blueprint& bp, uint32_t rankSize)
+{
+    uint32_t planeNum = static_cast<uint32_t>(bp.size());
+    rankSize_ = rankSize;
+    delta_.assign(planeNum, 0);
+    actionNum_.assign(planeNum, 0);
+    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+        InspectPlane(bp, planeId);
+    }
+    rankDegree_ = PairDegree(bp);
+    prepared_ = &bp;
+}
+
+bool BlueprintReplanner::IsPrepared(const Blueprint& bp, uint32_t rankSize) const
+{
+    if (prepared_ != &bp || rankSize_ != rankSize || actionNum_.size() != bp.size()) {
+        return false;
+    }
+    // 只核对各plane的action数（读phase的size，不读action）
+    for (size_t planeId = 0; planeId < bp.size(); ++planeId) {
+        size_t actionNum = 0;
+        for (const Phase& phase : bp[planeId]) {
+            actionNum += phase.size();
+        }
+        if (actionNum != actionNum_[planeId]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BlueprintReplanner::CountOrphans(const Blueprint& bp)
+{
+    uint32_t planeNum = static_cast<uint32_t>(bp.size());
+    orphanNum_.assign(planeNum, 0);
+    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+        if (!alive_[planeId]) {
+            orphanNum_[planeId] = actionNum_[planeId];
+            continue;
+        }
+        // ring流只在其步长类上有失效链路时才可能受影响
+        uint32_t delta = delta_[planeId];
+        if (links_.empty() || delta == 0 || (delta != NOT_RING && !ClassDead(planeId, StrideClass(delta)))) {
+            continue;
+        }
+        for (const Phase& phase : bp[planeId]) {
+            for (const Action& action : phase) {
+                orphanNum_[planeId] += LinkDead(planeId, action.srcRank, action.dstRank) ? 1 : 0;
+            }
+        }
+    }
+}
+
+bool BlueprintReplanner::CanMove(const Blueprint& bp) const
+{
+    uint32_t planeNum = static_cast<uint32_t>(bp.size());
+    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+        if (orphanNum_[planeId] == 0) {
+            continue;
+        }
+        // 没有失效链路时任一其它存活plane都可以接收
+        if (deadLinks_.empty()) {
+            if (alivePlaneNum_ > (alive_[planeId] ? 1u : 0u)) {
+                continue;
+            }
+            return false;
+        }
+        for (const Phase& phase : bp[planeId]) {
+            for (const Action& action : phase) {
+                if (alive_[planeId] && !LinkDead(planeId, action.srcRank, action.dstRank)) {
+                    continue;
+                }
+                bool found = false;
+                for (uint32_t target = 0; target < planeNum && !found; ++target) {
+                    found = target != planeId && alive_[target] &&
+                            !LinkDead(target, action.srcRank, action.dstRank);
+                }
+                if (!found) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void BlueprintReplanner::Move(Blueprint& bp, ReplanStats& stats)
+{
+    uint32_t planeNum = static_cast<uint32_t>(bp.size());
+    vector<size_t> load(planeNum, 0);
+    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+        if (orphanNum_[planeId] == 0) {
+            continue;
+        }
+        rebuilt_[planeId] = 1;
+        for (size_t phaseId = 0; phaseId < bp[planeId].size(); ++phaseId) {
+            Phase& phase = bp[planeId][phaseId];
+            size_t total = phase.size();
+            for (uint32_t target = 0; target < planeNum; ++target) {
+                load[target] = bp[target][phaseId].size();
+                total += (target != planeId && alive_[target]) ? load[target] : 0;
+            }
+            // 整个plane失效时按均分后的action数预留，避免逐个push_back时反复扩容
+            if (!alive_[planeId]) {
+                size_t share = total / alivePlaneNum_ + 1;
+                for (uint32_t target = 0; target < planeNum; ++target) {
+                    if (alive_[target] && load[target] < share) {
+                        bp[target][phaseId].reserve(share);
+                    }
+                }
+            }
+            size_t kept = 0;
+            for (size_t i = 0; i < phase.size(); ++i) {
+                Action action = phase[i];
+                if (alive_[planeId] && !LinkDead(planeId, action.srcRank, action.dstRank)) {
+                    phase[kept++] = action;
+                    continue;
+                }
+                // 同一phase中链路完好、action最少的存活plane
+                uint32_t best = planeNum;
+                for (uint32_t target = 0; target < planeNum; ++target) {
+                    if (target == planeId || !alive_[target] || (best != planeNum && load[target] >= load[best]) ||
+                        LinkDead(target, action.srcRank, action.dstRank)) {
+                        continue;
+                    }
+                    best = target;
+                }
+                action.planeId = best;
+                bp[best][phaseId].push_back(action);
+                ++load[best];
+                rebuilt_[best] = 1;
+                delta_[best] = MergeDelta(delta_[best], RankDelta(action.srcRank, action.dstRank, rankSize_), rankSize_);
+                ++actionNum_[best];
+                --actionNum_[planeId];
+                ++stats.movedActionNum;
+            }
+            phase.resize(kept);
+        }
+        // 剩下的action是原ring流的子集，步长不变
+        if (actionNum_[planeId] == 0) {
+            delta_[planeId] = 0;
+        }
+    }
+}
+
+bool BlueprintReplanner::Restride(Blueprint& bp, ReplanStats& stats, string* error)
+{
+    uint32_t planeNum = static_cast<uint32_t>(bp.size());
+
+    // 各步长类的完好承载plane数
+    vector<uint32_t> strides;
+    vector<uint32_t> supporters;
+    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+        if (delta_[planeId] == 0) {
+            continue;
+        }
+        uint32_t stride = StrideClass(delta_[planeId]);
+        size_t index = find(strides.begin(), strides.end(), stride) - strides.begin();
+        if (index == strides.size()) {
+            strides.push_back(stride);
+            supporters.push_back(0);
+        }
+        if (alive_[planeId] && !ClassDead(planeId, stride)) {
+            ++supporters[index];
+        }
+    }
+
+    // 承载plane多的步长优先，在度数预算内保留
+    vector<size_t> order(strides.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return supporters[a] > supporters[b]; });
+    vector<uint32_t> keptStrides;
+    uint32_t degree = 0;
+    for (size_t index : order) {
+        uint32_t cost = (2 * strides[index] == rankSize_) ? 1 : 2;
+        if (supporters[index] > 0 && degree + cost <= alivePlaneNum_) {
+            keptStrides.push_back(strides[index]);
+            degree += cost;
+        }
+    }
+    if (keptStrides.empty()) {
+        SetError(error, "存活plane的度数预算内没有可用的ring步长");
+        return false;
+    }
+    auto isKept = [&](uint32_t stride) {
+        return find(keptStrides.begin(), keptStrides.end(), stride) != keptStrides.end();
+    };
+
+    // 保留的各有向步长上的ring流数，换步长时取最少者
+    vector<uint32_t> slots;
+    for (uint32_t stride : keptStrides) {
+        slots.push_back(stride);
+        if (2 * stride != rankSize_) {
+            slots.push_back(rankSize_ - stride);
+        }
+    }
+    vector<uint32_t> slotLoad(slots.size(), 0);
+    vector<uint8_t> staying(planeNum, 0);
+    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+        uint32_t delta = delta_[planeId];
+        if (delta == 0 || !alive_[planeId] || !isKept(StrideClass(delta)) || ClassDead(planeId, StrideClass(delta))) {
+            continue;
+        }
+        staying[planeId] = 1;
+        ++slotLoad[find(slots.begin(), slots.end(), delta) - slots.begin()];
+    }
+
+    const vector<uint32_t> original = delta_;  // 目标plane接收后delta_可能改变
+    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+        uint32_t delta = delta_[planeId];
+        if (delta == 0 || staying[planeId]) {
+            continue;
+        }
+        // 负载相同时保持方向（d <= N/2 与 d > N/2）
+        bool forward = 2 * delta <= rankSize_;
+        size_t slot = 0;
+        for (size_t i = 1; i < slots.size(); ++i) {
+            bool sameDirection = (2 * slots[i] <= rankSize_) == forward;
+            bool bestSameDirection = (2 * slots[slot] <= rankSize_) == forward;
+            if (slotLoad[i] < slotLoad[slot] || (slotLoad[i] == slotLoad[slot] && sameDirection && !bestSameDirection)) {
+                slot = i;
+            }
+        }
+        ++slotLoad[slot];
+        uint32_t newDelta = slots[slot];
+        uint32_t newStride = StrideClass(newDelta);
+
+        // 存活且新步长上没有失效链路的plane原地换步长，否则交给该步长上action最少的完好plane，
+        // 优先同方向的plane，使其仍是ring流
+        uint32_t target = planeId;
+        if (!alive_[planeId] || ClassDead(planeId, newStride)) {
+            target = planeNum;
+            for (uint32_t candidate = 0; candidate < planeNum; ++candidate) {
+                if (!staying[candidate] || StrideClass(original[candidate]) != newStride) {
+                    continue;
+                }
+                if (target == planeNum) {
+                    target = candidate;
+                    continue;
+                }
+                bool same = original[candidate] == newDelta;
+                bool bestSame = original[target] == newDelta;
+                if ((same && !bestSame) || (same == bestSame && actionNum_[candidate] < actionNum_[target])) {
+                    target = candidate;
+                }
+            }
+        }
+
+        // x -> x * m (mod N) 查表，表按加法递推，不做除法
+        uint32_t multiplier = MulMod(newDelta, ModularInverse(delta, rankSize_), rankSize_);
+        relabel_.resize(rankSize_);
+        for (uint32_t x = 0, y = 0; x < rankSize_; ++x) {
+            relabel_[x] = y;
+            y += multiplier;
+            y = (y >= rankSize_) ? y - rankSize_ : y;
+        }
+        rebuilt_[planeId] = 1;
+        rebuilt_[target] = 1;
+        for (size_t phaseId = 0; phaseId < bp[planeId].size(); ++phaseId) {
+            Phase& phase = bp[planeId][phaseId];
+            for (Action& action : phase) {
+                action.srcRank = relabel_[action.srcRank];
+                action.dstRank = relabel_[action.dstRank];
+                action.sliceId = relabel_[action.sliceId];
+                action.planeId = target;
+            }
+            stats.movedActionNum += phase.size();
+            if (target != planeId) {
+                bp[target][phaseId].insert(bp[target][phaseId].end(), phase.begin(), phase.end());
+                phase.clear();
+            }
+        }
+        if (target != planeId) {
+            delta_[target] = MergeDelta(delta_[target], newDelta, rankSize_);
+            actionNum_[target] += actionNum_[planeId];
+            actionNum_[planeId] = 0;
+            delta_[planeId] = 0;
+        } else {
+            delta_[planeId] = newDelta;
+        }
+    }
+    rankDegree_ = degree;
+    stats.rankDegree = degree;
+    return true;
+}
+
+bool BlueprintReplanner::Replan(Blueprint& bp, uint32_t rankSize, const FailureSet& failures, ReplanStats* stats,
+                                string* error)
+{
+    ReplanStats localStats;
+    ReplanStats& result = (stats != nullptr) ? *stats : localStats;
+    result = ReplanStats();
+    uint32_t planeNum = static_cast<uint32_t>(bp.size());
+    if (planeNum == 0 || rankSize == 0) {
+        SetError(error, "Blueprint为空");
+        return false;
+    }
+    for (const Schedule& schedule : bp) {
+        if (schedule.size() != bp[0].size()) {
+            SetError(error, "各plane的phase数不一致");
+            return false;
+        }
+    }
+
+    alive_.assign(planeNum, 1);
+    for (uint32_t planeId : failures.planes) {
+        if (planeId >= planeNum) {
+            SetError(error, "失效plane " + to_string(planeId) + " 超出范围");
+            return false;
+        }
+        alive_[planeId] = 0;
+    }
+    alivePlaneNum_ = static_cast<uint32_t>(count(alive_.begin(), alive_.end(), 1));
+    result.alivePlaneNum = alivePlaneNum_;
+    if (alivePlaneNum_ == 0) {
+        SetError(error, "没有存活的plane");
+        return false;
+    }
+    deadLinks_.clear();
+    links_.clear();
+    for (const LinkFailure& link : failures.links) {
+        if (link.u >= rankSize || link.v >= rankSize || link.u == link.v ||
+            (link.planeId != ALL_PLANES && link.planeId >= planeNum)) {
+            SetError(error, "失效链路 (" + to_string(link.u) + ", " + to_string(link.v) + ") 无效");
+            return false;
+        }
+        deadLinks_.insert(LinkKey(link.planeId, link.u, link.v));
+        links_.push_back(link);
+    }
+    rebuilt_.assign(planeNum, 0);
+
+    if (!IsPrepared(bp, rankSize)) {
+        Prepare(bp, rankSize);
+    }
+    CountOrphans(bp);
+    size_t orphanNum = 0;
+    for (size_t planeOrphans : orphanNum_) {
+        orphanNum += planeOrphans;
+    }
+    bool allRing = find(delta_.begin(), delta_.end(), NOT_RING) == delta_.end();
+    uint32_t degree = rankDegree_;
+
+    if (degree <= alivePlaneNum_ && CanMove(bp)) {
+        if (orphanNum > 0) {
+            Move(bp, result);
+            result.mode = ReplanMode::MOVED;
+        }
+        result.rankDegree = degree;
+    } else if (allRing) {
+        if (!Restride(bp, result, error)) {
+            return false;
+        }
+        result.mode = ReplanMode::RESTRIDED;
+    } else {
+        SetError(error, "度数 " + to_string(degree) + " 超过存活plane数 " + to_string(alivePlaneNum_) +
+                        " 或失效链路无法绕开，且Blueprint不是ring流，需要重新构造");
+        return false;
+    }
+
+    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+        if (rebuilt_[planeId]) {
+            result.rebuiltPlanes.push_back(planeId);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+//
+// 故障后的增量重排：给定已构造的Blueprint与失效的plane / 链路，只改动受影响的plane，
+// 其余plane的schedule原样保留（plane数与phase数不变，失效plane的各phase清空）。
+//
+// 依次尝试两种方式：
+//   1. 搬移：受影响的action原样移到同一phase中该对链路完好、action最少的存活plane上。
+//      通信对集合不变，要求原有的每rank度数不超过存活plane数
+//   2. 换步长：各plane都是ring流（plane内所有action的 dst - src 为同一个与N互质的d）时，
+//      在存活plane数的度数预算内保留仍有完好plane承载、承载plane最多的步长，
+//      其余ring流整体换到保留的步长d'上：src、dst、slice同乘 m = d' * d^-1 (mod N)，
+//      即沿另一个哈密顿环执行同一个ring，chunk不变；失效plane的ring流交给该步长上action最少的plane
+// 两种方式都不可行时返回false，调用方应以存活plane数重新构造。
+//
+// Prepare在故障发生前记录各plane的步长、action数与每rank度数，之后的Replan只读写受影响的plane，
+// 开销与改动的action数成正比，与Blueprint的总规模无关。
+//
+
+#ifndef CPP_BLUEPRINT_REPLANNER_H
+#define CPP_BLUEPRINT_REPLANNER_H
+
+#include "solution.h"
+#include "blueprint_scorer.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// 链路在所有plane上都失效
+constexpr const uint32_t ALL_PLANES = DEFAULT_PLANE_ID;
+
+struct LinkFailure {
+    uint32_t u;  // 无向，u与v的顺序无关
+    uint32_t v;
+    uint32_t planeId{ALL_PLANES};
+};
+
+struct FailureSet {
+    std::vector<uint32_t> planes;    // 整个失效的plane，不再占用端口
+    std::vector<LinkFailure> links;  // 失效的链路，所在plane仍可承载其它对
+};
+
+enum class ReplanMode {
+    UNCHANGED,  // 没有action受影响
+    MOVED,      // 搬移
+    RESTRIDED   // 换步长
+};
+
+const char* ReplanModeName(ReplanMode mode);
+
+struct ReplanStats {
+    ReplanMode mode{ReplanMode::UNCHANGED};
+    uint32_t alivePlaneNum{0};            // 存活plane数，即重排后的度数预算
+    uint32_t rankDegree{0};               // 重排后每rank的最大通信对端数
+    std::vector<uint32_t> rebuiltPlanes;  // 被改动的plane，升序
+    size_t movedActionNum{0};             // 搬移或换步长的action数
+};
+
+// 内部状态在多次重排之间复用，非线程安全，每个线程应使用独立的实例
+class BlueprintReplanner {
+public:
+    // 记录bp的结构；Replan成功后记录随之更新，bp在两者之外被修改后应重新Prepare
+    void Prepare(const Blueprint& bp, uint32_t rankSize);
+    // 就地修改bp；bp不是最近一次Prepare / Replan的对象时先Prepare（需扫描整个Blueprint）。
+    // failures为当前的全部故障，已处理过的故障再次给出不会引起改动。失败时bp保持原样并在error中给出原因
+    bool Replan(Blueprint& bp, uint32_t rankSize, const FailureSet& failures, ReplanStats* stats = nullptr,
+                std::string* error = nullptr);
+
+private:
+    static constexpr uint32_t NOT_RING = ~0u;
+
+    static uint64_t LinkKey(uint32_t planeId, uint32_t u, uint32_t v);
+    bool LinkDead(uint32_t planeId, uint32_t u, uint32_t v) const;
+    // 步长类k（min(d, N-d)）的某条边在plane上失效
+    bool ClassDead(uint32_t planeId, uint32_t stride) const;
+    uint32_t StrideClass(uint32_t delta) const;
+
+    // ring流的步长与新action的 dst - src 合并
+    static uint32_t MergeDelta(uint32_t delta, uint32_t actionDelta, uint32_t rankSize);
+    bool IsPrepared(const Blueprint& bp, uint32_t rankSize) const;
+    void InspectPlane(const Blueprint& bp, uint32_t planeId);
+    uint32_t PairDegree(const Blueprint& bp);
+    // 各plane上需要离开该plane的action数，只扫描存活且承载失效链路的plane
+    void CountOrphans(const Blueprint& bp);
+    bool CanMove(const Blueprint& bp) const;
+    void Move(Blueprint& bp, ReplanStats& stats);
+    bool Restride(Blueprint& bp, ReplanStats& stats, std::string* error);
+
+    const Blueprint* prepared_{nullptr};
+    uint32_t rankSize_{0};
+    uint32_t rankDegree_{0};  // 每rank的最大通信对端数
+    uint32_t alivePlaneNum_{0};
+    std::vector<uint8_t> alive_;
+    std::vector<uint8_t> rebuilt_;
+    std::vector<uint32_t> delta_;  // 各plane的 dst - src，空plane为0，不是ring流为NOT_RING
+    std::vector<size_t> actionNum_;
+    std::vector<size_t> orphanNum_;
+    std::unordered_set<uint64_t> deadLinks_;
+    std::vector<LinkFailure> links_;
+    PairTable<uint32_t> pairs_;
+    std::vector<uint32_t> degree_;
+    std::vector<uint32_t> relabel_;  // 换步长时的 x -> x * m (mod N)
+};
+
+#endif // CPP_BLUEPRINT_REPLANNER_H
@@ -0,0 +1,70 @@
+//
+// Blueprint评分器实现
+//
+
+#include "blueprint_scorer.h"
+#include "edge_allocator.h"
+#include <cmath>
+
+using namespace std;
+
+double CalcTheoreticalMinTime(uint32_t N, uint32_t P, const CostModel& costModel, Collective collective)
+{
+    double minPhases = ceil(log2(N));
+    double T1 = minPhases * costModel.MinPhaseLatency(P);
+
+    // 每个数据块大小为S/N；异构plane时为各plane带宽之和
+    double dataPerRank = (N - 1) * costModel.dataSize / N;
+    if (collective == Collective::ALL_REDUCE) {
+        dataPerRank *= 2;
+    }
+    double T2 = dataPerRank / costModel.AggregateBandwidth(P);
+    return T1 + T2;
+}
+
+bool BlueprintScorer::AllocateEdges(uint32_t N, uint32_t P)
+{
+    // 先为每个有通信的pair分配1条边（edges_中的值已为1）
+    degree_.assign(N, 0);
+    vector<uint32_t>& degree = degree_;
+    edges_.ForEach([&degree](uint32_t u, uint32_t v, uint32_t) {
+        ++degree[u];
+        ++degree[v];
+    });
+
+    // 检查度数约束
+    for (uint32_t u = 0; u < N; ++u) {
+        if (degree_[u] > P) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BlueprintScorer::LoadEdges(const EdgeAllocation& allocation, uint32_t N, uint32_t P)
+{
+    if (!allocation.feasible || allocation.rankSize != N) {
+        return false;
+    }
+    // 分配中的每条边都占用端口，无论本Blueprint是否用到
+    degree_.assign(N, 0);
+    size_t coveredNum = 0;
+    for (const EdgeCount& edge : allocation.edges) {
+        if (edge.u >= N || edge.v >= N || edge.m == 0) {
+            return false;
+        }
+        degree_[edge.u] += edge.m;
+        degree_[edge.v] += edge.m;
+        if (edges_.Get(edge.u, edge.v) != 0) {
+            edges_.At(edge.u, edge.v) = edge.m;
+            ++coveredNum;
+        }
+    }
+    for (uint32_t u = 0; u < N; ++u) {
+        if (degree_[u] > P) {
+            return false;
+        }
+    }
+    // 每个有通信的对都要有边
+    return coveredNum == edges_.Size();
+}
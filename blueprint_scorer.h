@@ -0,0 +1,410 @@
+//
+// Blueprint评分器：按 cost_model.h 的代价模型计算通信时间。
+// 计数使用稠密数组（N较小时）或开放寻址哈希表（N较大时），
+// 跨phase复用并按写入记录增量清零，总开销与action数成线性关系。
+// 同构单节点、每对一条边且不切块时，冲突率即有序对的action数，按phase整块计算键并计数（见 simd_kernels.h）。
+//
+
+#ifndef CPP_BLUEPRINT_SCORER_H
+#define CPP_BLUEPRINT_SCORER_H
+
+#include "solution.h"
+#include "cost_model.h"
+#include "compact_blueprint.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// 度数超过P等无效方案的通信时间
+constexpr const double INVALID_COMMUNICATION_TIME = 1e100;
+
+// 以有序对(u, v)为键的表，值初始为0
+// rankSize <= DENSE_RANK_LIMIT 时为N×N稠密数组，否则为开放寻址哈希表
+template <typename T>
+class PairTable {
+public:
+    static constexpr uint32_t DENSE_RANK_LIMIT = 1024;
+
+    // 稠密模式下rankSize不变时只做增量清零，不重新分配
+    void Reset(uint32_t rankSize)
+    {
+        if (dense_ && rankSize == rankSize_ && values_.size() == static_cast<size_t>(rankSize) * rankSize) {
+            Clear();
+            return;
+        }
+        rankSize_ = rankSize;
+        dense_ = rankSize <= DENSE_RANK_LIMIT;
+        touched_.clear();
+        if (dense_) {
+            keys_.clear();
+            values_.assign(static_cast<size_t>(rankSize) * rankSize, T());
+        } else {
+            keys_.assign(INITIAL_CAPACITY, EMPTY_KEY);
+            values_.assign(INITIAL_CAPACITY, T());
+        }
+    }
+
+    // 只清零写过的位置
+    void Clear()
+    {
+        for (size_t slot : touched_) {
+            values_[slot] = T();
+            if (!dense_) {
+                keys_[slot] = EMPTY_KEY;
+            }
+        }
+        touched_.clear();
+    }
+
+    T& At(uint32_t u, uint32_t v)
+    {
+        size_t slot = dense_ ? DenseSlot(u, v) : HashSlot(u, v);
+        return values_[slot];
+    }
+
+    T Get(uint32_t u, uint32_t v) const
+    {
+        if (dense_) {
+            return values_[static_cast<size_t>(u) * rankSize_ + v];
+        }
+        uint64_t key = MakeKey(u, v);
+        for (size_t slot = Hash(key); ; slot = (slot + 1) & (keys_.size() - 1)) {
+            if (keys_[slot] == key) {
+                return values_[slot];
+            }
+            if (keys_[slot] == EMPTY_KEY) {
+                return T();
+            }
+        }
+    }
+
+    // 写过的位置数（即出现过的键数）
+    size_t Size() const { return touched_.size(); }
+
+    // 依次访问出现过的(u, v, value)
+    template <typename Visitor>
+    void ForEach(Visitor visitor) const
+    {
+        for (size_t slot : touched_) {
+            if (dense_) {
+                visitor(static_cast<uint32_t>(slot / rankSize_), static_cast<uint32_t>(slot % rankSize_),
+                        values_[slot]);
+            } else {
+                visitor(static_cast<uint32_t>(keys_[slot] >> 32), static_cast<uint32_t>(keys_[slot]), values_[slot]);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t INITIAL_CAPACITY = 1024;
+    static constexpr uint64_t EMPTY_KEY = ~0ULL;
+
+    static uint64_t MakeKey(uint32_t u, uint32_t v) { return (static_cast<uint64_t>(u) << 32) | v; }
+
+    size_t Hash(uint64_t key) const
+    {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 17) & (keys_.size() - 1);
+    }
+
+    size_t DenseSlot(uint32_t u, uint32_t v)
+    {
+        size_t slot = static_cast<size_t>(u) * rankSize_ + v;
+        if (values_[slot] == T()) {
+            // 值为0的位置可能重复记录，Clear时重复清零无副作用
+            touched_.push_back(slot);
+        }
+        return slot;
+    }
+
+    size_t HashSlot(uint32_t u, uint32_t v)
+    {
+        if (2 * (touched_.size() + 1) > keys_.size()) {
+            Grow();
+        }
+        uint64_t key = MakeKey(u, v);
+        size_t slot = Hash(key);
+        while (keys_[slot] != key) {
+            if (keys_[slot] == EMPTY_KEY) {
+                keys_[slot] = key;
+                touched_.push_back(slot);
+                break;
+            }
+            slot = (slot + 1) & (keys_.size() - 1);
+        }
+        return slot;
+    }
+
+    void Grow()
+    {
+        std::vector<uint64_t> oldKeys(keys_.size() * 2, EMPTY_KEY);
+        std::vector<T> oldValues(values_.size() * 2, T());
+        oldKeys.swap(keys_);
+        oldValues.swap(values_);
+        std::vector<size_t> oldTouched;
+        oldTouched.swap(touched_);
+        for (size_t oldSlot : oldTouched) {
+            uint64_t key = oldKeys[oldSlot];
+            size_t slot = Hash(key);
+            while (keys_[slot] != EMPTY_KEY) {
+                slot = (slot + 1) & (keys_.size() - 1);
+            }
+            keys_[slot] = key;
+            values_[slot] = oldValues[oldSlot];
+            touched_.push_back(slot);
+        }
+    }
+
+    uint32_t rankSize_{0};
+    bool dense_{true};
+    std::vector<uint64_t> keys_;
+    std::vector<T> values_;
+    std::vector<size_t> touched_;
+};
+
+template <typename T>
+constexpr uint32_t PairTable<T>::DENSE_RANK_LIMIT;
+template <typename T>
+constexpr size_t PairTable<T>::INITIAL_CAPACITY;
+template <typename T>
+constexpr uint64_t PairTable<T>::EMPTY_KEY;
+
+struct EdgeAllocation;  // 见 edge_allocator.h
+
+// phase中各action的有序对键写入keys（见 ComputePairKeys），有切块的action时返回false
+template <typename PhaseT>
+inline bool ComputePhasePairKeys(const PhaseT& phase, uint32_t N, uint32_t* keys)
+{
+    return ComputePairKeys(phase.data(), phase.size(), N, keys);
+}
+
+inline bool ComputePhasePairKeys(const CompactPhaseView& phase, uint32_t N, uint32_t* keys)
+{
+    if (phase.ChunkData() != nullptr) {
+        return false;
+    }
+    ComputePairKeys(phase.SrcData(), phase.DstData(), phase.size(), N, keys);
+    return true;
+}
+
+// 理论最小时间（保守估计，评分的基准）：phase数不少于 ceil(log2 N)，所有plane的链路满载；
+// 每个rank收发的数据量reduce-scatter与all-gather为 (N-1) * S/N，all-reduce为其两倍
+double CalcTheoreticalMinTime(uint32_t N, uint32_t P, const CostModel& costModel,
+                              Collective collective = Collective::REDUCE_SCATTER);
+
+// 与test_simple的评分规则一致：
+//   1. 每对有通信的rank之间分配一条边m(u, v) = 1，任一rank度数超过P则方案无效
+//   2. 每个phase的冲突率为同一有向对上的数据量（以slice计）除以m，取最大值，无通信的phase记为1
+//   3. T = K * L + S / (N * B) * Σ max_cr
+// 代价模型为异构plane（CostModel::planes）时，action的数据量乘以其plane的 B / B_p 后计入冲突率，
+// 每个phase的启动时延为该phase有通信的plane中最大的 L_p（无通信的phase取所有plane中最大者）
+// 多节点（CostModel::ranksPerNode > 0）时，跨节点action的数据量再乘以 B / B_inter，
+// 有跨节点action的phase启动时延不小于 L_inter
+// 评分器内部的表在多次调用之间复用，非线程安全，每个线程应使用独立的实例
+class BlueprintScorer {
+public:
+    BlueprintScorer() = default;
+    explicit BlueprintScorer(const CostModel& costModel) : costModel_(costModel) {}
+
+    void SetCostModel(const CostModel& costModel) { costModel_ = costModel; }
+    const CostModel& GetCostModel() const { return costModel_; }
+
+    // 返回通信时间，方案无效时返回INVALID_COMMUNICATION_TIME
+    template <typename BlueprintT>
+    double CalculateCommunicationTime(const BlueprintT& bp, uint32_t N, uint32_t P);
+    // 按给定的物理边分配（见 edge_allocator.h）计算，而不是每对一条边；
+    // 有通信的对没有分配到边或某个rank的 Σm 超过P时无效
+    template <typename BlueprintT>
+    double CalculateCommunicationTime(const BlueprintT& bp, uint32_t N, uint32_t P,
+                                      const EdgeAllocation& allocation);
+
+    // 最近一次计算得到的 Σ max_cr
+    double LastConflictSum() const { return lastConflictSum_; }
+
+private:
+    // 根据edges_中出现过的有序对分配无向边并检查度数
+    bool AllocateEdges(uint32_t N, uint32_t P);
+    // 用给定的分配覆盖edges_中出现过的无向对的边数并检查度数
+    bool LoadEdges(const EdgeAllocation& allocation, uint32_t N, uint32_t P);
+    template <typename BlueprintT>
+    void CollectPairs(const BlueprintT& bp, uint32_t N);
+    // unitEdges为true时每个有通信的对恰有一条边（AllocateEdges），可走稠密计数的快速路径
+    template <typename BlueprintT>
+    double SumConflicts(const BlueprintT& bp, uint32_t N, uint32_t K, bool unitEdges);
+    // 快速路径下一个phase的最大冲突率，phase中有切块的action时返回false，由调用方按通用路径计算
+    template <typename BlueprintT>
+    bool CountPhaseConflicts(const BlueprintT& bp, uint32_t N, uint32_t phaseId, double& maxConflict);
+
+    CostModel costModel_;
+    PairTable<uint32_t> edges_;    // 无向边(min, max)上的边数m
+    PairTable<double> phaseLoad_;  // 当前phase各有序对上的数据量
+    std::vector<uint32_t> degree_;
+    std::vector<double> planeRatio_;  // 异构plane时各plane的 B / B_p
+    std::vector<uint32_t> pairKeys_;    // 快速路径下当前phase各action的有序对键
+    std::vector<uint32_t> pairCounts_;  // 快速路径下的 N×N 稠密计数（另加一项sink），phase之间保持全0
+    double lastConflictSum_{0.0};
+};
+
+template <typename BlueprintT>
+void BlueprintScorer::CollectPairs(const BlueprintT& bp, uint32_t N)
+{
+    // 统计有通信的无向对，边数先记为1
+    edges_.Reset(N);
+    for (const auto& schedule : bp) {
+        for (const auto& phase : schedule) {
+            for (const auto& action : phase) {
+                if (action.srcRank != action.dstRank) {
+                    edges_.At(std::min(action.srcRank, action.dstRank), std::max(action.srcRank, action.dstRank)) = 1;
+                }
+            }
+        }
+    }
+}
+
+template <typename BlueprintT>
+double BlueprintScorer::CalculateCommunicationTime(const BlueprintT& bp, uint32_t N, uint32_t P)
+{
+    lastConflictSum_ = 0.0;
+    if (bp.empty()) {
+        return costModel_.CommunicationTime(N, 0, 0.0);
+    }
+    uint32_t K = static_cast<uint32_t>(bp[0].size());
+
+    CollectPairs(bp, N);
+    if (!AllocateEdges(N, P)) {
+        return INVALID_COMMUNICATION_TIME;
+    }
+    return SumConflicts(bp, N, K, true);
+}
+
+template <typename BlueprintT>
+double BlueprintScorer::CalculateCommunicationTime(const BlueprintT& bp, uint32_t N, uint32_t P,
+                                                   const EdgeAllocation& allocation)
+{
+    lastConflictSum_ = 0.0;
+    if (bp.empty()) {
+        return costModel_.CommunicationTime(N, 0, 0.0);
+    }
+    uint32_t K = static_cast<uint32_t>(bp[0].size());
+
+    CollectPairs(bp, N);
+    if (!LoadEdges(allocation, N, P)) {
+        return INVALID_COMMUNICATION_TIME;
+    }
+    return SumConflicts(bp, N, K, false);
+}
+
+template <typename BlueprintT>
+bool BlueprintScorer::CountPhaseConflicts(const BlueprintT& bp, uint32_t N, uint32_t phaseId, double& maxConflict)
+{
+    size_t actionNum = 0;
+    for (const auto& schedule : bp) {
+        if (phaseId < schedule.size()) {
+            actionNum += schedule[phaseId].size();
+        }
+    }
+    if (pairKeys_.size() < actionNum) {
+        pairKeys_.resize(actionNum);
+    }
+    size_t offset = 0;
+    for (const auto& schedule : bp) {
+        if (phaseId >= schedule.size()) {
+            continue;
+        }
+        const auto& phase = schedule[phaseId];
+        if (!ComputePhasePairKeys(phase, N, pairKeys_.data() + offset)) {
+            return false;
+        }
+        offset += phase.size();
+    }
+    AccumulatePairCounts(pairKeys_.data(), actionNum, pairCounts_.data());
+    maxConflict = TakeMaxPairCount(pairKeys_.data(), actionNum, N, pairCounts_.data());
+    return true;
+}
+
+template <typename BlueprintT>
+double BlueprintScorer::SumConflicts(const BlueprintT& bp, uint32_t N, uint32_t K, bool unitEdges)
+{
+    bool heterogeneous = costModel_.Heterogeneous();
+    bool multiNode = costModel_.MultiNode();
+    double interRatio = costModel_.InterNodeTimeRatio();
+    uint32_t planeNum = static_cast<uint32_t>(bp.size());
+    if (heterogeneous) {
+        planeRatio_.resize(planeNum);
+        for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+            planeRatio_[planeId] = costModel_.PlaneTimeRatio(planeId);
+        }
+    }
+
+    // 冲突率为整数计数时按phase整块计数，计数表在各phase之后恢复为全0，只在N变化时重新分配
+    bool countPairs = !heterogeneous && !multiNode && unitEdges && N <= PairTable<uint32_t>::DENSE_RANK_LIMIT;
+    if (countPairs && pairCounts_.size() != static_cast<size_t>(PairCountSink(N)) + 1) {
+        pairCounts_.assign(static_cast<size_t>(PairCountSink(N)) + 1, 0);
+    }
+
+    // 逐phase累加数据量，数据量只增不减，边累加边取最大值即可
+    phaseLoad_.Reset(N);
+    double conflictSum = 0.0;
+    double latencySum = 0.0;
+    for (uint32_t phaseId = 0; phaseId < K; ++phaseId) {
+        double maxConflict = 0.0;
+        double phaseLatency = 0.0;
+        if (countPairs && CountPhaseConflicts(bp, N, phaseId, maxConflict)) {
+            if (maxConflict < 1e-6) {
+                maxConflict = 1.0;
+            }
+            conflictSum += maxConflict;
+            continue;
+        }
+        for (const auto& schedule : bp) {
+            if (phaseId >= schedule.size()) {
+                continue;
+            }
+            for (const auto& action : schedule[phaseId]) {
+                if (action.srcRank == action.dstRank) {
+                    continue;
+                }
+                double& load = phaseLoad_.At(action.srcRank, action.dstRank);
+                if (heterogeneous || multiNode) {
+                    double ratio = 1.0;
+                    if (heterogeneous) {
+                        ratio = (action.planeId < planeNum) ? planeRatio_[action.planeId] :
+                                costModel_.PlaneTimeRatio(action.planeId);
+                    }
+                    double latency = costModel_.PlaneLatency(action.planeId);
+                    if (costModel_.CrossNode(action.srcRank, action.dstRank)) {
+                        ratio *= interRatio;
+                        latency = std::max(latency, costModel_.interNodeLatency);
+                    }
+                    load += ratio / action.chunkNum;
+                    phaseLatency = std::max(phaseLatency, latency);
+                } else {
+                    load += 1.0 / action.chunkNum;
+                }
+                uint32_t m = edges_.Get(std::min(action.srcRank, action.dstRank),
+                                        std::max(action.srcRank, action.dstRank));
+                double conflict = load / m;
+                if (conflict > maxConflict) {
+                    maxConflict = conflict;
+                }
+            }
+        }
+        phaseLoad_.Clear();
+
+        // 如果max_cr为0（可能该阶段没有通信），设置为1
+        if (maxConflict < 1e-6) {
+            maxConflict = 1.0;
+            phaseLatency = costModel_.MaxPhaseLatency(planeNum);
+        }
+        conflictSum += maxConflict;
+        latencySum += phaseLatency;
+    }
+
+    lastConflictSum_ = conflictSum;
+    if (heterogeneous || multiNode) {
+        return latencySum + costModel_.SliceTransferTime(N) * conflictSum;
+    }
+    return costModel_.CommunicationTime(N, K, conflictSum);
+}
+
+#endif // CPP_BLUEPRINT_SCORER_H
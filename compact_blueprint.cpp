@@ -0,0 +1,118 @@
+//
+// 紧凑Blueprint实现
+//
+
+#include "compact_blueprint.h"
+
+using namespace std;
+
+void CompactBlueprint::Clear()
+{
+    src_.clear();
+    dst_.clear();
+    slice_.clear();
+    chunk_.clear();
+    chunkNum_.clear();
+    phaseOffsets_.clear();
+    planeOffsets_.clear();
+}
+
+void CompactBlueprint::Reserve(size_t planeNum, size_t phaseNum, size_t actionNum)
+{
+    planeOffsets_.reserve(planeNum);
+    phaseOffsets_.reserve(phaseNum);
+    src_.reserve(actionNum);
+    dst_.reserve(actionNum);
+    slice_.reserve(actionNum);
+}
+
+void CompactBlueprint::AddPlane()
+{
+    planeOffsets_.push_back(phaseOffsets_.size());
+}
+
+void CompactBlueprint::AddPhase()
+{
+    phaseOffsets_.push_back(src_.size());
+}
+
+void CompactBlueprint::Allocate(size_t planeNum, size_t phaseNum, const vector<size_t>& actionNums, bool chunked)
+{
+    planeOffsets_.resize(planeNum);
+    phaseOffsets_.resize(planeNum * phaseNum);
+    size_t actionNum = 0;
+    for (size_t planeId = 0; planeId < planeNum; ++planeId) {
+        planeOffsets_[planeId] = planeId * phaseNum;
+        for (size_t phaseId = 0; phaseId < phaseNum; ++phaseId) {
+            size_t globalPhaseId = planeId * phaseNum + phaseId;
+            phaseOffsets_[globalPhaseId] = actionNum;
+            actionNum += actionNums[globalPhaseId];
+        }
+    }
+    src_.resize(actionNum);
+    dst_.resize(actionNum);
+    slice_.resize(actionNum);
+    if (chunked) {
+        chunk_.resize(actionNum);
+        chunkNum_.resize(actionNum);
+    } else {
+        chunk_.clear();
+        chunkNum_.clear();
+    }
+}
+
+void CompactBlueprint::AddChunk(const Action& action)
+{
+    if (chunk_.empty()) {
+        chunk_.reserve(src_.capacity());
+        chunkNum_.reserve(src_.capacity());
+        chunk_.assign(src_.size(), 0);
+        chunkNum_.assign(src_.size(), 1);
+    }
+    chunk_.push_back(action.chunkId);
+    chunkNum_.push_back(action.chunkNum);
+}
+
+size_t CompactBlueprint::MemoryBytes() const
+{
+    return (src_.capacity() + dst_.capacity() + slice_.capacity() + chunk_.capacity() + chunkNum_.capacity()) *
+           sizeof(uint16_t) +
+           (phaseOffsets_.capacity() + planeOffsets_.capacity()) * sizeof(size_t);
+}
+
+bool CompactBlueprint::Assign(const FlatBlueprint& blueprint)
+{
+    Clear();
+    Reserve(blueprint.size(), blueprint.TotalPhaseNum(), blueprint.TotalActionNum());
+    for (size_t planeId = 0; planeId < blueprint.size(); ++planeId) {
+        AddPlane();
+        for (const auto& phase : blueprint[planeId]) {
+            AddPhase();
+            for (const auto& action : phase) {
+                if (action.srcRank > COMPACT_MAX_VALUE || action.dstRank > COMPACT_MAX_VALUE ||
+                    action.sliceId > COMPACT_MAX_VALUE || action.planeId != planeId) {
+                    Clear();
+                    return false;
+                }
+                AddAction(action);
+            }
+        }
+    }
+    return true;
+}
+
+FlatBlueprint CompactBlueprint::ToFlatBlueprint() const
+{
+    FlatBlueprint flat;
+    flat.Reserve(size(), TotalPhaseNum(), TotalActionNum());
+    for (const auto& schedule : *this) {
+        flat.AddPlane();
+        for (const auto& phase : schedule) {
+            flat.AddPhase();
+            for (size_t idx = 0; idx < phase.size(); ++idx) {
+                flat.AddAction(phase[idx]);
+            }
+        }
+    }
+    return flat;
+}
@@ -0,0 +1,206 @@
+//
+// 紧凑Blueprint存储：按列（SoA）存放16位的src/dst/slice，
+// planeId由所在plane的下标隐含，不再单独存储。
+// 每个Action占6字节，约为Action结构体（20字节）的3/10；
+// 只有出现切块（chunkNum > 1）的action时才额外存储chunkId/chunkNum两列。
+//
+
+#ifndef CPP_COMPACT_BLUEPRINT_H
+#define CPP_COMPACT_BLUEPRINT_H
+
+#include "solution.h"
+#include "flat_blueprint.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 16位编码能表示的最大值（65535为INVALID_*_ID哨兵）
+constexpr const uint32_t COMPACT_MAX_VALUE = 0xFFFF;
+
+class CompactBlueprint;
+
+// 预分配后可直接写入的一个phase的src/dst/slice列（chunk列不在其中）
+struct CompactPhaseColumns {
+    uint16_t* src;
+    uint16_t* dst;
+    uint16_t* slice;
+    size_t size;
+};
+
+// 单个phase的视图，下标访问时解码为Action
+class CompactPhaseView {
+public:
+    using const_iterator = IndexIterator<CompactPhaseView, Action>;
+
+    CompactPhaseView(const uint16_t* src, const uint16_t* dst, const uint16_t* slice, const uint16_t* chunk,
+                     const uint16_t* chunkNum, size_t size, uint32_t planeId)
+        : src_(src), dst_(dst), slice_(slice), chunk_(chunk), chunkNum_(chunkNum), size_(size), planeId_(planeId) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    Action operator[](size_t idx) const
+    {
+        Action action;
+        action.srcRank = src_[idx];
+        action.dstRank = dst_[idx];
+        action.planeId = planeId_;
+        action.sliceId = slice_[idx];
+        if (chunk_ != nullptr) {
+            action.chunkId = chunk_[idx];
+            action.chunkNum = chunkNum_[idx];
+        }
+        return action;
+    }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    // 列数据，便于按数组顺序扫描
+    const uint16_t* SrcData() const { return src_; }
+    const uint16_t* DstData() const { return dst_; }
+    const uint16_t* SliceData() const { return slice_; }
+    // 没有切块时为nullptr
+    const uint16_t* ChunkData() const { return chunk_; }
+    const uint16_t* ChunkNumData() const { return chunkNum_; }
+    uint32_t PlaneId() const { return planeId_; }
+
+private:
+    const uint16_t* src_;
+    const uint16_t* dst_;
+    const uint16_t* slice_;
+    const uint16_t* chunk_;
+    const uint16_t* chunkNum_;
+    size_t size_;
+    uint32_t planeId_;
+};
+
+// 单个plane的schedule视图
+class CompactScheduleView {
+public:
+    using const_iterator = IndexIterator<CompactScheduleView, CompactPhaseView>;
+
+    CompactScheduleView(const CompactBlueprint* blueprint, uint32_t planeId)
+        : blueprint_(blueprint), planeId_(planeId) {}
+
+    uint32_t PlaneId() const { return planeId_; }
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    CompactPhaseView operator[](size_t phaseId) const;
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+private:
+    const CompactBlueprint* blueprint_;
+    uint32_t planeId_;
+};
+
+// 紧凑Blueprint，偏移表的含义与FlatBlueprint相同
+// 构造接口（Clear/Reserve/AddPlane/AddPhase/AddAction）也与FlatBlueprint一致
+class CompactBlueprint {
+public:
+    using const_iterator = IndexIterator<CompactBlueprint, CompactScheduleView>;
+
+    CompactBlueprint() = default;
+
+    void Clear();
+    void Reserve(size_t planeNum, size_t phaseNum, size_t actionNum);
+    void AddPlane();
+    void AddPhase();
+    // 调用方需保证action的各字段不超过COMPACT_MAX_VALUE，且planeId与当前plane一致
+    void AddAction(const Action& action)
+    {
+        if (!chunk_.empty() || action.chunkNum != 1) {
+            AddChunk(action);
+        }
+        src_.push_back(static_cast<uint16_t>(action.srcRank));
+        dst_.push_back(static_cast<uint16_t>(action.dstRank));
+        slice_.push_back(static_cast<uint16_t>(action.sliceId));
+    }
+
+    // 预分配式构造，含义同FlatBlueprint::Allocate；chunked为true时同时分配chunk列
+    void Allocate(size_t planeNum, size_t phaseNum, const std::vector<size_t>& actionNums, bool chunked = false);
+    void SetAction(size_t planeId, size_t phaseId, size_t actionId, const Action& action)
+    {
+        size_t idx = phaseOffsets_[planeOffsets_[planeId] + phaseId] + actionId;
+        src_[idx] = static_cast<uint16_t>(action.srcRank);
+        dst_[idx] = static_cast<uint16_t>(action.dstRank);
+        slice_[idx] = static_cast<uint16_t>(action.sliceId);
+        if (!chunk_.empty()) {
+            chunk_[idx] = action.chunkId;
+            chunkNum_[idx] = action.chunkNum;
+        }
+    }
+
+    // Allocate之后按列写入整个phase，供向量化生成使用（见 simd_kernels.h），不同phase可由不同线程并发写入
+    CompactPhaseColumns MutablePhaseColumns(size_t planeId, size_t phaseId)
+    {
+        size_t globalPhaseId = planeOffsets_[planeId] + phaseId;
+        size_t begin = phaseOffsets_[globalPhaseId];
+        CompactPhaseColumns columns;
+        columns.src = src_.data() + begin;
+        columns.dst = dst_.data() + begin;
+        columns.slice = slice_.data() + begin;
+        columns.size = PhaseEnd(globalPhaseId) - begin;
+        return columns;
+    }
+
+    size_t size() const { return planeOffsets_.size(); }
+    bool empty() const { return size() == 0; }
+    CompactScheduleView operator[](size_t planeId) const
+    {
+        return CompactScheduleView(this, static_cast<uint32_t>(planeId));
+    }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    size_t PhaseNum(size_t planeId) const { return PlaneEnd(planeId) - planeOffsets_[planeId]; }
+    CompactPhaseView GetPhase(size_t planeId, size_t phaseId) const
+    {
+        size_t globalPhaseId = planeOffsets_[planeId] + phaseId;
+        size_t begin = phaseOffsets_[globalPhaseId];
+        const uint16_t* chunk = chunk_.empty() ? nullptr : chunk_.data() + begin;
+        const uint16_t* chunkNum = chunk_.empty() ? nullptr : chunkNum_.data() + begin;
+        return CompactPhaseView(src_.data() + begin, dst_.data() + begin, slice_.data() + begin, chunk, chunkNum,
+                                PhaseEnd(globalPhaseId) - begin, static_cast<uint32_t>(planeId));
+    }
+
+    size_t TotalPhaseNum() const { return phaseOffsets_.size(); }
+    size_t TotalActionNum() const { return src_.size(); }
+    size_t MemoryBytes() const;
+
+    // 从FlatBlueprint转换，若存在无法用16位表示的值或planeId与plane下标不符则返回false
+    bool Assign(const FlatBlueprint& blueprint);
+    FlatBlueprint ToFlatBlueprint() const;
+
+private:
+    // 首次出现切块的action时为之前的action补齐默认值（chunkId=0, chunkNum=1）
+    void AddChunk(const Action& action);
+
+    size_t PlaneEnd(size_t planeId) const
+    {
+        return (planeId + 1 < planeOffsets_.size()) ? planeOffsets_[planeId + 1] : phaseOffsets_.size();
+    }
+    size_t PhaseEnd(size_t globalPhaseId) const
+    {
+        return (globalPhaseId + 1 < phaseOffsets_.size()) ? phaseOffsets_[globalPhaseId + 1] : src_.size();
+    }
+
+    std::vector<uint16_t> src_;
+    std::vector<uint16_t> dst_;
+    std::vector<uint16_t> slice_;
+    std::vector<uint16_t> chunk_;
+    std::vector<uint16_t> chunkNum_;
+    std::vector<size_t> phaseOffsets_;
+    std::vector<size_t> planeOffsets_;
+};
+
+inline size_t CompactScheduleView::size() const
+{
+    return blueprint_->PhaseNum(planeId_);
+}
+
+inline CompactPhaseView CompactScheduleView::operator[](size_t phaseId) const
+{
+    return blueprint_->GetPhase(planeId_, phaseId);
+}
+
+#endif // CPP_COMPACT_BLUEPRINT_H
@@ -3,26 +3,49 @@
 
 echo "开始编译..."
 
+# 并行生成Blueprint使用std::thread，需要-pthread
+CXXFLAGS="-O2 -std=c++11 -pthread"
+# INSTRUMENT=1 ./compile.sh: 启用生成过程的计时与计数（见 instrumentation.h）
+if [ "$INSTRUMENT" = "1" ]; then
+    CXXFLAGS="$CXXFLAGS -DENABLE_INSTRUMENTATION"
+fi
+
 # 编译主解决方案
-g++ -O2 -std=c++11 -c solution.cpp -o solution.o
+g++ $CXXFLAGS -c solution.cpp -o solution.o
+g++ $CXXFLAGS -c flat_blueprint.cpp -o flat_blueprint.o
+g++ $CXXFLAGS -c compact_blueprint.cpp -o compact_blueprint.o
+g++ $CXXFLAGS -c blueprint_scorer.cpp -o blueprint_scorer.o
+g++ $CXXFLAGS -c schedule_generators.cpp -o schedule_generators.o
+g++ $CXXFLAGS -c lazy_blueprint.cpp -o lazy_blueprint.o
+g++ $CXXFLAGS -c blueprint_cache.cpp -o blueprint_cache.o
+g++ $CXXFLAGS -c blueprint_file.cpp -o blueprint_file.o
+g++ $CXXFLAGS -c network_simulator.cpp -o network_simulator.o
+g++ $CXXFLAGS -c semantic_verifier.cpp -o semantic_verifier.o
+g++ $CXXFLAGS -c edge_allocator.cpp -o edge_allocator.o
+g++ $CXXFLAGS -c test_case_loader.cpp -o test_case_loader.o
+g++ $CXXFLAGS -c batch_evaluator.cpp -o batch_evaluator.o
+g++ $CXXFLAGS -c instrumentation.cpp -o instrumentation.o
+g++ $CXXFLAGS -c schedule_tuner.cpp -o schedule_tuner.o
+g++ $CXXFLAGS -c blueprint_replanner.cpp -o blueprint_replanner.o
+# 向量内核以函数级target属性编译，运行时按CPU能力选择，不需要-mavx2等全局选项
+g++ $CXXFLAGS -c simd_kernels.cpp -o simd_kernels.o
+OBJS="solution.o flat_blueprint.o compact_blueprint.o blueprint_scorer.o schedule_generators.o lazy_blueprint.o blueprint_cache.o blueprint_file.o network_simulator.o semantic_verifier.o edge_allocator.o test_case_loader.o batch_evaluator.o instrumentation.o schedule_tuner.o blueprint_replanner.o simd_kernels.o"
 
 # 编译测试程序（不依赖JSON）
-g++ -O2 -std=c++11 test_simple.cpp solution.o -o test_simple
-
-# 如果安装了json库，也可以编译支持JSON的版本
-if pkg-config --exists nlohmann_json 2>/dev/null; then
-    echo "检测到 nlohmann/json 库，编译完整评测程序..."
-    g++ -O2 -std=c++11 evaluator_simple.cpp solution.o -o evaluator_simple $(pkg-config --cflags --libs nlohmann_json)
-elif [ -f /usr/include/nlohmann/json.hpp ] || [ -f /usr/local/include/nlohmann/json.hpp ]; then
-    echo "检测到 nlohmann/json.hpp，编译完整评测程序..."
-    g++ -O2 -std=c++11 evaluator_simple.cpp solution.o -o evaluator_simple
-else
-    echo "未检测到 nlohmann/json 库，只编译简单测试程序"
-fi
+g++ $CXXFLAGS test_simple.cpp $OBJS -o test_simple
+
+# 编译基准测试程序（不依赖JSON）
+g++ $CXXFLAGS benchmark.cpp $OBJS -o benchmark
+
+# 编译离线调优程序
+g++ $CXXFLAGS autotune.cpp $OBJS -o autotune
+
+# 编译评测程序（用例文件由 test_case_loader 流式解析，不依赖JSON库）
+g++ $CXXFLAGS evaluator_simple.cpp $OBJS -o evaluator_simple
 
 echo "编译完成！"
 echo "可执行文件："
 echo "  - test_simple: 简单测试程序"
-if [ -f evaluator_simple ]; then
-    echo "  - evaluator_simple: 完整评测程序（需要sample.json）"
-fi
\ No newline at end of file
+echo "  - benchmark: 生成/校验/评分基准测试（JSON Lines输出）"
+echo "  - autotune: 离线调度调优，输出调优表（test_simple --tuning 使用）"
+echo "  - evaluator_simple: 完整评测程序（读取sample.json或--cases指定的文件）"
\ No newline at end of file
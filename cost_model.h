@@ -0,0 +1,141 @@
+//
+// 评测与调度选择共用的 L/S/B 代价模型
+//   T = T1 + T2
+//   T1 = K * L                          （K为phase数）
+//   T2 = S / (N * B) * Σ_k max_cr(k)     （max_cr为第k个phase的最大链路冲突率）
+// 各plane带宽/时延不同时（planes非空），B为参考带宽，plane p上的数据量按 B / B_p 折算后计入冲突率，
+// 每个phase的启动时延取该phase有通信的plane中最大的 L_p
+// 多节点时（ranksPerNode > 0，rank r 属于节点 r / ranksPerNode），跨节点链路的数据量按 B / B_inter 折算，
+// 有跨节点通信的phase启动时延不小于 L_inter；B、L 为节点内链路的参数
+//
+
+#ifndef CPP_COST_MODEL_H
+#define CPP_COST_MODEL_H
+
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+constexpr const double DEFAULT_PHASE_LATENCY = 0.002;                      // L，阶段启动时延 ms
+constexpr const double DEFAULT_DATA_SIZE = 40.0 * 1024.0 * 1024.0;           // S，40 MB
+constexpr const double DEFAULT_BANDWIDTH = 400.0 * 1024.0 * 1024.0 * 1024.0; // B，400 GB/s
+constexpr const double SCORE_BETA = 1.5;
+constexpr const double SCORE_MAX = 100.0;
+
+// 单个plane的链路参数，单位同CostModel
+struct PlaneProfile {
+    double bandwidth{DEFAULT_BANDWIDTH};
+    double phaseLatency{DEFAULT_PHASE_LATENCY};
+
+    bool operator==(const PlaneProfile& other) const
+    {
+        return bandwidth == other.bandwidth && phaseLatency == other.phaseLatency;
+    }
+};
+
+struct CostModel {
+    double phaseLatency{DEFAULT_PHASE_LATENCY};
+    double dataSize{DEFAULT_DATA_SIZE};
+    double bandwidth{DEFAULT_BANDWIDTH};
+    // 各plane的带宽与时延，为空时所有plane都是 (bandwidth, phaseLatency)；
+    // 非空时下标即planeId，超出范围的plane按 (bandwidth, phaseLatency) 计
+    std::vector<PlaneProfile> planes;
+    // 每个节点的rank数，0为所有rank在同一节点（不区分节点内外）
+    uint32_t ranksPerNode{0};
+    double interNodeLatency{DEFAULT_PHASE_LATENCY};
+    double interNodeBandwidth{DEFAULT_BANDWIDTH};
+
+    bool Heterogeneous() const { return !planes.empty(); }
+    bool MultiNode() const { return ranksPerNode > 0; }
+    bool CrossNode(uint32_t u, uint32_t v) const
+    {
+        return ranksPerNode > 0 && u / ranksPerNode != v / ranksPerNode;
+    }
+    // 跨节点链路上一个slice的传输时间相对节点内的倍数 B / B_inter，带宽不为正时为无穷大
+    double InterNodeTimeRatio() const
+    {
+        return (interNodeBandwidth > 0.0) ? bandwidth / interNodeBandwidth : HUGE_VAL;
+    }
+
+    // plane上一个slice的传输时间相对参考带宽的倍数 B / B_p，带宽不为正时为无穷大
+    double PlaneTimeRatio(uint32_t planeId) const
+    {
+        if (planeId >= planes.size()) {
+            return 1.0;
+        }
+        return (planes[planeId].bandwidth > 0.0) ? bandwidth / planes[planeId].bandwidth : HUGE_VAL;
+    }
+    double PlaneLatency(uint32_t planeId) const
+    {
+        return (planeId < planes.size()) ? planes[planeId].phaseLatency : phaseLatency;
+    }
+    // 前planeNum个plane中最大的 L_p
+    double MaxPhaseLatency(uint32_t planeNum) const
+    {
+        double latency = (planes.size() < planeNum || planes.empty()) ? phaseLatency : 0.0;
+        for (uint32_t planeId = 0; planeId < planeNum && planeId < planes.size(); ++planeId) {
+            latency = std::max(latency, planes[planeId].phaseLatency);
+        }
+        return latency;
+    }
+    double MinPhaseLatency(uint32_t planeNum) const
+    {
+        double latency = (planes.size() < planeNum || planes.empty()) ? phaseLatency : HUGE_VAL;
+        for (uint32_t planeId = 0; planeId < planeNum && planeId < planes.size(); ++planeId) {
+            latency = std::min(latency, planes[planeId].phaseLatency);
+        }
+        return latency;
+    }
+    // 前planeNum个plane的带宽之和
+    double AggregateBandwidth(uint32_t planeNum) const
+    {
+        if (planes.empty()) {
+            return bandwidth * planeNum;
+        }
+        double total = 0.0;
+        for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+            total += (planeId < planes.size()) ? std::max(planes[planeId].bandwidth, 0.0) : bandwidth;
+        }
+        return total;
+    }
+
+    // 单个slice（S/N）在一条链路上的传输时间
+    double SliceTransferTime(uint32_t rankSize) const
+    {
+        return dataSize / (rankSize * bandwidth);
+    }
+
+    // conflictSum为各phase最大冲突率之和；异构plane时每个phase按最慢的启动时延计
+    double CommunicationTime(uint32_t rankSize, uint32_t phaseNum, double conflictSum) const
+    {
+        double latency = planes.empty() ? phaseLatency : MaxPhaseLatency(static_cast<uint32_t>(planes.size()));
+        return phaseNum * latency + SliceTransferTime(rankSize) * conflictSum;
+    }
+    // 多节点：phaseNum个phase中有interPhaseNum个含跨节点通信，interConflictSum为这些phase的冲突率之和
+    // （已计入conflictSum，以节点内带宽计）。这些phase同时可能有节点内通信，按较慢的一方计
+    double CommunicationTime(uint32_t rankSize, uint32_t phaseNum, double conflictSum, uint32_t interPhaseNum,
+                             double interConflictSum) const
+    {
+        if (!MultiNode() || interPhaseNum == 0) {
+            return CommunicationTime(rankSize, phaseNum, conflictSum);
+        }
+        double latency = planes.empty() ? phaseLatency : MaxPhaseLatency(static_cast<uint32_t>(planes.size()));
+        double interLatency = std::max(latency, interNodeLatency);
+        double interRatio = std::max(InterNodeTimeRatio(), 1.0);
+        return (phaseNum - interPhaseNum) * latency + interPhaseNum * interLatency +
+               SliceTransferTime(rankSize) * (conflictSum + interConflictSum * (interRatio - 1.0));
+    }
+};
+
+// 实际时间T相对理论最小时间T_min的得分
+inline double CalcScore(double T, double T_min)
+{
+    if (T <= T_min) {
+        return SCORE_MAX;
+    }
+    double ratio = T / T_min;
+    return SCORE_MAX * std::exp(-SCORE_BETA * (ratio - 1));
+}
+
+#endif // CPP_COST_MODEL_H
@@ -0,0 +1,383 @@
+//
+// 物理边分配实现
+//
+
+#include "edge_allocator.h"
+#include <cmath>
+#include <queue>
+#include <utility>
+
+using namespace std;
+
+constexpr uint32_t EdgeAllocator::NO_PAIR;
+
+namespace {
+
+// 与评分器一致：无通信的phase记为1
+constexpr double MIN_PHASE_CONFLICT = 1e-6;
+// 目标下降小于该值的移动视为无改进，避免浮点误差导致来回挪边
+constexpr double MIN_IMPROVEMENT = 1e-9;
+
+} // namespace
+
+uint32_t EdgeAllocation::EdgeNum(uint32_t u, uint32_t v) const
+{
+    if (u > v) {
+        swap(u, v);
+    }
+    auto it = lower_bound(edges.begin(), edges.end(), make_pair(u, v),
+                          [](const EdgeCount& edge, const pair<uint32_t, uint32_t>& key) {
+                              return (edge.u != key.first) ? edge.u < key.first : edge.v < key.second;
+                          });
+    return (it != edges.end() && it->u == u && it->v == v) ? it->m : 0;
+}
+
+void EdgeAllocator::ResetTraffic(uint32_t N, uint32_t phaseNum)
+{
+    rankSize_ = N;
+    phaseNum_ = phaseNum;
+    currentPhase_ = 0;
+    phaseLoad_.Reset(N);
+    pairIndex_.Reset(N);
+    pairU_.clear();
+    pairV_.clear();
+    pairStamp_.clear();
+    pairEntry_.clear();
+    phaseBegin_.assign(1, 0);
+    entryPair_.clear();
+    entryLoad_.clear();
+}
+
+uint32_t EdgeAllocator::PairIndex(uint32_t u, uint32_t v)
+{
+    uint32_t& index = pairIndex_.At(u, v);
+    if (index == 0) {
+        pairU_.push_back(u);
+        pairV_.push_back(v);
+        pairStamp_.push_back(0);
+        pairEntry_.push_back(0);
+        index = static_cast<uint32_t>(pairU_.size());
+    }
+    return index - 1;
+}
+
+void EdgeAllocator::AddTraffic(uint32_t phaseId, uint32_t srcRank, uint32_t dstRank, double load)
+{
+    if (srcRank == dstRank) {
+        return;
+    }
+    PairIndex(min(srcRank, dstRank), max(srcRank, dstRank));
+    if (phaseId >= phaseNum_) {
+        return;
+    }
+    while (currentPhase_ < phaseId) {
+        FlushPhase();
+    }
+    phaseLoad_.At(srcRank, dstRank) += load;
+}
+
+void EdgeAllocator::FlushPhase()
+{
+    // 两个方向共用同一组边，冲突率取决于负载较大的方向
+    uint32_t stamp = currentPhase_ + 1;
+    phaseLoad_.ForEach([this, stamp](uint32_t u, uint32_t v, double load) {
+        uint32_t pairId = pairIndex_.Get(min(u, v), max(u, v)) - 1;
+        if (pairStamp_[pairId] == stamp) {
+            entryLoad_[pairEntry_[pairId]] = max(entryLoad_[pairEntry_[pairId]], load);
+            return;
+        }
+        pairStamp_[pairId] = stamp;
+        pairEntry_[pairId] = entryPair_.size();
+        entryPair_.push_back(pairId);
+        entryLoad_.push_back(load);
+    });
+    phaseLoad_.Clear();
+    phaseBegin_.push_back(entryPair_.size());
+    ++currentPhase_;
+}
+
+void EdgeAllocator::BuildIndexes()
+{
+    size_t pairNum = pairU_.size();
+    entryPhase_.resize(entryPair_.size());
+    pairBegin_.assign(pairNum + 1, 0);
+    loadScale_ = 0.0;
+    for (uint32_t phaseId = 0; phaseId < phaseNum_; ++phaseId) {
+        for (size_t entry = phaseBegin_[phaseId]; entry < phaseBegin_[phaseId + 1]; ++entry) {
+            entryPhase_[entry] = phaseId;
+            ++pairBegin_[entryPair_[entry] + 1];
+            loadScale_ = max(loadScale_, entryLoad_[entry]);
+        }
+    }
+    for (size_t pairId = 0; pairId < pairNum; ++pairId) {
+        pairBegin_[pairId + 1] += pairBegin_[pairId];
+    }
+    pairEntries_.resize(entryPair_.size());
+    vector<size_t> cursor(pairBegin_.begin(), pairBegin_.end() - 1);
+    for (size_t entry = 0; entry < entryPair_.size(); ++entry) {
+        pairEntries_[cursor[entryPair_[entry]]++] = entry;
+    }
+
+    rankBegin_.assign(rankSize_ + 1, 0);
+    for (size_t pairId = 0; pairId < pairNum; ++pairId) {
+        ++rankBegin_[pairU_[pairId] + 1];
+        ++rankBegin_[pairV_[pairId] + 1];
+    }
+    for (uint32_t rank = 0; rank < rankSize_; ++rank) {
+        rankBegin_[rank + 1] += rankBegin_[rank];
+    }
+    rankPairs_.resize(2 * pairNum);
+    cursor.assign(rankBegin_.begin(), rankBegin_.end() - 1);
+    for (size_t pairId = 0; pairId < pairNum; ++pairId) {
+        rankPairs_[cursor[pairU_[pairId]]++] = static_cast<uint32_t>(pairId);
+        rankPairs_[cursor[pairV_[pairId]]++] = static_cast<uint32_t>(pairId);
+    }
+}
+
+double EdgeAllocator::PhaseMax(uint32_t phaseId) const
+{
+    double maxConflict = 0.0;
+    for (size_t entry = phaseBegin_[phaseId]; entry < phaseBegin_[phaseId + 1]; ++entry) {
+        maxConflict = max(maxConflict, entryLoad_[entry] / edgeNum_[entryPair_[entry]]);
+    }
+    return (maxConflict < MIN_PHASE_CONFLICT) ? 1.0 : maxConflict;
+}
+
+double EdgeAllocator::TotalConflict() const
+{
+    double conflictSum = 0.0;
+    for (uint32_t phaseId = 0; phaseId < phaseNum_; ++phaseId) {
+        conflictSum += PhaseMax(phaseId);
+    }
+    return conflictSum;
+}
+
+double EdgeAllocator::Penalty(uint32_t pairId, uint32_t edgeNum) const
+{
+    return pairWeight_[pairId] / pow(static_cast<double>(edgeNum), options_.smoothness);
+}
+
+void EdgeAllocator::Greedy()
+{
+    // W_e = Σ_k (load_ke / loadScale_)^p，平滑目标 Σ_e W_e / m_e^p 对各对可分，
+    // 一个对的收益只随自身的m变化，堆中的收益始终是准确的
+    pairWeight_.assign(pairU_.size(), 0.0);
+    for (size_t entry = 0; entry < entryPair_.size(); ++entry) {
+        pairWeight_[entryPair_[entry]] += pow(entryLoad_[entry] / loadScale_, options_.smoothness);
+    }
+
+    auto addable = [this](uint32_t pairId) {
+        return spare_[pairU_[pairId]] > 0 && spare_[pairV_[pairId]] > 0;
+    };
+    auto gain = [this](uint32_t pairId) {
+        return Penalty(pairId, edgeNum_[pairId]) - Penalty(pairId, edgeNum_[pairId] + 1);
+    };
+    priority_queue<pair<double, uint32_t>> candidates;
+    for (uint32_t pairId = 0; pairId < pairU_.size(); ++pairId) {
+        if (addable(pairId) && pairWeight_[pairId] > 0.0) {
+            candidates.push(make_pair(gain(pairId), pairId));
+        }
+    }
+    while (!candidates.empty()) {
+        uint32_t pairId = candidates.top().second;
+        candidates.pop();
+        if (!addable(pairId)) {
+            continue;  // 某一端的端口已用完
+        }
+        ++edgeNum_[pairId];
+        --spare_[pairU_[pairId]];
+        --spare_[pairV_[pairId]];
+        if (addable(pairId)) {
+            candidates.push(make_pair(gain(pairId), pairId));
+        }
+    }
+}
+
+double EdgeAllocator::CollectAffected(const uint32_t* pairs, size_t pairNum)
+{
+    // 收集这些对出现过的phase（去重），返回其当前max之和
+    if (++stamp_ == 0) {
+        fill(phaseStamp_.begin(), phaseStamp_.end(), 0);
+        stamp_ = 1;
+    }
+    affected_.clear();
+    double sum = 0.0;
+    for (size_t idx = 0; idx < pairNum; ++idx) {
+        uint32_t pairId = pairs[idx];
+        for (size_t pos = pairBegin_[pairId]; pos < pairBegin_[pairId + 1]; ++pos) {
+            uint32_t phaseId = entryPhase_[pairEntries_[pos]];
+            if (phaseStamp_[phaseId] != stamp_) {
+                phaseStamp_[phaseId] = stamp_;
+                affected_.push_back(phaseId);
+                sum += phaseMax_[phaseId];
+            }
+        }
+    }
+    return sum;
+}
+
+bool EdgeAllocator::TryMove(uint32_t target, uint32_t donorU, uint32_t donorV)
+{
+    // donorU / donorV 为NO_PAIR时对应端点使用空闲端口
+    uint32_t pairs[3] = {target, donorU, donorV};
+    size_t pairNum = 1;
+    for (uint32_t donor : {donorU, donorV}) {
+        if (donor != NO_PAIR) {
+            pairs[pairNum++] = donor;
+        }
+    }
+    double before = CollectAffected(pairs, pairNum);
+    double penaltyBefore = 0.0;
+    for (size_t idx = 0; idx < pairNum; ++idx) {
+        penaltyBefore += Penalty(pairs[idx], edgeNum_[pairs[idx]]);
+    }
+
+    ++edgeNum_[target];
+    for (size_t idx = 1; idx < pairNum; ++idx) {
+        --edgeNum_[pairs[idx]];
+    }
+    double after = 0.0;
+    for (uint32_t phaseId : affected_) {
+        after += PhaseMax(phaseId);
+        work_ += phaseBegin_[phaseId + 1] - phaseBegin_[phaseId];
+    }
+    double penaltyAfter = 0.0;
+    for (size_t idx = 0; idx < pairNum; ++idx) {
+        penaltyAfter += Penalty(pairs[idx], edgeNum_[pairs[idx]]);
+    }
+
+    // 真实目标下降，或真实目标不变而平滑目标下降（多个对并列为瓶颈时逐个改善）
+    bool accept = after < before - MIN_IMPROVEMENT ||
+                  (after <= before + MIN_IMPROVEMENT && penaltyAfter < penaltyBefore * (1.0 - MIN_IMPROVEMENT));
+    if (!accept) {
+        --edgeNum_[target];
+        for (size_t idx = 1; idx < pairNum; ++idx) {
+            ++edgeNum_[pairs[idx]];
+        }
+        return false;
+    }
+    for (uint32_t phaseId : affected_) {
+        phaseMax_[phaseId] = PhaseMax(phaseId);
+    }
+    --spare_[pairU_[target]];
+    --spare_[pairV_[target]];
+    for (size_t idx = 1; idx < pairNum; ++idx) {
+        ++spare_[pairU_[pairs[idx]]];
+        ++spare_[pairV_[pairs[idx]]];
+    }
+    return true;
+}
+
+void EdgeAllocator::LocalSearch()
+{
+    work_ = 0;
+    phaseMax_.resize(phaseNum_);
+    for (uint32_t phaseId = 0; phaseId < phaseNum_; ++phaseId) {
+        phaseMax_[phaseId] = PhaseMax(phaseId);
+    }
+    work_ += entryPair_.size();
+    phaseStamp_.assign(phaseNum_, 0);
+    stamp_ = 0;
+
+    vector<uint32_t> critical;
+    vector<uint8_t> isCritical(pairU_.size(), 0);
+    vector<uint32_t> donors[2];
+    bool improved = true;
+    while (improved && work_ < options_.localSearchBudget) {
+        improved = false;
+        // 当前决定某个phase的max的对
+        critical.clear();
+        fill(isCritical.begin(), isCritical.end(), 0);
+        for (uint32_t phaseId = 0; phaseId < phaseNum_; ++phaseId) {
+            for (size_t entry = phaseBegin_[phaseId]; entry < phaseBegin_[phaseId + 1]; ++entry) {
+                uint32_t pairId = entryPair_[entry];
+                if (!isCritical[pairId] &&
+                    entryLoad_[entry] / edgeNum_[pairId] >= phaseMax_[phaseId] - MIN_IMPROVEMENT) {
+                    isCritical[pairId] = 1;
+                    critical.push_back(pairId);
+                }
+            }
+        }
+        work_ += entryPair_.size();
+
+        // 给瓶颈对加一条边：没有空闲端口的端点从它的另一个对上挪一条边过来
+        for (uint32_t target : critical) {
+            uint32_t ends[2] = {pairU_[target], pairV_[target]};
+            for (int side = 0; side < 2; ++side) {
+                donors[side].clear();
+                if (spare_[ends[side]] > 0) {
+                    donors[side].push_back(NO_PAIR);
+                    continue;
+                }
+                for (size_t idx = rankBegin_[ends[side]]; idx < rankBegin_[ends[side] + 1]; ++idx) {
+                    uint32_t donor = rankPairs_[idx];
+                    if (donor != target && edgeNum_[donor] >= 2) {
+                        donors[side].push_back(donor);
+                    }
+                }
+            }
+            bool moved = false;
+            for (size_t i = 0; i < donors[0].size() && !moved; ++i) {
+                for (size_t j = 0; j < donors[1].size() && !moved; ++j) {
+                    moved = TryMove(target, donors[0][i], donors[1][j]);
+                    if (work_ >= options_.localSearchBudget) {
+                        return;
+                    }
+                }
+            }
+            improved = improved || moved;
+        }
+    }
+}
+
+EdgeAllocation EdgeAllocator::Solve(uint32_t P)
+{
+    while (currentPhase_ < phaseNum_) {
+        FlushPhase();
+    }
+    BuildIndexes();
+
+    EdgeAllocation allocation;
+    allocation.rankSize = rankSize_;
+    allocation.degreeLimit = P;
+
+    // 每对有通信的rank至少一条边
+    size_t pairNum = pairU_.size();
+    edgeNum_.assign(pairNum, 1);
+    vector<uint32_t> degree(rankSize_, 0);
+    for (size_t pairId = 0; pairId < pairNum; ++pairId) {
+        ++degree[pairU_[pairId]];
+        ++degree[pairV_[pairId]];
+    }
+    spare_.assign(rankSize_, 0);
+    for (uint32_t rank = 0; rank < rankSize_; ++rank) {
+        if (degree[rank] > P) {
+            return allocation;
+        }
+        spare_[rank] = P - degree[rank];
+    }
+    allocation.feasible = true;
+    allocation.singleConflictSum = TotalConflict();
+
+    Greedy();
+    if (options_.localSearchBudget > 0) {
+        LocalSearch();
+    }
+
+    allocation.conflictSum = TotalConflict();
+    allocation.degree.assign(rankSize_, 0);
+    allocation.edges.reserve(pairNum);
+    for (size_t pairId = 0; pairId < pairNum; ++pairId) {
+        EdgeCount edge;
+        edge.u = pairU_[pairId];
+        edge.v = pairV_[pairId];
+        edge.m = edgeNum_[pairId];
+        allocation.edges.push_back(edge);
+        allocation.degree[edge.u] += edge.m;
+        allocation.degree[edge.v] += edge.m;
+    }
+    sort(allocation.edges.begin(), allocation.edges.end(), [](const EdgeCount& a, const EdgeCount& b) {
+        return (a.u != b.u) ? a.u < b.u : a.v < b.v;
+    });
+    return allocation;
+}
@@ -0,0 +1,141 @@
+//
+// 物理边分配：在每个rank最多P个端口的预算内，为有通信的rank对分配m(u, v) >= 1条并行边，
+// 使 Σ_k max_{(u,v)} load_k(u->v) / m(u, v) 尽量小（空phase记为1，与评分器一致）。
+//
+// 求解分两步：
+//   1. 贪心：从m = 1出发，每次给平滑目标 Σ_k Σ_e (load_ke / m_e)^p 下降最多的对加一条边，
+//      直到没有两端都有空闲端口的对。p较大时平滑目标由各phase的max主导，且能区分max相同的对
+//   2. 局部搜索：给当前的瓶颈对加一条边，端口不够的端点从它的另一个对上挪一条边过来；
+//      接受使真实目标下降、或真实目标不变而平滑目标下降的移动
+// 结果即光交换机上实际连接的拓扑，可交给BlueprintScorer按该拓扑计算通信时间。
+//
+
+#ifndef CPP_EDGE_ALLOCATOR_H
+#define CPP_EDGE_ALLOCATOR_H
+
+#include "solution.h"
+#include "blueprint_scorer.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct EdgeCount {
+    uint32_t u;  // u < v
+    uint32_t v;
+    uint32_t m;
+};
+
+struct EdgeAllocation {
+    bool feasible{false};  // m = 1 时度数已超过P则为false，其余字段无意义
+    uint32_t rankSize{0};
+    uint32_t degreeLimit{0};
+    std::vector<EdgeCount> edges;   // 按(u, v)排序
+    std::vector<uint32_t> degree;   // 每个rank占用的端口数 Σ_v m(u, v)
+    double conflictSum{0.0};        // 按本分配计算的 Σ max_cr
+    double singleConflictSum{0.0};  // 每对一条边时的 Σ max_cr
+
+    // 无向对上的边数，没有分配时为0
+    uint32_t EdgeNum(uint32_t u, uint32_t v) const;
+};
+
+struct EdgeAllocatorOptions {
+    double smoothness{16.0};            // 贪心阶段平滑目标的指数p，越大越接近max
+    uint64_t localSearchBudget{1 << 26};  // 局部搜索最多访问的 (phase, 对) 条目数，0为不做局部搜索
+};
+
+// 内部状态在多次分配之间复用，非线程安全，每个线程应使用独立的实例
+class EdgeAllocator {
+public:
+    EdgeAllocator() = default;
+    explicit EdgeAllocator(const EdgeAllocatorOptions& options) : options_(options) {}
+
+    void SetOptions(const EdgeAllocatorOptions& options) { options_ = options; }
+    const EdgeAllocatorOptions& GetOptions() const { return options_; }
+
+    // 按Blueprint各phase的流量分配
+    template <typename BlueprintT>
+    EdgeAllocation Allocate(const BlueprintT& bp, uint32_t N, uint32_t P);
+
+    // 直接给定流量：ResetTraffic后按phase非降序调用AddTraffic，最后Solve。
+    // phaseId >= phaseNum 的流量只要求该对有边，不计入目标；自发送忽略。
+    // 只有一个流量矩阵w(u, v)时全部记在phase 0，目标即 max w / m
+    void ResetTraffic(uint32_t N, uint32_t phaseNum);
+    void AddTraffic(uint32_t phaseId, uint32_t srcRank, uint32_t dstRank, double load);
+    EdgeAllocation Solve(uint32_t P);
+
+private:
+    void FlushPhase();
+    uint32_t PairIndex(uint32_t u, uint32_t v);
+    void BuildIndexes();
+
+    // 贪心阶段
+    double Penalty(uint32_t pairId, uint32_t edgeNum) const;
+    void Greedy();
+    // 局部搜索阶段
+    static constexpr uint32_t NO_PAIR = ~0u;
+    double PhaseMax(uint32_t phaseId) const;
+    double CollectAffected(const uint32_t* pairs, size_t pairNum);
+    bool TryMove(uint32_t target, uint32_t donorU, uint32_t donorV);
+    void LocalSearch();
+    double TotalConflict() const;
+
+    EdgeAllocatorOptions options_;
+
+    uint32_t rankSize_{0};
+    uint32_t phaseNum_{0};
+    uint32_t currentPhase_{0};
+    PairTable<double> phaseLoad_;       // 当前phase各有序对上的数据量
+    PairTable<uint32_t> pairIndex_;     // 无向对(min, max) -> 编号 + 1
+    std::vector<uint32_t> pairU_;
+    std::vector<uint32_t> pairV_;
+    std::vector<uint32_t> edgeNum_;     // [pair] 当前的m
+    std::vector<uint32_t> pairStamp_;   // [pair] 最近一次出现的phase + 1，FlushPhase中合并两个方向
+    std::vector<size_t> pairEntry_;
+
+    // 每个phase中各无向对的负载（两个方向取大者），按phase连续存放
+    std::vector<size_t> phaseBegin_;    // [phase + 1]
+    std::vector<uint32_t> entryPair_;
+    std::vector<double> entryLoad_;
+    double loadScale_{1.0};             // 最大的单phase负载，平滑目标按它归一化以免溢出
+    // 每个对出现的条目编号
+    std::vector<size_t> pairBegin_;     // [pair + 1]
+    std::vector<size_t> pairEntries_;
+    std::vector<uint32_t> entryPhase_;
+    // 每个rank参与的对
+    std::vector<size_t> rankBegin_;     // [rank + 1]
+    std::vector<uint32_t> rankPairs_;
+
+    std::vector<double> pairWeight_;    // [pair] Σ_k (load_ke / loadScale_)^p
+    std::vector<double> phaseMax_;      // [phase] 当前真实max
+    std::vector<uint32_t> spare_;       // [rank] 剩余端口数
+    std::vector<uint32_t> phaseStamp_;
+    uint32_t stamp_{0};
+    std::vector<uint32_t> affected_;
+    uint64_t work_{0};
+};
+
+template <typename BlueprintT>
+EdgeAllocation EdgeAllocator::Allocate(const BlueprintT& bp, uint32_t N, uint32_t P)
+{
+    // 与评分器相同，目标中的phase数以第一个plane为准，其余phase中的对只要求有边
+    uint32_t K = bp.empty() ? 0 : static_cast<uint32_t>(bp[0].size());
+    uint32_t phaseNum = 0;
+    for (const auto& schedule : bp) {
+        phaseNum = std::max(phaseNum, static_cast<uint32_t>(schedule.size()));
+    }
+    ResetTraffic(N, K);
+    for (uint32_t phaseId = 0; phaseId < phaseNum; ++phaseId) {
+        for (const auto& schedule : bp) {
+            if (phaseId >= schedule.size()) {
+                continue;
+            }
+            for (const auto& action : schedule[phaseId]) {
+                AddTraffic(phaseId, action.srcRank, action.dstRank, 1.0 / action.chunkNum);
+            }
+        }
+    }
+    return Solve(P);
+}
+
+#endif // CPP_EDGE_ALLOCATOR_H
@@ -1,122 +1,34 @@
 // evaluator_simple.cpp - 支持JSON的评测程序
 #include "solution.h"
+#include "flat_blueprint.h"
+#include "compact_blueprint.h"
+#include "cost_model.h"
+#include "blueprint_scorer.h"
+#include "test_case_loader.h"
+#include "batch_evaluator.h"
 #include <iostream>
-#include <fstream>
 #include <vector>
 #include <chrono>
 #include <cmath>
-#include <map>
 #include <algorithm>
-
-// 如果没有JSON库，使用手动解析
-#ifndef NO_JSON
-
-// 尝试包含JSON库
-#ifdef __has_include
-#  if __has_include(<nlohmann/json.hpp>)
-#    include <nlohmann/json.hpp>
-#    define HAS_JSON 1
-     using json = nlohmann::json;
-#  else
-#    define HAS_JSON 0
-#  endif
-#else
-#  define HAS_JSON 0
-#endif
-
-#else
-#  define HAS_JSON 0
-#endif
+#include <sstream>
 
 using namespace std;
 
-// 评测常量
-constexpr double L = 0.002;  // 阶段启动时延 ms
-constexpr double S = 40.0 * 1024.0 * 1024.0;  // 40 MB
-constexpr double B = 400.0 * 1024.0 * 1024.0 * 1024.0;  // 400 GB/s
-constexpr double BETA = 1.5;
-constexpr double SCORE_MAX = 100.0;
-
-// 手动解析JSON的辅助函数（如果没JSON库）
-#if !HAS_JSON
-vector<pair<uint32_t, uint32_t>> ParseSampleJson(const string& filename) {
-    vector<pair<uint32_t, uint32_t>> test_cases;
-    ifstream file(filename);
-    string line, content;
-    
-    if (!file.is_open()) {
-        cerr << "无法打开文件: " << filename << endl;
-        return test_cases;
-    }
-    
-    // 读取整个文件
-    while (getline(file, line)) {
-        content += line;
-    }
-    file.close();
-    
-    // 简单解析（针对sample.json的格式）
-    size_t pos = content.find("\"test_case_list\"");
-    if (pos == string::npos) {
-        cerr << "找不到test_case_list" << endl;
-        return test_cases;
-    }
-    
-    // 提取数组内容
-    pos = content.find('[', pos);
-    size_t end_pos = content.find(']', pos);
-    
-    if (pos == string::npos || end_pos == string::npos) {
-        cerr << "解析JSON数组失败" << endl;
-        return test_cases;
-    }
-    
-    string array_content = content.substr(pos, end_pos - pos + 1);
-    
-    // 解析每个测试用例
-    pos = 0;
-    while ((pos = array_content.find("\"rank_size\"", pos)) != string::npos) {
-        // 找到rank_size的值
-        size_t colon_pos = array_content.find(':', pos);
-        size_t comma_pos = array_content.find(',', colon_pos);
-        string rank_str = array_content.substr(colon_pos + 1, comma_pos - colon_pos - 1);
-        
-        // 找到plane_num的值
-        pos = array_content.find("\"plane_num\"", comma_pos);
-        colon_pos = array_content.find(':', pos);
-        comma_pos = array_content.find(',', colon_pos);
-        if (comma_pos == string::npos) {
-            comma_pos = array_content.find('}', colon_pos);
-        }
-        string plane_str = array_content.substr(colon_pos + 1, comma_pos - colon_pos - 1);
-        
-        // 转换为数字
-        try {
-            uint32_t rank_size = stoi(rank_str);
-            uint32_t plane_num = stoi(plane_str);
-            test_cases.push_back({rank_size, plane_num});
-        } catch (...) {
-            cerr << "解析数字失败: " << rank_str << ", " << plane_str << endl;
-        }
-    }
-    
-    return test_cases;
-}
-#endif
-
-// 计算理论最小时间
-double CalculateTheoreticalMinTime(uint32_t N, uint32_t P) {
-    double min_phases = N - 1;
-    double T1_min = min_phases * L;
-    double total_data = (N - 1) * S / N;
-    double T2_min = total_data / (B * P);
-    return T1_min + T2_min;
-}
+// 每个评测线程独立的状态，Blueprint存储跨用例复用内存
+struct EvalContext {
+    Solution solution;
+    BlueprintScorer scorer;
+    Blueprint bp;
+    FlatBlueprint flat_bp;
+    CompactBlueprint compact_bp;
+};
 
-// 简单验证Blueprint
-bool ValidateBlueprint(const Blueprint& bp, uint32_t N, uint32_t P) {
+// 简单验证Blueprint（Blueprint与FlatBlueprint均可）
+template <typename BlueprintT>
+bool ValidateBlueprint(const BlueprintT& bp, uint32_t N, uint32_t P, ostream& out) {
     if (bp.size() != P) {
-        cerr << "错误: Plane数量不正确 (" << bp.size() << " != " << P << ")" << endl;
+        out << "错误: Plane数量不正确 (" << bp.size() << " != " << P << ")" << endl;
         return false;
     }
     
@@ -125,7 +37,7 @@ bool ValidateBlueprint(const Blueprint& bp, uint32_t N, uint32_t P) {
     size_t expected_phases = bp[0].size();
     for (size_t p = 1; p < bp.size(); ++p) {
         if (bp[p].size() != expected_phases) {
-            cerr << "错误: plane " << p << "的phase数不一致" << endl;
+            out << "错误: plane " << p << "的phase数不一致" << endl;
             return false;
         }
     }
@@ -133,107 +45,159 @@ bool ValidateBlueprint(const Blueprint& bp, uint32_t N, uint32_t P) {
     return true;
 }
 
-// 计算得分
-double CalculateScore(double T, double T_min) {
-    if (T <= T_min) return SCORE_MAX;
-    double ratio = T / T_min;
-    return SCORE_MAX * exp(-BETA * (ratio - 1));
-}
-
-int main() {
-    cout << "=== Reduce Scatter 评测系统 ===" << endl;
+int main(int argc, char* argv[]) {
+    // --flat: 使用FlatBlueprint构造和评分
+    // --compact: 使用CompactBlueprint构造和评分
+    // --algo <auto|ring|halving|multiring|chunkedring|hierarchical>: 指定调度算法族，默认按代价模型自动选择
+    // --pipeline <D>: chunkedring的流水深度
+    // --threads <T>: 生成Blueprint的线程数（0为全部硬件线程）
+    // --cases <path>: 测试用例文件，默认sample.json
+    // --jobs <J>: 同时评测的用例数（0为全部硬件线程），输出顺序与J无关
+    bool use_flat = false;
+    bool use_compact = false;
+    ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO;
+    ScheduleOptions options;
+    bool algorithm_forced = false;
+    string cases_path = "sample.json";
+    uint32_t job_num = 1;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--flat") {
+            use_flat = true;
+        } else if (arg == "--compact") {
+            use_compact = true;
+        } else if (arg == "--algo" && i + 1 < argc) {
+            if (!ParseScheduleAlgorithm(argv[++i], algorithm)) {
+                cerr << "未知算法: " << argv[i] << endl;
+                return 1;
+            }
+            algorithm_forced = true;
+        } else if (arg == "--pipeline" && i + 1 < argc) {
+            options.pipelineDepth = static_cast<uint32_t>(stoul(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threadNum = static_cast<uint32_t>(stoul(argv[++i]));
+        } else if (arg == "--cases" && i + 1 < argc) {
+            cases_path = argv[++i];
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            job_num = static_cast<uint32_t>(stoul(argv[++i]));
+        }
+    }
     
-    vector<pair<uint32_t, uint32_t>> test_cases;
+    cout << "=== Reduce Scatter 评测系统 ===" << endl;
     
-#if HAS_JSON
-    // 使用JSON库解析
-    try {
-        ifstream file("sample.json");
-        if (!file.is_open()) {
-            cerr << "无法打开 sample.json" << endl;
-            return 1;
-        }
-        
-        json data;
-        file >> data;
-        file.close();
-        
-        auto json_cases = data["test_case_list"];
-        for (const auto& tc : json_cases) {
-            test_cases.push_back({tc["rank_size"], tc["plane_num"]});
-        }
-        cout << "使用JSON库解析 sample.json" << endl;
-        
-    } catch (const exception& e) {
-        cerr << "JSON解析错误: " << e.what() << endl;
+    // 流式读取测试用例，读出一个评测一个；各线程独立生成与评分，报告按用例顺序输出
+    TestCaseReader reader;
+    string error;
+    if (!reader.Open(cases_path, &error)) {
+        cerr << error << endl;
         return 1;
     }
-#else
-    // 手动解析
-    cout << "使用手动解析 sample.json" << endl;
-    test_cases = ParseSampleJson("sample.json");
-    if (test_cases.empty()) {
-        cerr << "解析测试用例失败，使用默认测试用例" << endl;
-        test_cases = {
-            {4, 2}, {4, 6}, {5, 2}, {5, 4}, {10, 4},
-            {10, 10}, {32, 6}, {33, 4}, {64, 8}, {128, 18}
-        };
-    }
-#endif
-    
-    cout << "找到 " << test_cases.size() << " 个测试用例" << endl;
     
-    Solution solution;
+    BatchEvaluator batch(job_num);
+    vector<EvalContext> contexts(batch.JobNum());
+    for (auto& ctx : contexts) {
+        ctx.solution.SetScheduleOptions(options);
+    }
     double total_score = 0.0;
     
-    for (size_t i = 0; i < test_cases.size(); i++) {
-        uint32_t N = test_cases[i].first;
-        uint32_t P = test_cases[i].second;
+    auto next_case = [&](TestCase& test_case) { return reader.Next(test_case); };
+    auto evaluate = [&](uint32_t worker_id, CaseResult& result) {
+        EvalContext& ctx = contexts[worker_id];
+        const TestCase& test_case = result.testCase;
+        uint32_t N = test_case.rankSize;
+        uint32_t P = test_case.planeNum;
+        const CostModel& cost_model = test_case.costModel;
+        ctx.solution.SetCostModel(cost_model);
+        ctx.scorer.SetCostModel(cost_model);
+        // 命令行的--algo优先于用例中的算法提示
+        ScheduleAlgorithm case_algorithm = (test_case.hasAlgorithm && !algorithm_forced) ? test_case.algorithm : algorithm;
         
-        cout << "\n[用例 " << (i+1) << "] N=" << N << ", P=" << P << endl;
+        ostringstream out;
+        out << "\n[用例 " << (result.index + 1) << "] N=" << N << ", P=" << P << endl;
         
         // 运行算法
         auto start = chrono::high_resolution_clock::now();
-        Blueprint bp = solution.ConstructBluePrint(N, P);
+        string construct_error;
+        if (use_compact) {
+            if (!ctx.solution.ConstructBluePrint(N, P, ctx.compact_bp, case_algorithm, &construct_error)) {
+                out << "  " << construct_error << "，跳过评分" << endl;
+                result.report = out.str();
+                return;
+            }
+        } else if (use_flat) {
+            ctx.solution.ConstructBluePrint(N, P, ctx.flat_bp, case_algorithm);
+        } else {
+            ctx.bp = ctx.solution.ConstructBluePrint(N, P, case_algorithm);
+        }
         auto end = chrono::high_resolution_clock::now();
         auto duration = chrono::duration_cast<chrono::microseconds>(end - start);
         
         // 验证
-        if (!ValidateBlueprint(bp, N, P)) {
-            cout << "  验证失败，跳过评分" << endl;
-            continue;
+        bool valid;
+        if (use_compact) {
+            valid = ValidateBlueprint(ctx.compact_bp, N, P, out);
+        } else if (use_flat) {
+            valid = ValidateBlueprint(ctx.flat_bp, N, P, out);
+        } else {
+            valid = ValidateBlueprint(ctx.bp, N, P, out);
+        }
+        if (!valid) {
+            out << "  验证失败，跳过评分" << endl;
+            result.report = out.str();
+            return;
         }
         
-        // 计算阶段数
-        uint32_t K = bp.empty() ? 0 : bp[0].size();
-        
-        // 简单估算通信时间（简化版）
-        double T1 = K * L;
-        
-        // 简化估算T2：假设理想情况
-        double total_data = (N - 1) * S / N;
-        double T2_simple = total_data / (B * P);
-        
-        // 实际时间会比理想情况差一些，这里用启发式估算
-        double efficiency = 0.7; // 假设70%效率
-        double T2 = T2_simple / efficiency;
-        
-        double T = T1 + T2;
-        double T_min = CalculateTheoreticalMinTime(N, P);
-        double score = CalculateScore(T, T_min);
+        // 与test_simple相同的评分规则（见 blueprint_scorer.h）
+        uint32_t K;
+        double T;
+        if (use_compact) {
+            K = ctx.compact_bp.empty() ? 0 : ctx.compact_bp[0].size();
+            T = ctx.scorer.CalculateCommunicationTime(ctx.compact_bp, N, P);
+        } else if (use_flat) {
+            K = ctx.flat_bp.empty() ? 0 : ctx.flat_bp[0].size();
+            T = ctx.scorer.CalculateCommunicationTime(ctx.flat_bp, N, P);
+        } else {
+            K = ctx.bp.empty() ? 0 : ctx.bp[0].size();
+            T = ctx.scorer.CalculateCommunicationTime(ctx.bp, N, P);
+        }
         
-        cout << "  耗时: " << duration.count() / 1000.0 << " ms" << endl;
-        cout << "  阶段数: " << K << endl;
-        cout << "  估算通信时间: " << T << " ms" << endl;
-        cout << "  理论最小时间: " << T_min << " ms" << endl;
-        cout << "  得分: " << score << "/100" << endl;
+        out << "  耗时: " << duration.count() / 1000.0 << " ms" << endl;
+        out << "  阶段数: " << K << endl;
+        if (isinf(T)) {
+            out << "  有通信的plane或跨节点链路带宽为0，得0分" << endl;
+            result.report = out.str();
+            return;
+        }
+        if (T >= INVALID_COMMUNICATION_TIME) {
+            out << "  无效方案（度数超过P），得0分" << endl;
+            result.report = out.str();
+            return;
+        }
+        double T_min = CalcTheoreticalMinTime(N, P, cost_model);
+        result.score = CalcScore(T, T_min);
         
-        total_score += score;
+        out << "  通信时间: " << T << " ms" << endl;
+        out << "  理论最小时间: " << T_min << " ms" << endl;
+        out << "  得分: " << result.score << "/100" << endl;
+        result.report = out.str();
+    };
+    auto report = [&](const CaseResult& result) {
+        cout << result.report;
+        total_score += result.score;
+    };
+    size_t case_count = batch.Run(next_case, evaluate, report);
+    
+    if (!reader.Error().empty()) {
+        cerr << "用例文件解析错误: " << reader.Error() << endl;
+    }
+    if (case_count == 0) {
+        cerr << "没有可评测的测试用例" << endl;
+        return 1;
     }
     
     cout << "\n=== 评测结果 ===" << endl;
-    cout << "总得分: " << total_score << "/" << (test_cases.size() * 100) << endl;
-    cout << "平均分: " << (total_score / test_cases.size()) << endl;
+    cout << "总得分: " << total_score << "/" << (case_count * 100) << endl;
+    cout << "平均分: " << (total_score / case_count) << endl;
     
     return 0;
 }
\ No newline at end of file
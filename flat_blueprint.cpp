@@ -0,0 +1,92 @@
+//
+// 扁平化Blueprint实现
+//
+
+#include "flat_blueprint.h"
+
+using namespace std;
+
+void FlatBlueprint::Clear()
+{
+    actions_.clear();
+    phaseOffsets_.clear();
+    planeOffsets_.clear();
+}
+
+void FlatBlueprint::Reserve(size_t planeNum, size_t phaseNum, size_t actionNum)
+{
+    planeOffsets_.reserve(planeNum);
+    phaseOffsets_.reserve(phaseNum);
+    actions_.reserve(actionNum);
+}
+
+void FlatBlueprint::AddPlane()
+{
+    planeOffsets_.push_back(phaseOffsets_.size());
+}
+
+void FlatBlueprint::AddPhase()
+{
+    phaseOffsets_.push_back(actions_.size());
+}
+
+void FlatBlueprint::Allocate(size_t planeNum, size_t phaseNum, const vector<size_t>& actionNums, bool)
+{
+    planeOffsets_.resize(planeNum);
+    phaseOffsets_.resize(planeNum * phaseNum);
+    size_t actionNum = 0;
+    for (size_t planeId = 0; planeId < planeNum; ++planeId) {
+        planeOffsets_[planeId] = planeId * phaseNum;
+        for (size_t phaseId = 0; phaseId < phaseNum; ++phaseId) {
+            size_t globalPhaseId = planeId * phaseNum + phaseId;
+            phaseOffsets_[globalPhaseId] = actionNum;
+            actionNum += actionNums[globalPhaseId];
+        }
+    }
+    actions_.resize(actionNum);
+}
+
+size_t FlatBlueprint::MemoryBytes() const
+{
+    return actions_.capacity() * sizeof(Action) +
+           (phaseOffsets_.capacity() + planeOffsets_.capacity()) * sizeof(size_t);
+}
+
+Blueprint FlatBlueprint::ToBlueprint() const
+{
+    Blueprint blueprint(size());
+    for (size_t planeId = 0; planeId < size(); ++planeId) {
+        Schedule& schedule = blueprint[planeId];
+        schedule.resize(PhaseNum(planeId));
+        for (size_t phaseId = 0; phaseId < schedule.size(); ++phaseId) {
+            PhaseView phase = GetPhase(planeId, phaseId);
+            schedule[phaseId].assign(phase.begin(), phase.end());
+        }
+    }
+    return blueprint;
+}
+
+FlatBlueprint FlatBlueprint::FromBlueprint(const Blueprint& blueprint)
+{
+    size_t phaseNum = 0;
+    size_t actionNum = 0;
+    for (const auto& schedule : blueprint) {
+        phaseNum += schedule.size();
+        for (const auto& phase : schedule) {
+            actionNum += phase.size();
+        }
+    }
+
+    FlatBlueprint flat;
+    flat.Reserve(blueprint.size(), phaseNum, actionNum);
+    for (const auto& schedule : blueprint) {
+        flat.AddPlane();
+        for (const auto& phase : schedule) {
+            flat.AddPhase();
+            for (const auto& action : phase) {
+                flat.AddAction(action);
+            }
+        }
+    }
+    return flat;
+}
@@ -0,0 +1,165 @@
+//
+// 扁平化Blueprint存储：所有Action放在一块连续内存中，
+// 通过plane/phase偏移表定位，避免三层vector带来的大量小块分配。
+//
+
+#ifndef CPP_FLAT_BLUEPRINT_H
+#define CPP_FLAT_BLUEPRINT_H
+
+#include "solution.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// 只读的连续区间视图（类似std::span）
+template <typename T>
+class ArrayView {
+public:
+    using value_type = T;
+    using const_iterator = const T*;
+
+    ArrayView() : data_(nullptr), size_(0) {}
+    ArrayView(const T* data, size_t size) : data_(data), size_(size) {}
+
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T& operator[](size_t idx) const { return data_[idx]; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+
+private:
+    const T* data_;
+    size_t size_;
+};
+
+// 按下标访问容器的只读迭代器，解引用时按值返回视图
+template <typename Container, typename Value>
+class IndexIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Value;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Value;
+
+    IndexIterator(const Container* container, size_t idx) : container_(container), idx_(idx) {}
+
+    Value operator*() const { return (*container_)[idx_]; }
+    IndexIterator& operator++() { ++idx_; return *this; }
+    IndexIterator operator++(int) { IndexIterator tmp(*this); ++idx_; return tmp; }
+    bool operator==(const IndexIterator& other) const { return idx_ == other.idx_; }
+    bool operator!=(const IndexIterator& other) const { return idx_ != other.idx_; }
+
+private:
+    const Container* container_;
+    size_t idx_;
+};
+
+using PhaseView = ArrayView<Action>;
+
+class FlatBlueprint;
+
+// 单个plane的schedule视图，接口与Schedule一致
+class ScheduleView {
+public:
+    using const_iterator = IndexIterator<ScheduleView, PhaseView>;
+
+    ScheduleView(const FlatBlueprint* blueprint, uint32_t planeId) : blueprint_(blueprint), planeId_(planeId) {}
+
+    uint32_t PlaneId() const { return planeId_; }
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    PhaseView operator[](size_t phaseId) const;
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+private:
+    const FlatBlueprint* blueprint_;
+    uint32_t planeId_;
+};
+
+// 扁平Blueprint
+// actions_      : 所有Action，按 plane -> phase -> action 顺序连续存放
+// phaseOffsets_ : 第g个phase（全局编号）在actions_中的起始位置
+// planeOffsets_ : 第p个plane的首个phase的全局编号
+// 最后一个phase/plane的结束位置即actions_/phaseOffsets_的长度
+// 下标访问方式与Blueprint相同：bp[plane][phase][action]
+class FlatBlueprint {
+public:
+    using const_iterator = IndexIterator<FlatBlueprint, ScheduleView>;
+
+    FlatBlueprint() = default;
+
+    // 清空内容但保留已分配的容量，便于重复构造时复用内存
+    void Clear();
+    void Reserve(size_t planeNum, size_t phaseNum, size_t actionNum);
+
+    // 追加式构造：依次 AddPlane -> AddPhase -> AddAction
+    void AddPlane();
+    void AddPhase();
+    void AddAction(const Action& action) { actions_.push_back(action); }
+
+    // 预分配式构造：共planeNum个plane、每个plane有phaseNum个phase，
+    // 第p个plane第k个phase有actionNums[p * phaseNum + k]个action；
+    // 之后用SetAction按位置写入，不同phase可由不同线程并发写入
+    void Allocate(size_t planeNum, size_t phaseNum, const std::vector<size_t>& actionNums, bool chunked = false);
+    void SetAction(size_t planeId, size_t phaseId, size_t actionId, const Action& action)
+    {
+        actions_[phaseOffsets_[planeOffsets_[planeId] + phaseId] + actionId] = action;
+    }
+
+    size_t size() const { return planeOffsets_.size(); }
+    bool empty() const { return size() == 0; }
+    ScheduleView operator[](size_t planeId) const { return ScheduleView(this, static_cast<uint32_t>(planeId)); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    size_t PhaseNum(size_t planeId) const { return PlaneEnd(planeId) - planeOffsets_[planeId]; }
+    PhaseView GetPhase(size_t planeId, size_t phaseId) const
+    {
+        size_t globalPhaseId = planeOffsets_[planeId] + phaseId;
+        size_t begin = phaseOffsets_[globalPhaseId];
+        return PhaseView(actions_.data() + begin, PhaseEnd(globalPhaseId) - begin);
+    }
+    const Action& GetAction(size_t planeId, size_t phaseId, size_t actionId) const
+    {
+        return actions_[phaseOffsets_[planeOffsets_[planeId] + phaseId] + actionId];
+    }
+
+    size_t TotalPhaseNum() const { return phaseOffsets_.size(); }
+    size_t TotalActionNum() const { return actions_.size(); }
+    const std::vector<Action>& Actions() const { return actions_; }
+    size_t MemoryBytes() const;
+
+    // 与三层vector的Blueprint互相转换
+    Blueprint ToBlueprint() const;
+    static FlatBlueprint FromBlueprint(const Blueprint& blueprint);
+
+private:
+    size_t PlaneEnd(size_t planeId) const
+    {
+        return (planeId + 1 < planeOffsets_.size()) ? planeOffsets_[planeId + 1] : phaseOffsets_.size();
+    }
+    size_t PhaseEnd(size_t globalPhaseId) const
+    {
+        return (globalPhaseId + 1 < phaseOffsets_.size()) ? phaseOffsets_[globalPhaseId + 1] : actions_.size();
+    }
+
+    std::vector<Action> actions_;
+    std::vector<size_t> phaseOffsets_;
+    std::vector<size_t> planeOffsets_;
+};
+
+inline size_t ScheduleView::size() const
+{
+    return blueprint_->PhaseNum(planeId_);
+}
+
+inline PhaseView ScheduleView::operator[](size_t phaseId) const
+{
+    return blueprint_->GetPhase(planeId_, phaseId);
+}
+
+#endif // CPP_FLAT_BLUEPRINT_H
@@ -0,0 +1,240 @@
+//
+// 热路径计时与计数实现
+//
+
+#include "instrumentation.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+namespace Instrumentation {
+
+namespace {
+
+constexpr const size_t COUNTER_NUM = static_cast<size_t>(Counter::COUNT);
+
+struct TimerAccumulator {
+    uint64_t calls{0};
+    int64_t totalNs{0};
+    int64_t maxNs{0};
+};
+
+// 只由所属线程写入；计数器用relaxed原子读写，计时记录由mutex保护，
+// 所属线程之外只有Collect/Reset会获取该锁，平时没有竞争
+struct ThreadRecorder {
+    uint32_t threadId{0};
+    atomic<uint64_t> counters[COUNTER_NUM];
+    mutex lock;
+    unordered_map<const char*, TimerAccumulator> timers;  // 以名字的指针为键，读取时再按内容合并
+    vector<TraceEvent> events;
+    uint64_t droppedEvents{0};
+
+    ThreadRecorder()
+    {
+        for (auto& counter : counters) {
+            counter.store(0, memory_order_relaxed);
+        }
+    }
+};
+
+// 线程退出后其记录仍保留在这里，直到进程结束
+struct Registry {
+    mutex lock;
+    vector<unique_ptr<ThreadRecorder>> recorders;
+};
+
+Registry& GetRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+ThreadRecorder& LocalRecorder()
+{
+    thread_local ThreadRecorder* recorder = nullptr;
+    if (recorder == nullptr) {
+        Registry& registry = GetRegistry();
+        lock_guard<mutex> guard(registry.lock);
+        registry.recorders.emplace_back(new ThreadRecorder());
+        recorder = registry.recorders.back().get();
+        recorder->threadId = static_cast<uint32_t>(registry.recorders.size() - 1);
+    }
+    return *recorder;
+}
+
+void WriteString(ostream& out, const string& value)
+{
+    out << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+double NsToMs(int64_t ns)
+{
+    return static_cast<double>(ns) / 1e6;
+}
+
+double NsToUs(int64_t ns)
+{
+    return static_cast<double>(ns) / 1e3;
+}
+
+} // namespace
+
+const char* CounterName(Counter counter)
+{
+    switch (counter) {
+        case Counter::PHASES_BUILT:
+            return "phases_built";
+        case Counter::ACTIONS_EMITTED:
+            return "actions_emitted";
+        case Counter::BYTES_ALLOCATED:
+            return "bytes_allocated";
+        case Counter::CACHE_HITS:
+            return "cache_hits";
+        case Counter::CACHE_MISSES:
+            return "cache_misses";
+        case Counter::COUNT:
+            break;
+    }
+    return "unknown";
+}
+
+int64_t NowNs()
+{
+    static const chrono::steady_clock::time_point EPOCH = chrono::steady_clock::now();
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - EPOCH).count();
+}
+
+void Add(Counter counter, uint64_t value)
+{
+    atomic<uint64_t>& slot = LocalRecorder().counters[static_cast<size_t>(counter)];
+    slot.store(slot.load(memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+void Record(const char* name, int64_t startNs, int64_t durationNs)
+{
+    ThreadRecorder& recorder = LocalRecorder();
+    lock_guard<mutex> guard(recorder.lock);
+    TimerAccumulator& timer = recorder.timers[name];
+    ++timer.calls;
+    timer.totalNs += durationNs;
+    timer.maxNs = max(timer.maxNs, durationNs);
+    if (recorder.events.size() < MAX_EVENTS_PER_THREAD) {
+        TraceEvent event;
+        event.name = name;
+        event.threadId = recorder.threadId;
+        event.startNs = startNs;
+        event.durationNs = durationNs;
+        recorder.events.push_back(event);
+    } else {
+        ++recorder.droppedEvents;
+    }
+}
+
+Snapshot Collect()
+{
+    Snapshot snapshot;
+    map<string, TimerStats> timers;
+    Registry& registry = GetRegistry();
+    lock_guard<mutex> registryGuard(registry.lock);
+    snapshot.threadNum = registry.recorders.size();
+    for (const auto& recorder : registry.recorders) {
+        for (size_t counter = 0; counter < COUNTER_NUM; ++counter) {
+            snapshot.counters[counter] += recorder->counters[counter].load(memory_order_relaxed);
+        }
+        lock_guard<mutex> guard(recorder->lock);
+        for (const auto& entry : recorder->timers) {
+            TimerStats& stats = timers[entry.first];
+            stats.calls += entry.second.calls;
+            stats.totalMs += NsToMs(entry.second.totalNs);
+            stats.maxMs = max(stats.maxMs, NsToMs(entry.second.maxNs));
+        }
+        snapshot.events.insert(snapshot.events.end(), recorder->events.begin(), recorder->events.end());
+        snapshot.droppedEvents += recorder->droppedEvents;
+    }
+
+    for (auto& entry : timers) {
+        entry.second.name = entry.first;
+        snapshot.timers.push_back(entry.second);
+    }
+    sort(snapshot.timers.begin(), snapshot.timers.end(),
+         [](const TimerStats& a, const TimerStats& b) { return a.totalMs > b.totalMs; });
+    sort(snapshot.events.begin(), snapshot.events.end(),
+         [](const TraceEvent& a, const TraceEvent& b) { return a.startNs < b.startNs; });
+    return snapshot;
+}
+
+void Reset()
+{
+    Registry& registry = GetRegistry();
+    lock_guard<mutex> registryGuard(registry.lock);
+    for (const auto& recorder : registry.recorders) {
+        for (auto& counter : recorder->counters) {
+            counter.store(0, memory_order_relaxed);
+        }
+        lock_guard<mutex> guard(recorder->lock);
+        recorder->timers.clear();
+        recorder->events.clear();
+        recorder->droppedEvents = 0;
+    }
+}
+
+void WriteJson(const Snapshot& snapshot, ostream& out)
+{
+    out << "{\"enabled\":" << (INSTRUMENTATION_ENABLED ? "true" : "false")
+        << ",\"threads\":" << snapshot.threadNum << ",\"dropped_events\":" << snapshot.droppedEvents
+        << ",\"counters\":{";
+    for (size_t counter = 0; counter < COUNTER_NUM; ++counter) {
+        out << (counter == 0 ? "" : ",") << '"' << CounterName(static_cast<Counter>(counter))
+            << "\":" << snapshot.counters[counter];
+    }
+    out << "},\"timers\":[";
+    for (size_t i = 0; i < snapshot.timers.size(); ++i) {
+        const TimerStats& timer = snapshot.timers[i];
+        out << (i == 0 ? "" : ",") << "{\"name\":";
+        WriteString(out, timer.name);
+        out << ",\"calls\":" << timer.calls << ",\"total_ms\":" << timer.totalMs << ",\"max_ms\":" << timer.maxMs
+            << "}";
+    }
+    out << "]}" << endl;
+}
+
+void WriteChromeTrace(const Snapshot& snapshot, ostream& out)
+{
+    // 计时记录为完整事件（ph = X），计数器的最终值作为计数事件（ph = C）放在最后一次记录结束时
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    int64_t endNs = 0;
+    bool first = true;
+    for (const TraceEvent& event : snapshot.events) {
+        out << (first ? "" : ",") << "\n{\"name\":";
+        WriteString(out, event.name);
+        out << ",\"cat\":\"blueprint\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.threadId
+            << ",\"ts\":" << NsToUs(event.startNs) << ",\"dur\":" << NsToUs(event.durationNs) << "}";
+        endNs = max(endNs, event.startNs + event.durationNs);
+        first = false;
+    }
+    for (size_t counter = 0; counter < COUNTER_NUM; ++counter) {
+        const char* name = CounterName(static_cast<Counter>(counter));
+        out << (first ? "" : ",") << "\n{\"name\":\"" << name << "\",\"ph\":\"C\",\"pid\":0,\"tid\":0,\"ts\":"
+            << NsToUs(endNs) << ",\"args\":{\"" << name << "\":" << snapshot.counters[counter] << "}}";
+        first = false;
+    }
+    out << "\n]}" << endl;
+}
+
+} // namespace Instrumentation
@@ -0,0 +1,103 @@
+//
+// 热路径计时与计数：作用域计时器与计数器，每个线程写各自的累加器，读取时合并。
+// 以 -DENABLE_INSTRUMENTATION 编译时生效（compile.sh 中 INSTRUMENT=1），
+// 否则 INSTRUMENT_SCOPE / INSTRUMENT_COUNT 展开为空，计数表达式不会被求值，没有任何开销。
+// 结果可输出为JSON汇总，或Chrome trace-event格式（chrome://tracing、Perfetto可直接打开）。
+//
+
+#ifndef CPP_INSTRUMENTATION_H
+#define CPP_INSTRUMENTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef ENABLE_INSTRUMENTATION
+#  define INSTRUMENTATION_ENABLED 1
+#else
+#  define INSTRUMENTATION_ENABLED 0
+#endif
+
+namespace Instrumentation {
+
+enum class Counter {
+    PHASES_BUILT,     // 生成的(plane, phase)单元数
+    ACTIONS_EMITTED,  // 写入的action数
+    BYTES_ALLOCATED,  // Blueprint存储新增的容量（字节），复用已有内存时不计
+    CACHE_HITS,       // BlueprintCache命中
+    CACHE_MISSES,     // BlueprintCache未命中
+    COUNT
+};
+
+const char* CounterName(Counter counter);
+
+// 单个计时器名下的合并结果
+struct TimerStats {
+    std::string name;
+    uint64_t calls{0};
+    double totalMs{0.0};
+    double maxMs{0.0};
+};
+
+// 一次计时的原始记录，用于trace-event输出
+struct TraceEvent {
+    const char* name;
+    uint32_t threadId;  // 按线程首次记录的顺序编号，从0开始
+    int64_t startNs;    // 相对进程内第一次记录
+    int64_t durationNs;
+};
+
+struct Snapshot {
+    uint64_t counters[static_cast<size_t>(Counter::COUNT)]{};
+    std::vector<TimerStats> timers;  // 按totalMs降序
+    std::vector<TraceEvent> events;  // 按startNs升序
+    size_t threadNum{0};
+    uint64_t droppedEvents{0};       // 超过MAX_EVENTS_PER_THREAD后只计入汇总的记录数
+};
+
+// 每个线程保留的原始记录上限，超过后只累加汇总，内存有界
+constexpr const size_t MAX_EVENTS_PER_THREAD = 1 << 16;
+
+void Add(Counter counter, uint64_t value);
+// name须为静态字符串，只保存指针
+void Record(const char* name, int64_t startNs, int64_t durationNs);
+int64_t NowNs();
+
+// 合并所有线程（包括已退出的线程）的累加器
+Snapshot Collect();
+// 清零所有累加器；应在没有线程正在记录时调用
+void Reset();
+
+void WriteJson(const Snapshot& snapshot, std::ostream& out);
+void WriteChromeTrace(const Snapshot& snapshot, std::ostream& out);
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* name) : name_(name), startNs_(NowNs()) {}
+    ~ScopedTimer() { Record(name_, startNs_, NowNs() - startNs_); }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* name_;
+    int64_t startNs_;
+};
+
+} // namespace Instrumentation
+
+#define INSTRUMENT_CONCAT_INNER(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT_INNER(a, b)
+
+#if INSTRUMENTATION_ENABLED
+#  define INSTRUMENT_SCOPE(name) \
+       ::Instrumentation::ScopedTimer INSTRUMENT_CONCAT(instrumentScope_, __LINE__)(name)
+#  define INSTRUMENT_COUNT(counter, value) \
+       ::Instrumentation::Add(::Instrumentation::Counter::counter, static_cast<uint64_t>(value))
+#else
+#  define INSTRUMENT_SCOPE(name) ((void)0)
+#  define INSTRUMENT_COUNT(counter, value) ((void)0)
+#endif
+
+#endif // CPP_INSTRUMENTATION_H
@@ -0,0 +1,130 @@
+//
+// 按需计算的Blueprint实现
+//
+
+#include "lazy_blueprint.h"
+
+using namespace std;
+using namespace SolutionUtils;
+
+LazyBlueprint::LazyBlueprint(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm,
+                             const ScheduleOptions& options)
+    : rankSize_(rankSize),
+      planeNum_(planeNum),
+      algorithm_(ResolveFeasibleAlgorithm(rankSize, planeNum, algorithm, options)),
+      phaseNum_(0),
+      ring_(rankSize),
+      halving_(rankSize, planeNum),
+      chunked_(rankSize, planeNum, CalcPipelineDepth(algorithm_, options), options.ringNum, options.planeWeights),
+      hierarchical_(rankSize, planeNum, options.ranksPerNode)
+{
+    switch (algorithm_) {
+        case ScheduleAlgorithm::HALVING:
+            phaseNum_ = halving_.PhaseNum();
+            break;
+        case ScheduleAlgorithm::MULTI_RING:
+        case ScheduleAlgorithm::CHUNKED_RING:
+            phaseNum_ = chunked_.PhaseNum();
+            break;
+        case ScheduleAlgorithm::HIERARCHICAL:
+            phaseNum_ = hierarchical_.PhaseNum();
+            break;
+        default:
+            phaseNum_ = ring_.PhaseNum();
+            break;
+    }
+}
+
+uint32_t LazyBlueprint::ActionNum(uint32_t rankId, uint32_t planeId, uint32_t phaseId) const
+{
+    switch (algorithm_) {
+        case ScheduleAlgorithm::HALVING:
+            return halving_.RankActionNum(planeId, phaseId, rankId);
+        case ScheduleAlgorithm::MULTI_RING:
+        case ScheduleAlgorithm::CHUNKED_RING:
+            return chunked_.RankActionNum(planeId, phaseId, rankId);
+        case ScheduleAlgorithm::HIERARCHICAL:
+            return hierarchical_.RankActionNum(planeId, phaseId, rankId);
+        default:
+            return ring_.RankActionNum(planeId, phaseId, rankId);
+    }
+}
+
+Action LazyBlueprint::GetAction(uint32_t rankId, uint32_t planeId, uint32_t phaseId, uint32_t actionIdx) const
+{
+    switch (algorithm_) {
+        case ScheduleAlgorithm::HALVING:
+            return halving_.RankAction(planeId, phaseId, rankId, actionIdx);
+        case ScheduleAlgorithm::MULTI_RING:
+        case ScheduleAlgorithm::CHUNKED_RING:
+            return chunked_.RankAction(planeId, phaseId, rankId, actionIdx);
+        case ScheduleAlgorithm::HIERARCHICAL:
+            return hierarchical_.RankAction(planeId, phaseId, rankId, actionIdx);
+        default:
+            return ring_.RankAction(planeId, phaseId, rankId, actionIdx);
+    }
+}
+
+size_t LazyBlueprint::PhaseActionNum(uint32_t planeId, uint32_t phaseId) const
+{
+    switch (algorithm_) {
+        case ScheduleAlgorithm::HALVING:
+            return halving_.ActionNum(planeId, phaseId);
+        case ScheduleAlgorithm::MULTI_RING:
+        case ScheduleAlgorithm::CHUNKED_RING:
+            return chunked_.ActionNum(planeId, phaseId);
+        case ScheduleAlgorithm::HIERARCHICAL:
+            return hierarchical_.ActionNum(planeId, phaseId);
+        default:
+            return ring_.ActionNum(planeId, phaseId);
+    }
+}
+
+RankActionRange LazyBlueprint::RankActions(uint32_t rankId) const
+{
+    return RankActionRange(RankActionIterator(this, rankId, 0, planeNum_),
+                           RankActionIterator(this, rankId, planeNum_, planeNum_));
+}
+
+RankActionRange LazyBlueprint::RankActions(uint32_t rankId, uint32_t planeId) const
+{
+    return RankActionRange(RankActionIterator(this, rankId, planeId, planeId + 1),
+                           RankActionIterator(this, rankId, planeId + 1, planeId + 1));
+}
+
+RankActionIterator::RankActionIterator(const LazyBlueprint* blueprint, uint32_t rankId, uint32_t planeId,
+                                       uint32_t planeEnd)
+    : blueprint_(blueprint), rankId_(rankId), planeId_(planeId), planeEnd_(planeEnd)
+{
+    SkipEmpty();
+}
+
+Action RankActionIterator::operator*() const
+{
+    return blueprint_->GetAction(rankId_, planeId_, phaseId_, actionIdx_);
+}
+
+RankActionIterator& RankActionIterator::operator++()
+{
+    ++actionIdx_;
+    SkipEmpty();
+    return *this;
+}
+
+void RankActionIterator::SkipEmpty()
+{
+    while (planeId_ < planeEnd_) {
+        if (phaseId_ < blueprint_->PhaseNum() &&
+            actionIdx_ < blueprint_->ActionNum(rankId_, planeId_, phaseId_)) {
+            return;
+        }
+        actionIdx_ = 0;
+        if (++phaseId_ >= blueprint_->PhaseNum()) {
+            phaseId_ = 0;
+            ++planeId_;
+        }
+    }
+    // 结尾统一为 (planeEnd, 0, 0)
+    phaseId_ = 0;
+    actionIdx_ = 0;
+}
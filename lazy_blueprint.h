@@ -0,0 +1,106 @@
+//
+// 按需计算的Blueprint：不构造任何Action存储，
+// 直接以闭式回答“rank r 在 plane k 的 phase p 上做什么”。
+//
+
+#ifndef CPP_LAZY_BLUEPRINT_H
+#define CPP_LAZY_BLUEPRINT_H
+
+#include "solution.h"
+#include "schedule_generators.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+class LazyBlueprint;
+
+// 依次访问单个rank在[planeBegin, planeEnd)上的全部action，顺序为 plane -> phase -> action，
+// 与物化后的Blueprint中该rank作为srcRank的action顺序一致；解引用时按值返回Action
+class RankActionIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Action;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Action;
+
+    RankActionIterator(const LazyBlueprint* blueprint, uint32_t rankId, uint32_t planeId, uint32_t planeEnd);
+
+    Action operator*() const;
+    RankActionIterator& operator++();
+    RankActionIterator operator++(int) { RankActionIterator tmp(*this); ++*this; return tmp; }
+    bool operator==(const RankActionIterator& other) const
+    {
+        return planeId_ == other.planeId_ && phaseId_ == other.phaseId_ && actionIdx_ == other.actionIdx_;
+    }
+    bool operator!=(const RankActionIterator& other) const { return !(*this == other); }
+
+    uint32_t PlaneId() const { return planeId_; }
+    uint32_t PhaseId() const { return phaseId_; }
+
+private:
+    // 跳过action数为0的(plane, phase)，停在下一个有效位置或结尾
+    void SkipEmpty();
+
+    const LazyBlueprint* blueprint_;
+    uint32_t rankId_;
+    uint32_t planeId_;
+    uint32_t planeEnd_;
+    uint32_t phaseId_{0};
+    uint32_t actionIdx_{0};
+};
+
+class RankActionRange {
+public:
+    RankActionRange(RankActionIterator first, RankActionIterator last) : begin_(first), end_(last) {}
+
+    RankActionIterator begin() const { return begin_; }
+    RankActionIterator end() const { return end_; }
+
+private:
+    RankActionIterator begin_;
+    RankActionIterator end_;
+};
+
+// 只保存算法参数（MULTI_RING/CHUNKED_RING另有最多P/2个步长，异构plane时另有P个权重），所有查询均为O(1)；
+// 对象不可变，可被多个线程同时查询
+class LazyBlueprint {
+public:
+    // algorithm为AUTO时按RING处理，需要按代价模型选择时请使用 Solution::ConstructLazyBluePrint；
+    // 不可行的算法与ConstructBluePrint一样退回MULTI_RING或RING
+    LazyBlueprint(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm,
+                  const ScheduleOptions& options = ScheduleOptions());
+
+    ScheduleAlgorithm Algorithm() const { return algorithm_; }
+    uint32_t RankSize() const { return rankSize_; }
+    uint32_t PlaneNum() const { return planeNum_; }
+    uint32_t PhaseNum() const { return phaseNum_; }
+    bool Chunked() const
+    {
+        return algorithm_ == ScheduleAlgorithm::CHUNKED_RING || algorithm_ == ScheduleAlgorithm::HIERARCHICAL;
+    }
+
+    // rank在(plane, phase)上发出的action数：RING恒为1，HALVING/MULTI_RING/CHUNKED_RING可能为0或多个，
+    // HIERARCHICAL在节点内phase为节点数、跨节点phase为1
+    uint32_t ActionNum(uint32_t rankId, uint32_t planeId, uint32_t phaseId) const;
+    // rank在(plane, phase)上发出的第actionIdx个action，要求 actionIdx < ActionNum(...)
+    Action GetAction(uint32_t rankId, uint32_t planeId, uint32_t phaseId, uint32_t actionIdx = 0) const;
+    // (plane, phase)上全部rank的action数，即物化后 bp[plane][phase].size()
+    size_t PhaseActionNum(uint32_t planeId, uint32_t phaseId) const;
+
+    // 单个rank在全部plane / 单个plane上的action
+    RankActionRange RankActions(uint32_t rankId) const;
+    RankActionRange RankActions(uint32_t rankId, uint32_t planeId) const;
+
+private:
+    uint32_t rankSize_;
+    uint32_t planeNum_;
+    ScheduleAlgorithm algorithm_;
+    uint32_t phaseNum_;
+    SolutionUtils::RingGenerator ring_;
+    SolutionUtils::HalvingGenerator halving_;
+    SolutionUtils::ChunkedRingGenerator chunked_;
+    SolutionUtils::HierarchicalGenerator hierarchical_;
+};
+
+#endif // CPP_LAZY_BLUEPRINT_H
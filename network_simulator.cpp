@@ -0,0 +1,256 @@
+//
+// 离散事件网络仿真实现
+//
+
+#include "network_simulator.h"
+#include <algorithm>
+
+using namespace std;
+
+constexpr uint64_t NetworkSimulator::NO_TRANSFER;
+constexpr size_t NetworkSimulator::DENSE_ARRIVAL_LIMIT;
+
+const char* StallCauseName(StallCause cause)
+{
+    switch (cause) {
+        case StallCause::NONE:
+            return "none";
+        case StallCause::DATA:
+            return "data";
+        case StallCause::LINK:
+            return "link";
+        case StallCause::SEND_PORT:
+            return "send_port";
+        case StallCause::RECV_PORT:
+            return "recv_port";
+        case StallCause::BARRIER:
+            return "barrier";
+    }
+    return "unknown";
+}
+
+bool NetworkSimulator::BuildLinks(uint32_t N, uint32_t P)
+{
+    // 与评分器相同：每个无向对一条边
+    vector<uint32_t> degree(N, 0);
+    PairTable<uint32_t> pairs;
+    pairs.Reset(N);
+    linkIndex_.ForEach([&](uint32_t u, uint32_t v, uint32_t) {
+        uint32_t& edge = pairs.At(min(u, v), max(u, v));
+        if (edge == 0) {
+            edge = 1;
+            ++degree[u];
+            ++degree[v];
+        }
+    });
+    for (uint32_t u = 0; u < N; ++u) {
+        if (degree[u] > P) {
+            return false;
+        }
+    }
+
+    linkSrc_.clear();
+    linkDst_.clear();
+    linkEdges_.clear();
+    linkIndex_.ForEach([&](uint32_t u, uint32_t v, uint32_t) {
+        linkSrc_.push_back(u);
+        linkDst_.push_back(v);
+    });
+    // 按(src, dst)排序使链路编号与结果顺序确定
+    vector<size_t> order(linkSrc_.size());
+    for (size_t idx = 0; idx < order.size(); ++idx) {
+        order[idx] = idx;
+    }
+    sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return (linkSrc_[a] != linkSrc_[b]) ? linkSrc_[a] < linkSrc_[b] : linkDst_[a] < linkDst_[b];
+    });
+    vector<uint32_t> src(order.size());
+    vector<uint32_t> dst(order.size());
+    for (size_t idx = 0; idx < order.size(); ++idx) {
+        src[idx] = linkSrc_[order[idx]];
+        dst[idx] = linkDst_[order[idx]];
+        linkIndex_.At(src[idx], dst[idx]) = static_cast<uint32_t>(idx + 1);
+        linkEdges_.push_back(pairs.Get(min(src[idx], dst[idx]), max(src[idx], dst[idx])));
+    }
+    linkSrc_.swap(src);
+    linkDst_.swap(dst);
+
+    linkFree_.assign(linkSrc_.size(), 0.0);
+    linkLast_.assign(linkSrc_.size(), NO_TRANSFER);
+    linkBusy_.assign(linkSrc_.size(), 0.0);
+    linkBytes_.assign(linkSrc_.size(), 0.0);
+    return true;
+}
+
+void NetworkSimulator::ResetArrivals(uint32_t N, uint32_t maxChunkNum)
+{
+    Arrival none;
+    none.time = 0.0;
+    none.transfer = NO_TRANSFER;
+    rankSize_ = N;
+    chunkStride_ = maxChunkNum;
+    uint64_t keyNum = static_cast<uint64_t>(N) * N * maxChunkNum;
+    denseArrival_ = keyNum <= DENSE_ARRIVAL_LIMIT;
+    sparseArrivals_.clear();
+    if (denseArrival_) {
+        denseArrivals_.assign(keyNum, none);
+    } else {
+        denseArrivals_.clear();
+    }
+}
+
+NetworkSimulator::Arrival& NetworkSimulator::ArrivalAt(uint32_t rankId, uint32_t sliceId, uint32_t chunkId)
+{
+    uint64_t key = (static_cast<uint64_t>(rankId) * rankSize_ + sliceId) * chunkStride_ + chunkId;
+    if (denseArrival_) {
+        return denseArrivals_[key];
+    }
+    auto it = sparseArrivals_.find(key);
+    if (it == sparseArrivals_.end()) {
+        Arrival none;
+        none.time = 0.0;
+        none.transfer = NO_TRANSFER;
+        it = sparseArrivals_.emplace(key, none).first;
+    }
+    return it->second;
+}
+
+void NetworkSimulator::RunPhase(uint32_t phaseId, uint32_t planeNum, uint32_t N, double barrierTime,
+                                uint64_t barrierPred)
+{
+    // 同一端口/链路上按就绪时间先后排队，就绪时间相同时按 plane -> action 顺序
+    sort(pending_.begin(), pending_.end(), [](const Transfer& a, const Transfer& b) {
+        if (a.ready != b.ready) {
+            return a.ready < b.ready;
+        }
+        return (a.planeId != b.planeId) ? a.planeId < b.planeId : a.actionIdx < b.actionIdx;
+    });
+
+    double sliceBytes = model_.dataSize / N;
+    double phaseEnd = 0.0;
+    uint64_t phaseLast = NO_TRANSFER;
+    for (Transfer& transfer : pending_) {
+        const Action& action = transfer.action;
+        double start = transfer.ready;
+        uint64_t pred = transfer.pred;
+        StallCause cause = transfer.cause;
+        auto wait = [&](double freeTime, uint64_t last, StallCause reason) {
+            if (freeTime > start) {
+                start = freeTime;
+                pred = last;
+                cause = reason;
+            }
+        };
+        if (model_.phaseBarrier) {
+            wait(barrierTime, barrierPred, StallCause::BARRIER);
+        }
+
+        transfer.id = transferNum_++;
+        double bytes = sliceBytes / action.chunkNum;
+        double occupy = 0.0;
+        double latency = 0.0;
+        size_t port = static_cast<size_t>(action.srcRank) * planeNum + transfer.planeId;
+        size_t recvPort = static_cast<size_t>(action.dstRank) * planeNum + transfer.planeId;
+        uint32_t link = 0;
+        if (action.srcRank != action.dstRank) {
+            link = linkIndex_.Get(action.srcRank, action.dstRank) - 1;
+            double ratio = model_.TimeRatio(transfer.planeId, action.srcRank, action.dstRank);
+            occupy = bytes * ratio / (linkEdges_[link] * model_.linkBandwidth);
+            latency = model_.Latency(transfer.planeId, action.srcRank, action.dstRank);
+            wait(linkFree_[link], linkLast_[link], StallCause::LINK);
+            if (model_.planeBandwidth > 0.0) {
+                occupy = max(occupy, bytes * ratio / model_.planeBandwidth);
+                wait(sendFree_[port], sendLast_[port], StallCause::SEND_PORT);
+                wait(recvFree_[recvPort], recvLast_[recvPort], StallCause::RECV_PORT);
+            }
+        }
+
+        // 自发送不占用网络，就绪即完成
+        transfer.finish = start + occupy + latency;
+        if (action.srcRank != action.dstRank) {
+            linkFree_[link] = start + occupy;
+            linkLast_[link] = transfer.id;
+            linkBusy_[link] += occupy;
+            linkBytes_[link] += bytes;
+            if (model_.planeBandwidth > 0.0) {
+                sendFree_[port] = start + occupy;
+                sendLast_[port] = transfer.id;
+                recvFree_[recvPort] = start + occupy;
+                recvLast_[recvPort] = transfer.id;
+            }
+        }
+        if (phaseLast == NO_TRANSFER || transfer.finish > phaseEnd) {
+            phaseEnd = transfer.finish;
+            phaseLast = transfer.id;
+        }
+        if (transfer.finish >= makespan_) {
+            makespan_ = transfer.finish;
+            lastTransfer_ = transfer.id;
+        }
+        if (trackCriticalPath_) {
+            Record record;
+            record.start = start;
+            record.finish = transfer.finish;
+            record.pred = pred;
+            record.planeId = transfer.planeId;
+            record.phaseId = phaseId;
+            record.action = action;
+            record.cause = cause;
+            records_.push_back(record);
+        }
+    }
+
+    // 本phase的数据在之后的phase才可被转发
+    for (const Transfer& transfer : pending_) {
+        Arrival& arrival = ArrivalAt(transfer.action.dstRank, transfer.action.sliceId, transfer.action.chunkId);
+        if (arrival.transfer == NO_TRANSFER || transfer.finish > arrival.time) {
+            arrival.time = transfer.finish;
+            arrival.transfer = transfer.id;
+        }
+    }
+    // 空phase不改变同步点
+    if (phaseLast != NO_TRANSFER) {
+        phaseEnd_ = phaseEnd;
+        phaseLast_ = phaseLast;
+    }
+}
+
+SimulationResult NetworkSimulator::Finish()
+{
+    SimulationResult result;
+    result.valid = true;
+    result.makespan = makespan_;
+    result.transferNum = transferNum_;
+
+    double utilisationSum = 0.0;
+    result.links.reserve(linkSrc_.size());
+    for (size_t link = 0; link < linkSrc_.size(); ++link) {
+        LinkUsage usage;
+        usage.srcRank = linkSrc_[link];
+        usage.dstRank = linkDst_[link];
+        usage.edgeNum = linkEdges_[link];
+        usage.bytes = linkBytes_[link];
+        usage.busyTime = linkBusy_[link];
+        usage.utilisation = (makespan_ > 0.0) ? usage.busyTime / makespan_ : 0.0;
+        result.maxLinkUtilisation = max(result.maxLinkUtilisation, usage.utilisation);
+        utilisationSum += usage.utilisation;
+        result.links.push_back(usage);
+    }
+    result.meanLinkUtilisation = result.links.empty() ? 0.0 : utilisationSum / result.links.size();
+
+    if (trackCriticalPath_) {
+        for (uint64_t id = lastTransfer_; id != NO_TRANSFER; id = records_[id].pred) {
+            const Record& record = records_[id];
+            CriticalStep step;
+            step.planeId = record.planeId;
+            step.phaseId = record.phaseId;
+            step.action = record.action;
+            step.start = record.start;
+            step.finish = record.finish;
+            step.cause = record.cause;
+            result.criticalPath.push_back(step);
+        }
+        reverse(result.criticalPath.begin(), result.criticalPath.end());
+    }
+    return result;
+}
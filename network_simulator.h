@@ -0,0 +1,265 @@
+//
+// 离散事件网络仿真：在多plane拓扑上回放Blueprint，
+// 按数据依赖与链路/端口排队计算每个传输的开始与完成时间，
+// 报告总完成时间（makespan）、各链路利用率与关键路径。
+//
+// 模型：
+//   - 每对有通信的rank之间分配m(u, v)条物理边（与评分器一致，m = 1），度数超过P时方案无效；
+//     有向链路 u->v 的带宽为 m(u, v) * linkBandwidth，同一链路上的传输按到达顺序排队（FIFO）
+//   - 每个rank在每个plane上有一个发送端口和一个接收端口，带宽为planeBandwidth（0为不限）
+//   - 一次传输搬运 S/N/chunkNum 字节，占用链路与端口 bytes/带宽 的时间，完成时间再加linkLatency
+//   - 与代价模型一致：plane p 上的传输按该plane的带宽与时延（planes非空时）计，跨节点的传输
+//     再按 B / B_inter 放慢、时延不小于interNodeLatency；链路为各plane共用，因此占用时间按传输所在plane折算
+//   - rank u 在phase k发送 (slice, chunk) 时，需要等待之前各phase中发往 u 的同一 (slice, chunk) 全部到达；
+//     同一端口/链路上的传输按 phase 顺序、phase内按就绪时间排队
+//   - phaseBarrier为true时phase之间全局同步，各phase均有通信时结果与代价模型 K*L + S/(N*B)*Σmax_cr 一致
+//
+
+#ifndef CPP_NETWORK_SIMULATOR_H
+#define CPP_NETWORK_SIMULATOR_H
+
+#include "solution.h"
+#include "cost_model.h"
+#include "blueprint_scorer.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct NetworkModel {
+    double dataSize{DEFAULT_DATA_SIZE};         // S：每个rank的数据总量
+    double linkBandwidth{DEFAULT_BANDWIDTH};    // 一条物理边的单向带宽
+    double linkLatency{DEFAULT_PHASE_LATENCY};  // 每次传输的固定时延，不占用链路
+    double planeBandwidth{0.0};                 // 每个rank在每个plane上收/发端口的带宽（按plane的 B_p / B 折算），0为不限
+    bool phaseBarrier{false};                   // phase之间是否全局同步
+    // 各plane的链路带宽与时延（见 CostModel::planes），为空时均为 (linkBandwidth, linkLatency)，
+    // 非空时超出范围的plane同样按 (linkBandwidth, linkLatency) 计
+    std::vector<PlaneProfile> planes;
+    uint32_t ranksPerNode{0};  // 0为所有rank在同一节点
+    double interNodeBandwidth{DEFAULT_BANDWIDTH};
+    double interNodeLatency{DEFAULT_PHASE_LATENCY};
+
+    static NetworkModel FromCostModel(const CostModel& costModel)
+    {
+        NetworkModel model;
+        model.dataSize = costModel.dataSize;
+        model.linkBandwidth = costModel.bandwidth;
+        model.linkLatency = costModel.phaseLatency;
+        model.planes = costModel.planes;
+        model.ranksPerNode = costModel.ranksPerNode;
+        model.interNodeBandwidth = costModel.interNodeBandwidth;
+        model.interNodeLatency = costModel.interNodeLatency;
+        return model;
+    }
+
+    // plane上 u->v 的传输时间相对linkBandwidth的倍数，带宽不为正时为无穷大
+    double TimeRatio(uint32_t planeId, uint32_t u, uint32_t v) const
+    {
+        double ratio = 1.0;
+        if (planeId < planes.size()) {
+            ratio = (planes[planeId].bandwidth > 0.0) ? linkBandwidth / planes[planeId].bandwidth : HUGE_VAL;
+        }
+        if (CrossNode(u, v)) {
+            ratio *= (interNodeBandwidth > 0.0) ? linkBandwidth / interNodeBandwidth : HUGE_VAL;
+        }
+        return ratio;
+    }
+    double Latency(uint32_t planeId, uint32_t u, uint32_t v) const
+    {
+        double latency = (planeId < planes.size()) ? planes[planeId].phaseLatency : linkLatency;
+        return CrossNode(u, v) ? std::max(latency, interNodeLatency) : latency;
+    }
+    bool CrossNode(uint32_t u, uint32_t v) const
+    {
+        return ranksPerNode > 0 && u / ranksPerNode != v / ranksPerNode;
+    }
+};
+
+// 传输开始时间由谁决定
+enum class StallCause : uint8_t {
+    NONE,       // 开始即就绪
+    DATA,       // 等待所需数据到达
+    LINK,       // 链路被之前的传输占用
+    SEND_PORT,  // 发送端口被占用
+    RECV_PORT,  // 接收端口被占用
+    BARRIER     // 等待上一phase全部完成
+};
+
+const char* StallCauseName(StallCause cause);
+
+struct CriticalStep {
+    uint32_t planeId;
+    uint32_t phaseId;
+    Action action;
+    double start;
+    double finish;
+    StallCause cause;  // 本步为何不能更早开始，即与上一步的依赖关系
+};
+
+struct LinkUsage {
+    uint32_t srcRank;
+    uint32_t dstRank;
+    uint32_t edgeNum;    // m(u, v)
+    double bytes;
+    double busyTime;
+    double utilisation;  // busyTime / makespan
+};
+
+struct SimulationResult {
+    bool valid{false};  // 度数超过P时为false，其余字段无意义
+    double makespan{0.0};
+    size_t transferNum{0};
+    double maxLinkUtilisation{0.0};
+    double meanLinkUtilisation{0.0};
+    std::vector<LinkUsage> links;             // 有通信的有向链路，按(src, dst)排序
+    std::vector<CriticalStep> criticalPath;   // 按时间顺序，最后一步的完成时间即makespan
+};
+
+// 内部状态在多次仿真之间复用，非线程安全，每个线程应使用独立的实例
+class NetworkSimulator {
+public:
+    NetworkSimulator() = default;
+    explicit NetworkSimulator(const NetworkModel& model) : model_(model) {}
+
+    void SetModel(const NetworkModel& model) { model_ = model; }
+    const NetworkModel& GetModel() const { return model_; }
+    // 关闭后不记录每个传输的前驱，criticalPath为空，内存占用减少约一半
+    void SetTrackCriticalPath(bool track) { trackCriticalPath_ = track; }
+
+    template <typename BlueprintT>
+    SimulationResult Simulate(const BlueprintT& bp, uint32_t N, uint32_t P);
+
+private:
+    static constexpr uint64_t NO_TRANSFER = ~0ULL;
+    static constexpr size_t DENSE_ARRIVAL_LIMIT = 1 << 22;
+
+    // 某个 (rank, slice, chunk) 最近一次到达的时间及对应的传输
+    struct Arrival {
+        double time;
+        uint64_t transfer;
+    };
+
+    struct Transfer {
+        Action action;
+        uint32_t planeId;
+        uint32_t actionIdx;
+        double ready;
+        uint64_t pred;
+        StallCause cause;
+        uint64_t id;     // 全局传输编号，RunPhase中分配
+        double finish;
+    };
+
+    struct Record {
+        double start;
+        double finish;
+        uint64_t pred;
+        uint32_t planeId;
+        uint32_t phaseId;
+        Action action;
+        StallCause cause;
+    };
+
+    // 根据linkIndex_中出现过的有序对分配边、建立链路表并检查度数
+    bool BuildLinks(uint32_t N, uint32_t P);
+    void ResetArrivals(uint32_t N, uint32_t maxChunkNum);
+    Arrival& ArrivalAt(uint32_t rankId, uint32_t sliceId, uint32_t chunkId);
+    // 调度当前phase（pending_）中的所有传输
+    void RunPhase(uint32_t phaseId, uint32_t planeNum, uint32_t N, double barrierTime, uint64_t barrierPred);
+    SimulationResult Finish();
+
+    NetworkModel model_;
+    bool trackCriticalPath_{true};
+
+    PairTable<uint32_t> linkIndex_;  // 有向对 -> 链路编号 + 1
+    std::vector<uint32_t> linkSrc_;
+    std::vector<uint32_t> linkDst_;
+    std::vector<uint32_t> linkEdges_;
+    std::vector<double> linkFree_;
+    std::vector<uint64_t> linkLast_;
+    std::vector<double> linkBusy_;
+    std::vector<double> linkBytes_;
+    std::vector<double> sendFree_;  // [rank * planeNum + plane]
+    std::vector<uint64_t> sendLast_;
+    std::vector<double> recvFree_;
+    std::vector<uint64_t> recvLast_;
+
+    bool denseArrival_{true};
+    uint32_t rankSize_{0};
+    uint32_t chunkStride_{1};
+    std::vector<Arrival> denseArrivals_;
+    std::unordered_map<uint64_t, Arrival> sparseArrivals_;
+
+    std::vector<Transfer> pending_;
+    std::vector<Record> records_;
+    double makespan_{0.0};
+    uint64_t lastTransfer_{NO_TRANSFER};
+    uint64_t transferNum_{0};
+    double phaseEnd_{0.0};
+    uint64_t phaseLast_{NO_TRANSFER};
+};
+
+template <typename BlueprintT>
+SimulationResult NetworkSimulator::Simulate(const BlueprintT& bp, uint32_t N, uint32_t P)
+{
+    uint32_t planeNum = static_cast<uint32_t>(bp.size());
+    size_t phaseNum = 0;
+    uint32_t maxChunkNum = 1;
+    linkIndex_.Reset(N);
+    for (const auto& schedule : bp) {
+        phaseNum = std::max(phaseNum, static_cast<size_t>(schedule.size()));
+        for (const auto& phase : schedule) {
+            for (const auto& action : phase) {
+                if (action.srcRank != action.dstRank) {
+                    linkIndex_.At(action.srcRank, action.dstRank) = 1;
+                }
+                maxChunkNum = std::max<uint32_t>(maxChunkNum, action.chunkNum);
+            }
+        }
+    }
+    if (!BuildLinks(N, P)) {
+        return SimulationResult();
+    }
+
+    sendFree_.assign(static_cast<size_t>(N) * planeNum, 0.0);
+    sendLast_.assign(sendFree_.size(), NO_TRANSFER);
+    recvFree_.assign(sendFree_.size(), 0.0);
+    recvLast_.assign(sendFree_.size(), NO_TRANSFER);
+    ResetArrivals(N, maxChunkNum);
+    records_.clear();
+    makespan_ = 0.0;
+    lastTransfer_ = NO_TRANSFER;
+    transferNum_ = 0;
+    phaseEnd_ = 0.0;
+    phaseLast_ = NO_TRANSFER;
+
+    for (size_t phaseId = 0; phaseId < phaseNum; ++phaseId) {
+        // 就绪时间只取决于之前的phase，先全部算出再统一排队
+        pending_.clear();
+        for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+            if (phaseId >= bp[planeId].size()) {
+                continue;
+            }
+            const auto& phase = bp[planeId][phaseId];
+            for (size_t actionIdx = 0; actionIdx < phase.size(); ++actionIdx) {
+                Transfer transfer;
+                transfer.action = phase[actionIdx];
+                transfer.planeId = planeId;
+                transfer.actionIdx = static_cast<uint32_t>(actionIdx);
+                const Arrival& arrival = ArrivalAt(transfer.action.srcRank, transfer.action.sliceId,
+                                                   transfer.action.chunkId);
+                transfer.ready = arrival.time;
+                transfer.pred = arrival.transfer;
+                transfer.cause = (arrival.transfer == NO_TRANSFER) ? StallCause::NONE : StallCause::DATA;
+                pending_.push_back(transfer);
+            }
+        }
+        double barrierTime = phaseEnd_;
+        uint64_t barrierPred = phaseLast_;
+        RunPhase(static_cast<uint32_t>(phaseId), planeNum, N, barrierTime, barrierPred);
+    }
+    return Finish();
+}
+
+#endif // CPP_NETWORK_SIMULATOR_H
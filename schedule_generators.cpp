@@ -0,0 +1,334 @@
+//
+// 调度生成器中的非内联部分：度数计算、步长选择与闭式估计
+//
+
+#include "schedule_generators.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace SolutionUtils {
+
+uint32_t CalcCirculantDegree(uint32_t rankSize, const vector<uint32_t>& distances)
+{
+    vector<bool> used(rankSize / 2 + 1, false);
+    uint32_t degree = 0;
+    for (uint32_t distance : distances) {
+        distance %= rankSize;
+        uint32_t edgeClass = (distance <= rankSize - distance) ? distance : rankSize - distance;
+        if (edgeClass == 0 || used[edgeClass]) {
+            continue;
+        }
+        used[edgeClass] = true;
+        degree += (2 * edgeClass == rankSize) ? 1 : 2;
+    }
+    return degree;
+}
+
+uint32_t CalcHalvingDegree(uint32_t rankSize)
+{
+    uint32_t stepNum = CalcHalvingPhaseNum(rankSize);
+    if (IsPowerOfTwo(rankSize)) {
+        return stepNum;  // 每步一个XOR对端，边是双向复用的
+    }
+    vector<uint32_t> distances;
+    for (uint32_t stepId = 0; stepId < stepNum; ++stepId) {
+        distances.push_back(1u << stepId);
+    }
+    return CalcCirculantDegree(rankSize, distances);
+}
+
+bool IsHalvingFeasible(uint32_t rankSize, uint32_t planeNum)
+{
+    return rankSize > 1 && CalcHalvingDegree(rankSize) <= planeNum;
+}
+
+uint32_t Gcd(uint32_t a, uint32_t b)
+{
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+vector<uint32_t> CalcRingStrides(uint32_t rankSize, uint32_t ringNum)
+{
+    vector<uint32_t> strides;
+    for (uint32_t stride = 1; 2 * stride <= rankSize && strides.size() < ringNum; ++stride) {
+        if (Gcd(stride, rankSize) == 1) {
+            strides.push_back(stride);
+        }
+    }
+    if (strides.empty()) {
+        strides.push_back(1);
+    }
+    return strides;
+}
+
+uint32_t CalcMultiRingNum(uint32_t rankSize, uint32_t planeNum, uint32_t ringLimit)
+{
+    return static_cast<uint32_t>(CalcRingStrides(rankSize, CalcMultiRingTarget(planeNum, ringLimit)).size());
+}
+
+ScheduleEstimate EstimateRing(uint32_t rankSize, uint32_t planeNum)
+{
+    ScheduleEstimate estimate;
+    uint32_t degree = (rankSize <= 2) ? 1 : 2;
+    estimate.feasible = rankSize > 1 && degree <= planeNum;
+    estimate.rankDegree = degree;
+    estimate.phaseNum = (rankSize <= 1) ? 0 : rankSize - 1;
+    // 偶数plane顺时针、奇数plane逆时针，同方向的plane共用同一(i, i+1)；N=2时两个方向重合
+    uint32_t maxConflict = (rankSize == 2) ? planeNum : (planeNum + 1) / 2;
+    estimate.conflictSum = static_cast<double>(estimate.phaseNum) * maxConflict;
+    estimate.interPhaseNum = 0;
+    estimate.interConflictSum = 0.0;
+    return estimate;
+}
+
+ScheduleEstimate EstimateHalving(uint32_t rankSize, uint32_t planeNum)
+{
+    ScheduleEstimate estimate;
+    estimate.feasible = IsHalvingFeasible(rankSize, planeNum);
+    estimate.rankDegree = (rankSize <= 1) ? 1 : CalcHalvingDegree(rankSize);
+    estimate.phaseNum = CalcHalvingPhaseNum(rankSize);
+    // 每一步所有plane都走同一对端，冲突率即该步每个rank发送的slice数，总和为N-1
+    estimate.conflictSum = (rankSize <= 1) ? 0.0 : rankSize - 1.0;
+    estimate.interPhaseNum = 0;
+    estimate.interConflictSum = 0.0;
+    return estimate;
+}
+
+ScheduleEstimate EstimateMultiRing(uint32_t rankSize, uint32_t planeNum, uint32_t ringLimit)
+{
+    if (rankSize <= 2) {
+        return EstimateRing(rankSize, planeNum);  // 只有一个步长，与ring相同
+    }
+    ScheduleEstimate estimate;
+    uint32_t ringNum = CalcMultiRingNum(rankSize, planeNum, ringLimit);
+    estimate.feasible = 2 * ringNum <= planeNum;
+    estimate.rankDegree = 2 * ringNum;
+    estimate.phaseNum = rankSize - 1;
+    // 2R个(步长, 方向)组合轮流分配给P个plane，同一组合的plane共用同一有向链路
+    uint32_t maxConflict = (planeNum + 2 * ringNum - 1) / (2 * ringNum);
+    estimate.conflictSum = static_cast<double>(estimate.phaseNum) * maxConflict;
+    estimate.interPhaseNum = 0;
+    estimate.interConflictSum = 0.0;
+    return estimate;
+}
+
+ScheduleEstimate EstimateChunkedRing(uint32_t rankSize, uint32_t planeNum, uint32_t pipelineDepth,
+                                     uint32_t ringLimit)
+{
+    // 每个action只搬运 1/(P*D) 个slice；流水只推迟启动，各phase活跃份数之和仍为 D*(N-1)，
+    // 因此冲突率之和为MULTI_RING的 1/P，phase数多 D-1
+    ScheduleEstimate estimate = EstimateMultiRing(rankSize, planeNum, ringLimit);
+    uint32_t depth = (pipelineDepth == 0) ? 1 : pipelineDepth;
+    if (estimate.phaseNum > 0) {
+        estimate.phaseNum += depth - 1;
+    }
+    estimate.conflictSum /= (planeNum > 0) ? planeNum : 1;
+    estimate.feasible = estimate.feasible && static_cast<uint64_t>(planeNum) * depth <= numeric_limits<uint16_t>::max();
+    return estimate;
+}
+
+ScheduleEstimate EstimateHierarchical(uint32_t rankSize, uint32_t planeNum, uint32_t ranksPerNode)
+{
+    ScheduleEstimate estimate;
+    bool shaped = IsHierarchicalShape(rankSize, ranksPerNode);
+    uint32_t localSize = shaped ? ranksPerNode : rankSize;
+    uint32_t nodeNum = (localSize == 0) ? 0 : rankSize / localSize;
+    estimate.rankDegree = (rankSize <= 1) ? 1 : CalcRingDegree(localSize) + CalcRingDegree(nodeNum);
+    estimate.feasible = shaped && estimate.rankDegree <= planeNum && planeNum <= numeric_limits<uint16_t>::max();
+    estimate.phaseNum = (rankSize <= 1) ? 0 : (localSize - 1) + (nodeNum - 1);
+    // 每个action搬运 1/P 个slice；与EstimateRing相同，同方向的plane共用同一有向链路，两个rank的ring两个方向重合。
+    // 节点内每个phase每个rank发送G个slice，跨节点每个phase发送1个
+    double chunk = (planeNum > 0) ? 1.0 / planeNum : 0.0;
+    uint32_t localConflict = (localSize == 2) ? planeNum : (planeNum + 1) / 2;
+    uint32_t nodeConflict = (nodeNum == 2) ? planeNum : (planeNum + 1) / 2;
+    double intraConflictSum = (localSize > 1) ? (localSize - 1.0) * nodeNum * localConflict * chunk : 0.0;
+    estimate.interPhaseNum = (rankSize <= 1 || nodeNum == 0) ? 0 : nodeNum - 1;
+    estimate.interConflictSum = static_cast<double>(estimate.interPhaseNum) * nodeConflict * chunk;
+    estimate.conflictSum = intraConflictSum + estimate.interConflictSum;
+    return estimate;
+}
+
+vector<uint32_t> CalcPlaneWeights(const CostModel& costModel, uint32_t planeNum)
+{
+    vector<uint32_t> weights;
+    if (!costModel.Heterogeneous()) {
+        return weights;
+    }
+    double maxBandwidth = 0.0;
+    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+        maxBandwidth = max(maxBandwidth, costModel.bandwidth / costModel.PlaneTimeRatio(planeId));
+    }
+    if (!(maxBandwidth > 0.0)) {
+        return weights;
+    }
+    weights.resize(planeNum);
+    uint32_t divisor = 0;
+    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+        double bandwidth = costModel.bandwidth / costModel.PlaneTimeRatio(planeId);
+        weights[planeId] = static_cast<uint32_t>(lround(PLANE_WEIGHT_RESOLUTION * bandwidth / maxBandwidth));
+        divisor = Gcd(divisor, weights[planeId]);
+    }
+    bool uniform = true;
+    for (uint32_t& weight : weights) {
+        weight /= divisor;
+        uniform = uniform && weight == weights[0];
+    }
+    if (uniform) {
+        weights.clear();
+    }
+    return weights;
+}
+
+void ApplyPlaneWeights(const CostModel& costModel, uint32_t planeNum, ScheduleOptions& options)
+{
+    if (costModel.Heterogeneous() && options.planeWeights.empty()) {
+        options.planeWeights = CalcPlaneWeights(costModel, planeNum);
+    }
+}
+
+uint64_t CalcTotalPlaneWeight(uint32_t planeNum, const vector<uint32_t>& planeWeights)
+{
+    if (planeWeights.empty()) {
+        return planeNum;
+    }
+    uint64_t total = 0;
+    for (uint32_t planeId = 0; planeId < planeNum && planeId < planeWeights.size(); ++planeId) {
+        total += planeWeights[planeId];
+    }
+    return total;
+}
+
+double CalcPlaneSlowdown(const CostModel& costModel, uint32_t planeNum, ScheduleAlgorithm algorithm,
+                         const ScheduleOptions& options)
+{
+    if (!costModel.Heterogeneous() || planeNum == 0) {
+        return 1.0;
+    }
+    bool weighted = algorithm == ScheduleAlgorithm::CHUNKED_RING || algorithm == ScheduleAlgorithm::MULTI_RING;
+    uint64_t totalWeight = CalcTotalPlaneWeight(planeNum, options.planeWeights);
+    double slowdown = 0.0;
+    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+        if (!weighted) {
+            slowdown = max(slowdown, costModel.PlaneTimeRatio(planeId));
+            continue;
+        }
+        uint32_t weight = options.planeWeights.empty() ? 1 :
+                          (planeId < options.planeWeights.size() ? options.planeWeights[planeId] : 0);
+        if (weight > 0) {
+            slowdown = max(slowdown, static_cast<double>(planeNum) * weight / totalWeight *
+                                     costModel.PlaneTimeRatio(planeId));
+        }
+    }
+    return slowdown;
+}
+
+namespace {
+
+ScheduleEstimate EstimateSingleEdge(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm,
+                                    const ScheduleOptions& options)
+{
+    if (algorithm == ScheduleAlgorithm::CHUNKED_RING || algorithm == ScheduleAlgorithm::MULTI_RING) {
+        uint32_t depth = CalcPipelineDepth(algorithm, options);
+        ScheduleEstimate estimate = EstimateChunkedRing(rankSize, planeNum, depth, options.ringNum);
+        if (!options.planeWeights.empty()) {
+            // 按权重切块时块数为 Σw * D，同样不能超出16位
+            uint64_t chunkNum = CalcTotalPlaneWeight(planeNum, options.planeWeights) * depth;
+            estimate.feasible = estimate.feasible && chunkNum > 0 && chunkNum <= numeric_limits<uint16_t>::max();
+        }
+        return estimate;
+    }
+    if (algorithm == ScheduleAlgorithm::HALVING) {
+        return EstimateHalving(rankSize, planeNum);
+    }
+    if (algorithm == ScheduleAlgorithm::HIERARCHICAL) {
+        return EstimateHierarchical(rankSize, planeNum, options.ranksPerNode);
+    }
+    return EstimateRing(rankSize, planeNum);
+}
+
+// 单层算法的rank按编号连续排列在各节点上，ring类算法每个phase都有跨节点的链路；
+// N、R均为2的幂时递归减半距离d < R的步只在节点内交换，其余步（距离 N/2, ..., R）冲突率之和为 N-R
+void FillFlatInterPhases(uint32_t rankSize, ScheduleAlgorithm algorithm, uint32_t ranksPerNode,
+                         ScheduleEstimate& estimate)
+{
+    if (ranksPerNode == 0 || ranksPerNode >= rankSize) {
+        estimate.interPhaseNum = 0;
+        estimate.interConflictSum = 0.0;
+        return;
+    }
+    if (algorithm == ScheduleAlgorithm::HALVING && IsPowerOfTwo(rankSize) && IsPowerOfTwo(ranksPerNode)) {
+        estimate.interPhaseNum = CeilLog2(rankSize / ranksPerNode);
+        estimate.interConflictSum = static_cast<double>(rankSize - ranksPerNode);
+        return;
+    }
+    estimate.interPhaseNum = estimate.phaseNum;
+    estimate.interConflictSum = estimate.conflictSum;
+}
+
+} // namespace
+
+ScheduleEstimate EstimateSchedule(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm,
+                                  const ScheduleOptions& options)
+{
+    ScheduleEstimate estimate = EstimateSingleEdge(rankSize, planeNum, algorithm, options);
+    if (algorithm != ScheduleAlgorithm::HIERARCHICAL) {
+        FillFlatInterPhases(rankSize, algorithm, options.ranksPerNode, estimate);
+    }
+    if (options.parallelEdges && estimate.feasible && estimate.rankDegree > 0) {
+        uint32_t edgeNum = planeNum / estimate.rankDegree;
+        estimate.conflictSum /= (edgeNum > 0) ? edgeNum : 1;
+        estimate.interConflictSum /= (edgeNum > 0) ? edgeNum : 1;
+    }
+    return estimate;
+}
+
+void ApplyNodeTopology(const CostModel& costModel, ScheduleOptions& options)
+{
+    if (options.ranksPerNode == 0) {
+        options.ranksPerNode = costModel.ranksPerNode;
+    }
+}
+
+double EstimateCommunicationTime(const CostModel& costModel, uint32_t rankSize, uint32_t planeNum,
+                                 ScheduleAlgorithm algorithm, const ScheduleOptions& options,
+                                 const ScheduleEstimate& estimate)
+{
+    if (!estimate.feasible) {
+        return numeric_limits<double>::infinity();
+    }
+    double slowdown = CalcPlaneSlowdown(costModel, planeNum, algorithm, options);
+    return costModel.CommunicationTime(rankSize, estimate.phaseNum, estimate.conflictSum * slowdown,
+                                       estimate.interPhaseNum, estimate.interConflictSum * slowdown);
+}
+
+ScheduleAlgorithm ResolveFeasibleAlgorithm(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm,
+                                           const ScheduleOptions& options)
+{
+    if (algorithm == ScheduleAlgorithm::HALVING && IsHalvingFeasible(rankSize, planeNum)) {
+        return ScheduleAlgorithm::HALVING;
+    }
+    if ((algorithm == ScheduleAlgorithm::MULTI_RING || algorithm == ScheduleAlgorithm::CHUNKED_RING) &&
+        EstimateSingleEdge(rankSize, planeNum, algorithm, options).feasible) {
+        return algorithm;
+    }
+    if (algorithm == ScheduleAlgorithm::HIERARCHICAL &&
+        EstimateHierarchical(rankSize, planeNum, options.ranksPerNode).feasible) {
+        return ScheduleAlgorithm::HIERARCHICAL;
+    }
+    // 多plane时RING的每个plane都搬运整个slice，贡献被重复累加，不可行的算法先退回切块的MULTI_RING
+    if (algorithm != ScheduleAlgorithm::RING && algorithm != ScheduleAlgorithm::AUTO &&
+        EstimateSingleEdge(rankSize, planeNum, ScheduleAlgorithm::MULTI_RING, options).feasible) {
+        return ScheduleAlgorithm::MULTI_RING;
+    }
+    return ScheduleAlgorithm::RING;
+}
+
+} // namespace SolutionUtils
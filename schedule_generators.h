@@ -0,0 +1,686 @@
+//
+// 各调度算法的生成器。(plane, phase, rank) 上的action都是闭式计算的，互不依赖，
+// 既可以整体填充Blueprint，也可以按需只计算单个rank的action（见 lazy_blueprint.h）。
+//
+
+#ifndef CPP_SCHEDULE_GENERATORS_H
+#define CPP_SCHEDULE_GENERATORS_H
+
+#include "solution.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SolutionUtils {
+
+enum class RingOrder {
+    CLOCKWISE,
+    COUNTER_CLOCKWISE
+};
+
+inline RingOrder CalcRingOrder(uint32_t planeId)
+{
+    return (planeId % 2 == 0) ? RingOrder::CLOCKWISE : RingOrder::COUNTER_CLOCKWISE;
+}
+
+inline Action ConstructAction(uint32_t rankSize, uint32_t rankId, uint32_t phaseId, RingOrder ringOrder)
+{
+    Action action;
+    action.planeId = DEFAULT_PLANE_ID;  // 会被外层覆盖
+    action.sliceId = INVALID_SLICE_ID;  // 会被外层覆盖
+
+    if (ringOrder == RingOrder::CLOCKWISE) {
+        action.srcRank = rankId;
+        action.dstRank = (rankId + 1) % rankSize;
+    } else {
+        action.srcRank = rankId;
+        action.dstRank = (rankId - 1 + rankSize) % rankSize;
+    }
+
+    return action;
+}
+
+// rank数策略：Value()为N，Wrap(x)为 x mod N。DynamicRankSize在运行期取模；
+// FixedRankSize<N>为编译期的2的幂，取模化为按位与，生成器以它实例化时内层循环的界与步长均为常量
+class DynamicRankSize {
+public:
+    explicit DynamicRankSize(uint32_t rankSize) : rankSize_(rankSize) {}
+
+    uint32_t Value() const { return rankSize_; }
+    uint32_t Wrap(uint32_t value) const { return value % rankSize_; }
+    uint32_t Wrap(uint64_t value) const { return static_cast<uint32_t>(value % rankSize_); }
+
+private:
+    uint32_t rankSize_;
+};
+
+template <uint32_t N>
+class FixedRankSize {
+public:
+    static_assert(N > 0 && (N & (N - 1)) == 0, "FixedRankSize要求N为2的幂");
+
+    explicit FixedRankSize(uint32_t = N) {}
+
+    uint32_t Value() const { return N; }
+    uint32_t Wrap(uint32_t value) const { return value & (N - 1); }
+    uint32_t Wrap(uint64_t value) const { return static_cast<uint32_t>(value & (N - 1)); }
+};
+
+// ring类phase的规则结构：rank i 向 (i + dstOffset) % N 发送slice (i + sliceOffset) % N，两个偏移均小于N
+struct AffinePhase {
+    uint32_t dstOffset;
+    uint32_t sliceOffset;
+};
+
+template <typename RankSizeT>
+inline AffinePhase CalcRingPhase(const RankSizeT& rankSize, uint32_t phaseId, uint32_t planeId)
+{
+    uint32_t n = rankSize.Value();
+    AffinePhase phase;
+    if (CalcRingOrder(planeId) == RingOrder::CLOCKWISE) {
+        // 顺时针：rank i 在phase p发送 slice (i - p - 1 + N) % N
+        phase.dstOffset = rankSize.Wrap(1u);
+        phase.sliceOffset = n - phaseId - 1;
+    } else {
+        // 逆时针：rank i 在phase p发送 slice (i + p + 1) % N
+        phase.dstOffset = n - 1;
+        phase.sliceOffset = rankSize.Wrap(phaseId + 1);
+    }
+    return phase;
+}
+
+template <typename RankSizeT>
+inline Action MakeAffineAction(const RankSizeT& rankSize, const AffinePhase& phase, uint32_t rankId, uint32_t planeId)
+{
+    Action action;
+    action.srcRank = rankId;
+    action.dstRank = rankSize.Wrap(rankId + phase.dstOffset);
+    action.planeId = planeId;
+    action.sliceId = rankSize.Wrap(rankId + phase.sliceOffset);
+    return action;
+}
+
+// ring中rank在phase上的action，rank数由策略给出
+template <typename RankSizeT>
+inline Action MakeRingAction(const RankSizeT& rankSize, uint32_t rankId, uint32_t phaseId, uint32_t planeId)
+{
+    return MakeAffineAction(rankSize, CalcRingPhase(rankSize, phaseId, planeId), rankId, planeId);
+}
+
+inline Action ConstructRingAction(uint32_t rankSize, uint32_t rankId, uint32_t phaseId, uint32_t planeId)
+{
+    return MakeRingAction(DynamicRankSize(rankSize), rankId, phaseId, planeId);
+}
+
+// 常用规模（8 ~ 256的2的幂）以FixedRankSize<N>调用fn，其它规模以DynamicRankSize调用。
+// fn需为带模板operator()的函数对象，每个规模各实例化一次
+template <typename FnT>
+void DispatchRankSize(uint32_t rankSize, FnT& fn)
+{
+    switch (rankSize) {
+        case 8:
+            fn(FixedRankSize<8>());
+            return;
+        case 16:
+            fn(FixedRankSize<16>());
+            return;
+        case 32:
+            fn(FixedRankSize<32>());
+            return;
+        case 64:
+            fn(FixedRankSize<64>());
+            return;
+        case 128:
+            fn(FixedRankSize<128>());
+            return;
+        case 256:
+            fn(FixedRankSize<256>());
+            return;
+        default:
+            fn(DynamicRankSize(rankSize));
+            return;
+    }
+}
+
+// 生成器接口：
+//   RankSize() / PhaseNum()                          rank数、每个plane的phase数
+//   ActionNum(planeId, phaseId)                      该phase的action数
+//   Chunked()                                        是否产生切块（chunkNum > 1）的action
+//   EmitRank(planeId, phaseId, rankId, emit)         按顺序输出rank在该phase发出的action
+//   RankActionNum(planeId, phaseId, rankId)          rank在该phase发出的action数，O(1)
+//   RankAction(planeId, phaseId, rankId, actionIdx)  rank在该phase发出的第actionIdx个action，O(1)
+// EmitRank输出的第i个action即 RankAction(..., i)
+// 各生成器以rank数策略为模板参数，常用名（RingGenerator等）为DynamicRankSize的实例
+template <typename RankSizeT>
+class BasicRingGenerator {
+public:
+    explicit BasicRingGenerator(uint32_t rankSize) : rankSize_(rankSize) {}
+
+    uint32_t RankSize() const { return rankSize_.Value(); }
+    uint32_t PhaseNum() const { return (RankSize() <= 1) ? 0 : RankSize() - 1; }
+    size_t ActionNum(uint32_t, uint32_t) const { return RankSize(); }
+    bool Chunked() const { return false; }
+
+    template <typename EmitT>
+    void EmitRank(uint32_t planeId, uint32_t phaseId, uint32_t rankId, EmitT& emit) const
+    {
+        emit(MakeRingAction(rankSize_, rankId, phaseId, planeId));
+    }
+
+    uint32_t RankActionNum(uint32_t, uint32_t, uint32_t) const { return 1; }
+    Action RankAction(uint32_t planeId, uint32_t phaseId, uint32_t rankId, uint32_t) const
+    {
+        return MakeRingAction(rankSize_, rankId, phaseId, planeId);
+    }
+    AffinePhase Affine(uint32_t planeId, uint32_t phaseId) const { return CalcRingPhase(rankSize_, phaseId, planeId); }
+
+private:
+    RankSizeT rankSize_;
+};
+
+using RingGenerator = BasicRingGenerator<DynamicRankSize>;
+
+inline bool IsPowerOfTwo(uint32_t value)
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+inline uint32_t CeilLog2(uint32_t value)
+{
+    uint32_t log = 0;
+    while ((1ULL << log) < value) {
+        ++log;
+    }
+    return log;
+}
+
+// 各rank按固定距离通信（i与i±d相连）时每个rank的度数
+// 距离d与N-d对应同一组无向边，d == N/2时只有一条边
+uint32_t CalcCirculantDegree(uint32_t rankSize, const std::vector<uint32_t>& distances);
+
+// 递归减半 / Bruck 所需的phase数
+inline uint32_t CalcHalvingPhaseNum(uint32_t rankSize)
+{
+    return (rankSize <= 1) ? 0 : CeilLog2(rankSize);
+}
+
+// 递归减半 / Bruck 所需的每rank度数
+uint32_t CalcHalvingDegree(uint32_t rankSize);
+
+bool IsHalvingFeasible(uint32_t rankSize, uint32_t planeNum);
+
+// rank在某一步的发送任务：向dstRank发送sliceNum个slice，第j个为 (sliceBase + j) % N
+struct HalvingTransfer {
+    uint32_t dstRank;
+    uint32_t sliceBase;
+    uint32_t sliceNum;
+};
+
+inline HalvingTransfer CalcHalvingTransfer(uint32_t rankSize, uint32_t stepId, uint32_t rankId)
+{
+    HalvingTransfer transfer;
+    if (IsPowerOfTwo(rankSize)) {
+        // 递归减半：与 i XOR d 交换，把对端所在那一半的部分和发给对端
+        uint32_t distance = rankSize >> (stepId + 1);
+        transfer.dstRank = rankId ^ distance;
+        transfer.sliceBase = transfer.dstRank & ~(distance - 1);
+        transfer.sliceNum = distance;
+        return transfer;
+    }
+
+    // Bruck：距离从大到小，rank i 持有偏移[0, R)的部分和（slice i+o），
+    // 把偏移[d, R)发给 i+d，之后只保留偏移[0, d)；首步 R = N，之后 R = 2d
+    uint32_t stepNum = CalcHalvingPhaseNum(rankSize);
+    uint32_t distance = 1u << (stepNum - 1 - stepId);
+    uint32_t range = (stepId == 0) ? rankSize : 2 * distance;
+    transfer.dstRank = (rankId + distance) % rankSize;
+    transfer.sliceBase = transfer.dstRank;
+    transfer.sliceNum = range - distance;
+    return transfer;
+}
+
+// 每一步中rank的第j个slice分配给plane (j % P)，各plane分担数据量
+class HalvingGenerator {
+public:
+    HalvingGenerator(uint32_t rankSize, uint32_t planeNum) : rankSize_(rankSize), planeNum_(planeNum) {}
+
+    uint32_t RankSize() const { return rankSize_; }
+    uint32_t PhaseNum() const { return CalcHalvingPhaseNum(rankSize_); }
+    size_t ActionNum(uint32_t planeId, uint32_t phaseId) const
+    {
+        // 同一步中每个rank发送的slice数相同
+        return static_cast<size_t>(RankActionNum(planeId, phaseId, 0)) * rankSize_;
+    }
+    bool Chunked() const { return false; }
+
+    template <typename EmitT>
+    void EmitRank(uint32_t planeId, uint32_t phaseId, uint32_t rankId, EmitT& emit) const
+    {
+        HalvingTransfer transfer = CalcHalvingTransfer(rankSize_, phaseId, rankId);
+        for (uint32_t j = planeId; j < transfer.sliceNum; j += planeNum_) {
+            emit(MakeAction(transfer, planeId, rankId, j));
+        }
+    }
+
+    uint32_t RankActionNum(uint32_t planeId, uint32_t phaseId, uint32_t rankId) const
+    {
+        uint32_t sliceNum = CalcHalvingTransfer(rankSize_, phaseId, rankId).sliceNum;
+        return (planeId < sliceNum) ? (sliceNum - planeId - 1) / planeNum_ + 1 : 0;
+    }
+    Action RankAction(uint32_t planeId, uint32_t phaseId, uint32_t rankId, uint32_t actionIdx) const
+    {
+        return MakeAction(CalcHalvingTransfer(rankSize_, phaseId, rankId), planeId, rankId,
+                          planeId + actionIdx * planeNum_);
+    }
+
+private:
+    Action MakeAction(const HalvingTransfer& transfer, uint32_t planeId, uint32_t rankId, uint32_t j) const
+    {
+        Action action;
+        action.srcRank = rankId;
+        action.dstRank = transfer.dstRank;
+        action.planeId = planeId;
+        action.sliceId = (transfer.sliceBase + j) % rankSize_;
+        return action;
+    }
+
+    uint32_t rankSize_;
+    uint32_t planeNum_;
+};
+
+uint32_t Gcd(uint32_t a, uint32_t b);
+
+// 选出最多ringNum个步长k（gcd(k, N) = 1，k <= N/2），i -> i+k 构成一个哈密顿环，
+// 不同步长的环边不相交；可用步长不足时返回的数量少于ringNum
+std::vector<uint32_t> CalcRingStrides(uint32_t rankSize, uint32_t ringNum);
+
+// 多ring使用的环数：每个环正反两个方向各占一个plane，每rank度数为2 * 环数；
+// ringLimit > 0 时环数不超过ringLimit（见 ScheduleOptions::ringNum）
+uint32_t CalcMultiRingNum(uint32_t rankSize, uint32_t planeNum, uint32_t ringLimit = 0);
+inline uint32_t CalcMultiRingTarget(uint32_t planeNum, uint32_t ringLimit)
+{
+    uint32_t ringNum = (planeNum / 2 > 0) ? planeNum / 2 : 1;
+    return (ringLimit > 0 && ringLimit < ringNum) ? ringLimit : ringNum;
+}
+
+// plane p 使用第 (p/2) % R 个步长，偶数plane沿 +k 方向，奇数plane沿 -k 方向
+template <typename RankSizeT>
+inline AffinePhase CalcMultiRingPhase(const RankSizeT& rankSize, uint32_t phaseId, uint32_t planeId, uint32_t stride)
+{
+    uint32_t n = rankSize.Value();
+    AffinePhase phase;
+    // 沿环的第 phaseId+1 个前驱/后继即为本phase发送的slice
+    uint32_t offset = rankSize.Wrap((static_cast<uint64_t>(phaseId) + 1) * stride);
+    if (CalcRingOrder(planeId) == RingOrder::CLOCKWISE) {
+        phase.dstOffset = rankSize.Wrap(stride);
+        phase.sliceOffset = rankSize.Wrap(n - offset);
+    } else {
+        phase.dstOffset = rankSize.Wrap(n - stride);
+        phase.sliceOffset = offset;
+    }
+    return phase;
+}
+
+template <typename RankSizeT>
+inline Action MakeMultiRingAction(const RankSizeT& rankSize, uint32_t rankId, uint32_t phaseId, uint32_t planeId,
+                                  uint32_t stride)
+{
+    return MakeAffineAction(rankSize, CalcMultiRingPhase(rankSize, phaseId, planeId, stride), rankId, planeId);
+}
+
+inline Action ConstructMultiRingAction(uint32_t rankSize, uint32_t rankId, uint32_t phaseId, uint32_t planeId,
+                                       uint32_t stride)
+{
+    return MakeMultiRingAction(DynamicRankSize(rankSize), rankId, phaseId, planeId, stride);
+}
+
+template <typename RankSizeT>
+class BasicMultiRingGenerator {
+public:
+    BasicMultiRingGenerator(uint32_t rankSize, uint32_t planeNum, uint32_t ringLimit = 0)
+        : rankSize_(rankSize), strides_(CalcRingStrides(rankSize, CalcMultiRingTarget(planeNum, ringLimit))) {}
+
+    uint32_t RankSize() const { return rankSize_.Value(); }
+    uint32_t PhaseNum() const { return (RankSize() <= 1) ? 0 : RankSize() - 1; }
+    size_t ActionNum(uint32_t, uint32_t) const { return RankSize(); }
+    bool Chunked() const { return false; }
+
+    template <typename EmitT>
+    void EmitRank(uint32_t planeId, uint32_t phaseId, uint32_t rankId, EmitT& emit) const
+    {
+        emit(RankAction(planeId, phaseId, rankId, 0));
+    }
+
+    uint32_t RankActionNum(uint32_t, uint32_t, uint32_t) const { return 1; }
+    Action RankAction(uint32_t planeId, uint32_t phaseId, uint32_t rankId, uint32_t) const
+    {
+        return MakeMultiRingAction(rankSize_, rankId, phaseId, planeId, Stride(planeId));
+    }
+
+    uint32_t Stride(uint32_t planeId) const { return strides_[(planeId / 2) % strides_.size()]; }
+    const RankSizeT& RankSizePolicy() const { return rankSize_; }
+
+private:
+    RankSizeT rankSize_;
+    std::vector<uint32_t> strides_;
+};
+
+using MultiRingGenerator = BasicMultiRingGenerator<DynamicRankSize>;
+
+// MULTI_RING即流水深度为1的CHUNKED_RING：每个plane沿自己的ring只搬运slice的一块，两者共用生成器与估计，
+// 其它算法不切块，流水深度记为1
+inline uint32_t CalcPipelineDepth(ScheduleAlgorithm algorithm, const ScheduleOptions& options)
+{
+    if (algorithm != ScheduleAlgorithm::CHUNKED_RING || options.pipelineDepth == 0) {
+        return 1;
+    }
+    return options.pipelineDepth;
+}
+
+// 异构plane下CHUNKED_RING各plane的块数之比：按带宽量化到最快plane的 1/PLANE_WEIGHT_RESOLUTION，
+// 再除以最大公约数；带宽过低（不到最快plane的 1/(2*分辨率)）或不为正的plane权重为0。
+// 代价模型为同构plane、各plane权重相同或没有带宽为正的plane时返回空（各plane相同）
+constexpr const uint32_t PLANE_WEIGHT_RESOLUTION = 16;
+std::vector<uint32_t> CalcPlaneWeights(const CostModel& costModel, uint32_t planeNum);
+// 代价模型为异构plane且options中未指定权重时填写options.planeWeights
+void ApplyPlaneWeights(const CostModel& costModel, uint32_t planeNum, ScheduleOptions& options);
+// 各plane权重之和，planeWeights为空时为planeNum
+uint64_t CalcTotalPlaneWeight(uint32_t planeNum, const std::vector<uint32_t>& planeWeights);
+// 异构plane时闭式估计的冲突率之和需乘的系数（同构plane时为1）：每个phase由最慢的plane决定，
+// MULTI_RING / CHUNKED_RING为 P * max_p(w_p * r_p) / Σw，其它算法每个plane都搬运整个slice，为 max_p r_p（r_p = B / B_p）
+double CalcPlaneSlowdown(const CostModel& costModel, uint32_t planeNum, ScheduleAlgorithm algorithm,
+                         const ScheduleOptions& options);
+
+// 每个slice切成 W * D 块（W为各plane权重之和，见 ScheduleOptions::planeWeights，同构时W = P）：
+// plane p 沿自己的ring搬运第 (o_p+j)*D+d 块（o_p为之前plane的权重之和，j < w_p，d < D），
+// 第d份推迟d个phase启动，phase t 中同时进行的份为满足 0 <= t-d < N-1 的d
+template <typename RankSizeT>
+class BasicChunkedRingGenerator {
+public:
+    BasicChunkedRingGenerator(uint32_t rankSize, uint32_t planeNum, uint32_t pipelineDepth, uint32_t ringLimit = 0,
+                         const std::vector<uint32_t>& planeWeights = std::vector<uint32_t>())
+        : ring_(rankSize, planeNum, ringLimit),
+          ringPhaseNum_((rankSize <= 1) ? 0 : rankSize - 1),
+          depth_((pipelineDepth == 0) ? 1 : pipelineDepth),
+          weights_(planeWeights)
+    {
+        if (weights_.empty()) {
+            weights_.assign(planeNum, 1);
+        }
+        weights_.resize(planeNum, 0);
+        offsets_.assign(planeNum, 0);
+        uint32_t totalWeight = 0;
+        for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+            offsets_[planeId] = totalWeight;
+            totalWeight += weights_[planeId];
+        }
+        chunkNum_ = static_cast<uint16_t>(totalWeight * depth_);
+    }
+
+    uint32_t RankSize() const { return ring_.RankSize(); }
+    uint32_t PhaseNum() const { return (ringPhaseNum_ == 0) ? 0 : ringPhaseNum_ + depth_ - 1; }
+    size_t ActionNum(uint32_t planeId, uint32_t phaseId) const
+    {
+        return static_cast<size_t>(RankActionNum(planeId, phaseId, 0)) * RankSize();
+    }
+    bool Chunked() const { return true; }
+
+    template <typename EmitT>
+    void EmitRank(uint32_t planeId, uint32_t phaseId, uint32_t rankId, EmitT& emit) const
+    {
+        uint32_t stride = ring_.Stride(planeId);
+        for (uint32_t part = FirstPart(phaseId); part <= LastPart(phaseId); ++part) {
+            for (uint32_t j = 0; j < weights_[planeId]; ++j) {
+                emit(MakeAction(planeId, phaseId, rankId, part, j, stride));
+            }
+        }
+    }
+
+    uint32_t RankActionNum(uint32_t planeId, uint32_t phaseId, uint32_t) const
+    {
+        return (LastPart(phaseId) - FirstPart(phaseId) + 1) * weights_[planeId];
+    }
+    Action RankAction(uint32_t planeId, uint32_t phaseId, uint32_t rankId, uint32_t actionIdx) const
+    {
+        uint32_t weight = weights_[planeId];
+        return MakeAction(planeId, phaseId, rankId, FirstPart(phaseId) + actionIdx / weight, actionIdx % weight,
+                          ring_.Stride(planeId));
+    }
+
+private:
+    uint32_t FirstPart(uint32_t phaseId) const { return (phaseId + 1 > ringPhaseNum_) ? phaseId + 1 - ringPhaseNum_ : 0; }
+    uint32_t LastPart(uint32_t phaseId) const { return (phaseId < depth_ - 1) ? phaseId : depth_ - 1; }
+
+    Action MakeAction(uint32_t planeId, uint32_t phaseId, uint32_t rankId, uint32_t part, uint32_t j,
+                      uint32_t stride) const
+    {
+        Action action = MakeMultiRingAction(ring_.RankSizePolicy(), rankId, phaseId - part, planeId, stride);
+        action.chunkId = static_cast<uint16_t>((offsets_[planeId] + j) * depth_ + part);
+        action.chunkNum = chunkNum_;
+        return action;
+    }
+
+    BasicMultiRingGenerator<RankSizeT> ring_;
+    uint32_t ringPhaseNum_;
+    uint32_t depth_;
+    std::vector<uint32_t> weights_;
+    std::vector<uint32_t> offsets_;
+    uint16_t chunkNum_;
+};
+
+using ChunkedRingGenerator = BasicChunkedRingGenerator<DynamicRankSize>;
+
+// 两级reduce-scatter：rank r = g*R + l 为节点g中的第l个rank（R为每节点rank数，G = N/R个节点），
+// slice s = h*R + m 按m分为R类，每类G个slice。每个slice切成P块，plane p 只搬运第p块，
+// 偶数plane沿 +1 方向、奇数plane沿 -1 方向：
+//   phase t < R-1：节点内以类为单位做ring，(g, l) 把类 (l-t-1) mod R 的G个slice发给 (g, l+1)，
+//                  结束时 (g, l) 持有节点g对类l全部slice的部分和
+//   之后的G-1个phase：各节点第l个rank组成跨节点ring，对类l的G个slice做ring，结束时 (g, l) 持有slice g*R+l
+// 跨节点phase数与每rank的跨节点数据量都是单层ring的 1/R
+inline uint32_t CalcRingDegree(uint32_t rankSize)
+{
+    return (rankSize > 2) ? 2 : rankSize - 1;
+}
+
+inline bool IsHierarchicalShape(uint32_t rankSize, uint32_t ranksPerNode)
+{
+    return rankSize > 1 && ranksPerNode > 0 && rankSize % ranksPerNode == 0;
+}
+
+class HierarchicalGenerator {
+public:
+    HierarchicalGenerator(uint32_t rankSize, uint32_t planeNum, uint32_t ranksPerNode)
+        : rankSize_(rankSize),
+          ranksPerNode_(IsHierarchicalShape(rankSize, ranksPerNode) ? ranksPerNode : rankSize),
+          nodeNum_(rankSize / ranksPerNode_),
+          chunkNum_(static_cast<uint16_t>(planeNum))
+    {
+    }
+
+    uint32_t RankSize() const { return rankSize_; }
+    uint32_t PhaseNum() const { return (rankSize_ <= 1) ? 0 : IntraPhaseNum() + nodeNum_ - 1; }
+    size_t ActionNum(uint32_t planeId, uint32_t phaseId) const
+    {
+        return static_cast<size_t>(RankActionNum(planeId, phaseId, 0)) * rankSize_;
+    }
+    bool Chunked() const { return true; }
+
+    template <typename EmitT>
+    void EmitRank(uint32_t planeId, uint32_t phaseId, uint32_t rankId, EmitT& emit) const
+    {
+        uint32_t actionNum = RankActionNum(planeId, phaseId, rankId);
+        for (uint32_t actionIdx = 0; actionIdx < actionNum; ++actionIdx) {
+            emit(RankAction(planeId, phaseId, rankId, actionIdx));
+        }
+    }
+
+    uint32_t RankActionNum(uint32_t, uint32_t phaseId, uint32_t) const
+    {
+        return (phaseId < IntraPhaseNum()) ? nodeNum_ : 1;
+    }
+    Action RankAction(uint32_t planeId, uint32_t phaseId, uint32_t rankId, uint32_t actionIdx) const
+    {
+        uint32_t nodeId = rankId / ranksPerNode_;
+        uint32_t localId = rankId % ranksPerNode_;
+        Action action;
+        if (phaseId < IntraPhaseNum()) {
+            // 节点内ring，第actionIdx个为类中节点actionIdx的slice
+            Action local = ConstructRingAction(ranksPerNode_, localId, phaseId, planeId);
+            action.srcRank = rankId;
+            action.dstRank = nodeId * ranksPerNode_ + local.dstRank;
+            action.sliceId = actionIdx * ranksPerNode_ + local.sliceId;
+        } else {
+            // 跨节点ring，只搬运本rank所在的类
+            Action global = ConstructRingAction(nodeNum_, nodeId, phaseId - IntraPhaseNum(), planeId);
+            action.srcRank = rankId;
+            action.dstRank = global.dstRank * ranksPerNode_ + localId;
+            action.sliceId = global.sliceId * ranksPerNode_ + localId;
+        }
+        action.planeId = planeId;
+        action.chunkId = static_cast<uint16_t>(planeId);
+        action.chunkNum = chunkNum_;
+        return action;
+    }
+
+    uint32_t RanksPerNode() const { return ranksPerNode_; }
+    uint32_t IntraPhaseNum() const { return ranksPerNode_ - 1; }
+
+private:
+    uint32_t rankSize_;
+    uint32_t ranksPerNode_;
+    uint32_t nodeNum_;
+    uint16_t chunkNum_;
+};
+
+// reduce-scatter的action反向：dst把同一 (slice, chunk) 发给src，plane不变
+inline Action ReverseAction(const Action& action)
+{
+    Action reversed = action;
+    reversed.srcRank = action.dstRank;
+    reversed.dstRank = action.srcRank;
+    return reversed;
+}
+
+template <typename EmitT>
+struct ReverseEmit {
+    EmitT& emit;
+    void operator()(const Action& action) const { emit(ReverseAction(action)); }
+};
+
+// all-gather：reduce-scatter的时间反演。reduce-scatter中slice s的部分和沿一棵汇聚到rank s的树规约，
+// 倒序执行各phase并把action反向，即沿同一棵树从rank s向外广播完整的slice s；通信对与各phase的冲突率不变。
+// EmitRank输出的是rankId在reduce-scatter中发出的action的反向（即rankId接收的action），
+// 只用于整体填充Blueprint，不提供RankActionNum / RankAction
+template <typename GeneratorT>
+class AllGatherGenerator {
+public:
+    explicit AllGatherGenerator(const GeneratorT& base) : base_(base) {}
+
+    uint32_t RankSize() const { return base_.RankSize(); }
+    uint32_t PhaseNum() const { return base_.PhaseNum(); }
+    size_t ActionNum(uint32_t planeId, uint32_t phaseId) const { return base_.ActionNum(planeId, Mirror(phaseId)); }
+    bool Chunked() const { return base_.Chunked(); }
+
+    template <typename EmitT>
+    void EmitRank(uint32_t planeId, uint32_t phaseId, uint32_t rankId, EmitT& emit) const
+    {
+        ReverseEmit<EmitT> reverse{emit};
+        base_.EmitRank(planeId, Mirror(phaseId), rankId, reverse);
+    }
+
+private:
+    uint32_t Mirror(uint32_t phaseId) const { return base_.PhaseNum() - 1 - phaseId; }
+
+    GeneratorT base_;
+};
+
+// all-reduce：reduce-scatter的K个phase后接上述all-gather。reduce-scatter最后一个phase的action u -> s
+// 把slice s交付给rank s，all-gather第一个phase正是其反向 s -> u；两者放在同一phase即为交换，
+// u与s互发phase开始时的部分和，双方都得到完整的和，共 2K-1 个phase。
+// 反向action走同一对rank的另一方向，不增加通信对；与AllGatherGenerator一样只用于整体填充
+template <typename GeneratorT>
+class AllReduceGenerator {
+public:
+    explicit AllReduceGenerator(const GeneratorT& base) : base_(base) {}
+
+    uint32_t RankSize() const { return base_.RankSize(); }
+    uint32_t PhaseNum() const { return (base_.PhaseNum() == 0) ? 0 : 2 * base_.PhaseNum() - 1; }
+    size_t ActionNum(uint32_t planeId, uint32_t phaseId) const
+    {
+        uint32_t last = base_.PhaseNum() - 1;
+        if (phaseId < last) {
+            return base_.ActionNum(planeId, phaseId);
+        }
+        if (phaseId == last) {
+            return 2 * base_.ActionNum(planeId, last);
+        }
+        return base_.ActionNum(planeId, 2 * last - phaseId);
+    }
+    bool Chunked() const { return base_.Chunked(); }
+
+    template <typename EmitT>
+    void EmitRank(uint32_t planeId, uint32_t phaseId, uint32_t rankId, EmitT& emit) const
+    {
+        uint32_t last = base_.PhaseNum() - 1;
+        ReverseEmit<EmitT> reverse{emit};
+        if (phaseId <= last) {
+            base_.EmitRank(planeId, phaseId, rankId, emit);
+        }
+        if (phaseId >= last) {
+            base_.EmitRank(planeId, 2 * last - phaseId, rankId, reverse);
+        }
+    }
+
+private:
+    GeneratorT base_;
+};
+
+// 各算法在代价模型下的闭式估计，与test_simple中的评分方式一致：
+// 每对rank之间分配一条边，冲突率为同一phase内同一(src,dst)上的action数
+struct ScheduleEstimate {
+    bool feasible;        // 每rank度数是否不超过planeNum
+    uint32_t phaseNum;
+    double conflictSum;   // Σ_k 第k个phase的最大冲突率
+    uint32_t rankDegree;  // 每个rank的通信对端数，各算法中所有rank相同
+    // options.ranksPerNode > 0 时含跨节点通信的phase数及其冲突率之和（已计入phaseNum / conflictSum）
+    uint32_t interPhaseNum;
+    double interConflictSum;
+};
+
+ScheduleEstimate EstimateRing(uint32_t rankSize, uint32_t planeNum);
+ScheduleEstimate EstimateHalving(uint32_t rankSize, uint32_t planeNum);
+ScheduleEstimate EstimateMultiRing(uint32_t rankSize, uint32_t planeNum, uint32_t ringLimit = 0);
+ScheduleEstimate EstimateChunkedRing(uint32_t rankSize, uint32_t planeNum, uint32_t pipelineDepth,
+                                     uint32_t ringLimit = 0);
+ScheduleEstimate EstimateHierarchical(uint32_t rankSize, uint32_t planeNum, uint32_t ranksPerNode);
+// options.parallelEdges时按并行边拓扑估计：各算法的每个对端地位相同，
+// 每对均匀分配 planeNum / rankDegree 条边，冲突率随之等比例下降。
+// options.ranksPerNode > 0 时，单层算法的每个phase都有跨节点的链路（N、R均为2的幂时递归减半距离小于R的步除外）
+ScheduleEstimate EstimateSchedule(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm,
+                                  const ScheduleOptions& options);
+
+// 代价模型为多节点且options中未指定时填写options.ranksPerNode
+void ApplyNodeTopology(const CostModel& costModel, ScheduleOptions& options);
+// 按代价模型计算估计的通信时间：计入异构plane的减速（见 CalcPlaneSlowdown）与跨节点phase，不可行时为无穷大
+double EstimateCommunicationTime(const CostModel& costModel, uint32_t rankSize, uint32_t planeNum,
+                                 ScheduleAlgorithm algorithm, const ScheduleOptions& options,
+                                 const ScheduleEstimate& estimate);
+
+// 实际使用的算法：HALVING度数超过planeNum、MULTI_RING / CHUNKED_RING度数超过planeNum或块数超出16位、
+// HIERARCHICAL的ranksPerNode不整除N或度数超过planeNum时退回MULTI_RING（即流水深度为1的CHUNKED_RING，P >= 2时可行），
+// MULTI_RING也不可行时才退回RING；请求RING或AUTO时为RING
+ScheduleAlgorithm ResolveFeasibleAlgorithm(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm,
+                                           const ScheduleOptions& options);
+
+// 按 plane -> phase -> rank 顺序输出一个phase的全部action
+template <typename GeneratorT, typename EmitT>
+void EmitPhase(const GeneratorT& generator, uint32_t planeId, uint32_t phaseId, EmitT& emit)
+{
+    for (uint32_t rankId = 0; rankId < generator.RankSize(); ++rankId) {
+        generator.EmitRank(planeId, phaseId, rankId, emit);
+    }
+}
+
+} // namespace SolutionUtils
+
+#endif // CPP_SCHEDULE_GENERATORS_H
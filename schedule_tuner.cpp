@@ -0,0 +1,258 @@
+//
+// 离线调度调优实现
+//
+
+#include "schedule_tuner.h"
+#include "schedule_generators.h"
+#include "lazy_blueprint.h"
+#include "flat_blueprint.h"
+#include "blueprint_scorer.h"
+#include "edge_allocator.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+using namespace SolutionUtils;
+
+namespace {
+
+struct Candidate {
+    ScheduleAlgorithm algorithm;
+    uint32_t pipelineDepth;
+    uint32_t ringNum;
+    double estimate;
+};
+
+void SetError(string* error, const string& message)
+{
+    if (error != nullptr) {
+        *error = message;
+    }
+}
+
+size_t CountActions(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm, const ScheduleOptions& options)
+{
+    LazyBlueprint lazy(rankSize, planeNum, algorithm, options);
+    size_t actionNum = 0;
+    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+        for (uint32_t phaseId = 0; phaseId < lazy.PhaseNum(); ++phaseId) {
+            actionNum += lazy.PhaseActionNum(planeId, phaseId);
+        }
+    }
+    return actionNum;
+}
+
+} // namespace
+
+bool TuningTable::Find(uint32_t rankSize, uint32_t planeNum, TunedSchedule& schedule) const
+{
+    auto it = entries_.find(MakeKey(rankSize, planeNum));
+    if (it == entries_.end()) {
+        return false;
+    }
+    schedule = it->second;
+    return true;
+}
+
+void TuningTable::Set(uint32_t rankSize, uint32_t planeNum, const TunedSchedule& schedule)
+{
+    entries_[MakeKey(rankSize, planeNum)] = schedule;
+}
+
+bool TuningTable::Save(const string& path, string* error) const
+{
+    ofstream file(path, ios::trunc);
+    if (!file.is_open()) {
+        SetError(error, "无法打开文件: " + path);
+        return false;
+    }
+    // 按 (N, P) 排序输出，便于比较不同次调优的结果
+    vector<uint64_t> keys;
+    keys.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+        keys.push_back(entry.first);
+    }
+    sort(keys.begin(), keys.end());
+
+    file << "# rank_size plane_num algorithm pipeline_depth ring_num time_ms" << endl;
+    file << setprecision(9);
+    for (uint64_t key : keys) {
+        const TunedSchedule& schedule = entries_.at(key);
+        file << (key >> 32) << ' ' << (key & 0xFFFFFFFFu) << ' ' << ScheduleAlgorithmName(schedule.algorithm) << ' '
+             << schedule.pipelineDepth << ' ' << schedule.ringNum << ' ' << schedule.time << endl;
+    }
+    if (!file.good()) {
+        SetError(error, "写入文件失败: " + path);
+        return false;
+    }
+    return true;
+}
+
+bool TuningTable::Load(const string& path, string* error)
+{
+    ifstream file(path);
+    if (!file.is_open()) {
+        SetError(error, "无法打开文件: " + path);
+        return false;
+    }
+    unordered_map<uint64_t, TunedSchedule> entries;
+    string line;
+    size_t lineNo = 0;
+    while (getline(file, line)) {
+        ++lineNo;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#') {
+            continue;
+        }
+        istringstream fields(line);
+        uint32_t rankSize = 0;
+        uint32_t planeNum = 0;
+        string algorithmName;
+        TunedSchedule schedule;
+        if (!(fields >> rankSize >> planeNum >> algorithmName >> schedule.pipelineDepth >> schedule.ringNum >>
+              schedule.time) ||
+            !ParseScheduleAlgorithm(algorithmName, schedule.algorithm) ||
+            schedule.algorithm == ScheduleAlgorithm::AUTO) {
+            SetError(error, path + ":" + to_string(lineNo) + ": 格式错误");
+            return false;
+        }
+        entries[MakeKey(rankSize, planeNum)] = schedule;
+    }
+    entries_.swap(entries);
+    return true;
+}
+
+TunedSchedule ScheduleTuner::Tune(uint32_t rankSize, uint32_t planeNum, TuneStats* stats) const
+{
+    ScheduleOptions options = baseOptions_;
+    options.threadNum = 1;
+    ApplyPlaneWeights(costModel_, planeNum, options);
+    ApplyNodeTopology(costModel_, options);
+
+    // 枚举参数空间：ring、递归减半、各环数的多ring、各环数 × 流水深度的切块ring
+    vector<Candidate> candidates;
+    auto addCandidate = [&](ScheduleAlgorithm algorithm, uint32_t pipelineDepth, uint32_t ringNum) {
+        options.pipelineDepth = pipelineDepth;
+        options.ringNum = ringNum;
+        // 不可行时生成会退回MULTI_RING或RING，与对应候选重复
+        if (ResolveFeasibleAlgorithm(rankSize, planeNum, algorithm, options) != algorithm) {
+            return;
+        }
+        ScheduleEstimate estimate = EstimateSchedule(rankSize, planeNum, algorithm, options);
+        if (!estimate.feasible) {
+            return;
+        }
+        Candidate candidate;
+        candidate.algorithm = algorithm;
+        candidate.pipelineDepth = pipelineDepth;
+        candidate.ringNum = ringNum;
+        candidate.estimate = EstimateCommunicationTime(costModel_, rankSize, planeNum, algorithm, options, estimate);
+        candidates.push_back(candidate);
+    };
+    addCandidate(ScheduleAlgorithm::RING, 1, 0);
+    addCandidate(ScheduleAlgorithm::HALVING, 1, 0);
+    uint32_t maxRingNum = CalcMultiRingNum(rankSize, planeNum);
+    for (uint32_t ringNum = 1; ringNum <= maxRingNum; ++ringNum) {
+        for (uint32_t depth = 1; depth <= max(tunerOptions_.maxPipelineDepth, 1u); depth *= 2) {
+            addCandidate(ScheduleAlgorithm::CHUNKED_RING, depth, ringNum);
+        }
+    }
+
+    TunedSchedule best;
+    best.time = numeric_limits<double>::infinity();
+    if (stats != nullptr) {
+        stats->candidateNum += candidates.size();
+    }
+    if (candidates.empty()) {
+        return best;
+    }
+
+    // 估计相同时保留枚举顺序，即更简单的算法、更少的环、更浅的流水优先
+    stable_sort(candidates.begin(), candidates.end(),
+                [](const Candidate& a, const Candidate& b) { return a.estimate < b.estimate; });
+    double pruneLimit = candidates.front().estimate * tunerOptions_.pruneSlack;
+
+    Solution solution(costModel_);
+    BlueprintScorer scorer(costModel_);
+    EdgeAllocator allocator;
+    FlatBlueprint blueprint;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const Candidate& candidate = candidates[i];
+        if (i >= tunerOptions_.minScoredNum && candidate.estimate > pruneLimit) {
+            break;  // 已按估计排序，之后的候选都被剪掉
+        }
+        options.pipelineDepth = candidate.pipelineDepth;
+        options.ringNum = candidate.ringNum;
+
+        double time = candidate.estimate;
+        if (CountActions(rankSize, planeNum, candidate.algorithm, options) <= tunerOptions_.maxActionNum) {
+            solution.SetScheduleOptions(options);
+            solution.ConstructBluePrint(rankSize, planeNum, blueprint, candidate.algorithm);
+            if (options.parallelEdges) {
+                EdgeAllocation allocation = allocator.Allocate(blueprint, rankSize, planeNum);
+                time = scorer.CalculateCommunicationTime(blueprint, rankSize, planeNum, allocation);
+            } else {
+                time = scorer.CalculateCommunicationTime(blueprint, rankSize, planeNum);
+            }
+            if (stats != nullptr) {
+                ++stats->scoredNum;
+            }
+        }
+        if (time < best.time) {
+            best.algorithm = candidate.algorithm;
+            best.pipelineDepth = candidate.pipelineDepth;
+            best.ringNum = candidate.ringNum;
+            best.time = time;
+        }
+    }
+    return best;
+}
+
+TuneStats ScheduleTuner::TuneAll(const vector<pair<uint32_t, uint32_t>>& shapes, TuningTable& table) const
+{
+    uint32_t threadNum = tunerOptions_.threadNum;
+    if (threadNum == 0) {
+        threadNum = thread::hardware_concurrency();
+    }
+    threadNum = max(1u, min<uint32_t>(threadNum, static_cast<uint32_t>(shapes.size())));
+
+    // 各形状的结果写入各自的位置，最后按输入顺序写表，与线程数无关
+    vector<TunedSchedule> results(shapes.size());
+    vector<TuneStats> threadStats(threadNum);
+    atomic<size_t> nextShape(0);
+    auto worker = [&](uint32_t threadId) {
+        for (;;) {
+            size_t index = nextShape.fetch_add(1, memory_order_relaxed);
+            if (index >= shapes.size()) {
+                break;
+            }
+            results[index] = Tune(shapes[index].first, shapes[index].second, &threadStats[threadId]);
+        }
+    };
+
+    vector<thread> threads;
+    for (uint32_t threadId = 1; threadId < threadNum; ++threadId) {
+        threads.emplace_back(worker, threadId);
+    }
+    worker(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    TuneStats total;
+    for (const TuneStats& stats : threadStats) {
+        total.candidateNum += stats.candidateNum;
+        total.scoredNum += stats.scoredNum;
+    }
+    for (size_t index = 0; index < shapes.size(); ++index) {
+        if (results[index].time < numeric_limits<double>::infinity()) {
+            table.Set(shapes[index].first, shapes[index].second, results[index]);
+        }
+    }
+    return total;
+}
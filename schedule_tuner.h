@@ -0,0 +1,90 @@
+//
+// 离线调度调优：对每个 (N, P) 在 算法 × 环数 × 流水深度 的参数空间中搜索，
+// 先用闭式估计（schedule_generators.h）排序并剪枝，再把剩余候选实际生成并用评分器打分，
+// 取通信时间最小者写入调优表。调优表可保存为文本文件，Solution在AUTO时优先查表。
+//
+
+#ifndef CPP_SCHEDULE_TUNER_H
+#define CPP_SCHEDULE_TUNER_H
+
+#include "solution.h"
+#include "cost_model.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 一个 (N, P) 的调优结果
+struct TunedSchedule {
+    ScheduleAlgorithm algorithm{ScheduleAlgorithm::RING};
+    uint32_t pipelineDepth{1};
+    uint32_t ringNum{0};  // 同 ScheduleOptions::ringNum
+    double time{0.0};     // 调优时评分器给出的通信时间 ms
+
+    // 把调优参数覆盖到options上，其余字段（线程数等）保持不变
+    void ApplyTo(ScheduleOptions& options) const
+    {
+        options.pipelineDepth = pipelineDepth;
+        options.ringNum = ringNum;
+    }
+};
+
+// 以 (N, P) 为键的调优表。文本格式每行一条：
+//   rank_size plane_num algorithm pipeline_depth ring_num time_ms
+// 以#开头的行为注释；同一 (N, P) 出现多次时以最后一条为准
+class TuningTable {
+public:
+    bool Find(uint32_t rankSize, uint32_t planeNum, TunedSchedule& schedule) const;
+    void Set(uint32_t rankSize, uint32_t planeNum, const TunedSchedule& schedule);
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    void Clear() { entries_.clear(); }
+
+    // 失败时返回false并在error中给出原因；Load失败时表保持原样
+    bool Save(const std::string& path, std::string* error = nullptr) const;
+    bool Load(const std::string& path, std::string* error = nullptr);
+
+private:
+    static uint64_t MakeKey(uint32_t rankSize, uint32_t planeNum)
+    {
+        return (static_cast<uint64_t>(rankSize) << 32) | planeNum;
+    }
+
+    std::unordered_map<uint64_t, TunedSchedule> entries_;
+};
+
+struct TunerOptions {
+    uint32_t threadNum{1};          // 并行调优的形状数，0为全部硬件线程
+    uint32_t maxPipelineDepth{8};   // CHUNKED_RING尝试的流水深度为 1, 2, 4, ... 不超过此值
+    double pruneSlack{1.05};        // 只打分闭式估计不超过最优估计 pruneSlack 倍的候选
+    uint32_t minScoredNum{3};       // 剪枝后至少打分的候选数（按估计从小到大）
+    size_t maxActionNum{1 << 26};   // 生成的action数超过此值的候选只用闭式估计，不实际打分
+};
+
+struct TuneStats {
+    size_t candidateNum{0};  // 参数空间中可行的候选数
+    size_t scoredNum{0};     // 实际生成并打分的候选数
+};
+
+class ScheduleTuner {
+public:
+    // baseOptions中除pipelineDepth/ringNum以外的字段（如parallelEdges）参与估计，生成固定为单线程
+    explicit ScheduleTuner(const CostModel& costModel = CostModel(),
+                           const ScheduleOptions& baseOptions = ScheduleOptions(),
+                           const TunerOptions& tunerOptions = TunerOptions())
+        : costModel_(costModel), baseOptions_(baseOptions), tunerOptions_(tunerOptions) {}
+
+    // 调优单个形状；不修改对象状态，可在多个线程中同时调用
+    TunedSchedule Tune(uint32_t rankSize, uint32_t planeNum, TuneStats* stats = nullptr) const;
+    // 按TunerOptions::threadNum并行调优全部形状并写入table，返回各形状的统计之和
+    TuneStats TuneAll(const std::vector<std::pair<uint32_t, uint32_t>>& shapes, TuningTable& table) const;
+
+private:
+    CostModel costModel_;
+    ScheduleOptions baseOptions_;
+    TunerOptions tunerOptions_;
+};
+
+#endif // CPP_SCHEDULE_TUNER_H
@@ -0,0 +1,419 @@
+//
+// 集合通信语义校验实现
+//
+
+#include "semantic_verifier.h"
+#include <sstream>
+
+using namespace std;
+
+constexpr uint32_t SemanticVerifier::SELF;
+constexpr uint32_t SemanticVerifier::EMPTY;
+constexpr uint32_t SemanticVerifier::COMPLETE;
+constexpr uint32_t SemanticVerifier::MARK_RECV;
+constexpr uint32_t SemanticVerifier::MARK_SEND;
+
+const char* VerifyErrorName(VerifyError error)
+{
+    switch (error) {
+        case VerifyError::NONE:
+            return "none";
+        case VerifyError::INVALID_ACTION:
+            return "invalid_action";
+        case VerifyError::MIXED_CHUNK_NUM:
+            return "mixed_chunk_num";
+        case VerifyError::DEGREE_EXCEEDED:
+            return "degree_exceeded";
+        case VerifyError::SEND_WITHOUT_DATA:
+            return "send_without_data";
+        case VerifyError::READ_BEFORE_ARRIVAL:
+            return "read_before_arrival";
+        case VerifyError::DOUBLE_COUNT:
+            return "double_count";
+        case VerifyError::MISSING_CONTRIBUTION:
+            return "missing_contribution";
+    }
+    return "unknown";
+}
+
+namespace {
+
+inline bool TestBit(const uint64_t* bits, uint32_t idx)
+{
+    return (bits[idx / 64] >> (idx % 64)) & 1;
+}
+
+inline void SetBit(uint64_t* bits, uint32_t idx)
+{
+    bits[idx / 64] |= 1ULL << (idx % 64);
+}
+
+inline uint32_t CountBits(const uint64_t* bits, size_t words)
+{
+    uint32_t count = 0;
+    for (size_t word = 0; word < words; ++word) {
+        count += static_cast<uint32_t>(__builtin_popcountll(bits[word]));
+    }
+    return count;
+}
+
+// 返回 a & b 中最小的位，没有交集时返回false
+bool FirstCommonBit(const uint64_t* a, const uint64_t* b, size_t words, uint32_t& idx)
+{
+    for (size_t word = 0; word < words; ++word) {
+        uint64_t common = a[word] & b[word];
+        if (common != 0) {
+            idx = static_cast<uint32_t>(word * 64 + __builtin_ctzll(common));
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool SemanticVerifier::Before(uint32_t phaseId, const Located& located) const
+{
+    if (result_.ok) {
+        return true;
+    }
+    if (!result_.hasAction || phaseId != result_.phaseId) {
+        return !result_.hasAction || phaseId < result_.phaseId;
+    }
+    if (located.planeId != result_.planeId) {
+        return located.planeId < result_.planeId;
+    }
+    return located.actionIdx < result_.actionIdx;
+}
+
+void SemanticVerifier::Report(VerifyError error, uint32_t phaseId, const Located& located, uint32_t rankId,
+                              uint32_t sliceId, uint32_t contributorId)
+{
+    if (!Before(phaseId, located)) {
+        return;
+    }
+    result_.ok = false;
+    result_.error = error;
+    result_.hasAction = true;
+    result_.planeId = located.planeId;
+    result_.phaseId = phaseId;
+    result_.actionIdx = located.actionIdx;
+    result_.action = located.action;
+    result_.rankId = rankId;
+    result_.sliceId = sliceId;
+    result_.chunkId = located.action.chunkId;
+    result_.contributorId = contributorId;
+}
+
+void SemanticVerifier::CheckAction(uint32_t phaseId, const Located& located, uint32_t N, uint32_t P)
+{
+    if (!result_.ok) {
+        return;
+    }
+    const Action& action = located.action;
+    if (action.srcRank >= N || action.dstRank >= N || action.sliceId >= N || action.planeId != located.planeId ||
+        action.chunkNum == 0 || action.chunkId >= action.chunkNum) {
+        Report(VerifyError::INVALID_ACTION, phaseId, located, action.srcRank, action.sliceId, 0);
+        return;
+    }
+    if (chunkNum_ == 0) {
+        chunkNum_ = action.chunkNum;
+    } else if (action.chunkNum != chunkNum_) {
+        Report(VerifyError::MIXED_CHUNK_NUM, phaseId, located, action.srcRank, action.sliceId, 0);
+        return;
+    }
+    if (action.srcRank == action.dstRank) {
+        return;
+    }
+    uint32_t u = min(action.srcRank, action.dstRank);
+    uint32_t v = max(action.srcRank, action.dstRank);
+    if (pairs_.Get(u, v) != 0) {
+        return;
+    }
+    pairs_.At(u, v) = 1;
+    if (++degree_[u] > P) {
+        Report(VerifyError::DEGREE_EXCEEDED, phaseId, located, u, action.sliceId, v);
+    } else if (++degree_[v] > P) {
+        Report(VerifyError::DEGREE_EXCEEDED, phaseId, located, v, action.sliceId, u);
+    }
+}
+
+void SemanticVerifier::ResetState(uint32_t N)
+{
+    rankSize_ = N;
+    words_ = (static_cast<size_t>(N) + 63) / 64;
+    if (collective_ == Collective::ALL_GATHER) {
+        state_.assign(static_cast<size_t>(N) * N * chunkNum_, EMPTY);
+        for (uint32_t chunkId = 0; chunkId < chunkNum_; ++chunkId) {
+            for (uint32_t rankId = 0; rankId < N; ++rankId) {
+                state_[Key(rankId, rankId, chunkId)] = COMPLETE;
+            }
+        }
+    } else {
+        state_.assign(static_cast<size_t>(N) * N * chunkNum_, SELF);
+    }
+    mark_.assign(state_.size(), 0);
+    if (collective_ == Collective::ALL_REDUCE) {
+        recvFrom_.assign(state_.size(), 0);
+    }
+    stamp_ = 0;
+    pool_.clear();
+    freeSlots_.clear();
+}
+
+uint32_t SemanticVerifier::AllocBits()
+{
+    uint32_t slot;
+    if (!freeSlots_.empty()) {
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(pool_.size() / words_);
+        pool_.resize(pool_.size() + words_);
+    }
+    fill(Bits(slot), Bits(slot) + words_, 0ULL);
+    return slot;
+}
+
+void SemanticVerifier::FreeBits(uint32_t slot)
+{
+    freeSlots_.push_back(slot);
+}
+
+void SemanticVerifier::RunPhase(uint32_t phaseId)
+{
+    ++stamp_;
+    uint32_t phaseMark = stamp_ << 2;
+    bool exchangeable = collective_ == Collective::ALL_REDUCE;
+    for (const Located& located : phaseActions_) {
+        const Action& action = located.action;
+        size_t key = Key(action.dstRank, action.sliceId, action.chunkId);
+        mark_[key] = phaseMark | MARK_RECV;
+        if (exchangeable) {
+            recvFrom_[key] = action.srcRank;
+        }
+    }
+
+    // 发送：读取phase开始时的部分和
+    updates_.clear();
+    for (size_t idx = 0; idx < phaseActions_.size(); ++idx) {
+        const Located& located = phaseActions_[idx];
+        const Action& action = located.action;
+        size_t key = Key(action.srcRank, action.sliceId, action.chunkId);
+        uint32_t mark = ((mark_[key] & ~3u) == phaseMark) ? mark_[key] : phaseMark;
+        mark_[key] = mark | MARK_SEND;
+        uint32_t slot = state_[key];
+        if ((mark & MARK_SEND) != 0 && slot != COMPLETE) {
+            // 同一部分和在一个phase内被发出两次，接收方会重复累加
+            Report(VerifyError::DOUBLE_COUNT, phaseId, located, action.srcRank, action.sliceId, action.srcRank);
+            continue;
+        }
+        bool exchange = exchangeable && (mark & MARK_RECV) != 0 && recvFrom_[key] == action.dstRank;
+        if ((mark & MARK_RECV) != 0 && !exchange) {
+            Report(VerifyError::READ_BEFORE_ARRIVAL, phaseId, located, action.srcRank, action.sliceId, 0);
+            continue;
+        }
+        if (slot == EMPTY) {
+            Report(VerifyError::SEND_WITHOUT_DATA, phaseId, located, action.srcRank, action.sliceId, 0);
+            continue;
+        }
+
+        Update update;
+        update.dstKey = Key(action.dstRank, action.sliceId, action.chunkId);
+        update.dstRank = action.dstRank;
+        update.sliceId = action.sliceId;
+        update.srcRank = action.srcRank;
+        update.locatedIdx = idx;
+        update.srcSlot = slot;
+        if (exchange && slot != SELF && slot != COMPLETE) {
+            // 交换后发送方仍持有自己的部分和，交出的是副本
+            update.srcSlot = AllocBits();
+            copy(Bits(slot), Bits(slot) + words_, Bits(update.srcSlot));
+        } else if (slot != COMPLETE && !exchange) {
+            state_[key] = EMPTY;
+        }
+        updates_.push_back(update);
+    }
+
+    // 接收：累加到目标rank的部分和，检查贡献是否重叠。
+    // 发出的位集已与发送方脱离，接收方不持有数据时直接接管，避免拷贝
+    for (const Update& update : updates_) {
+        const Located& located = phaseActions_[update.locatedIdx];
+        uint32_t slot = state_[update.dstKey];
+        if (update.srcSlot == COMPLETE || slot == COMPLETE) {
+            // 完整的和只能交给不持有该slice的rank
+            if (slot == EMPTY) {
+                state_[update.dstKey] = COMPLETE;
+                continue;
+            }
+            uint32_t contributor = (slot == COMPLETE) ? FirstContributor(update.srcSlot, update.srcRank) :
+                                                        FirstContributor(slot, update.dstRank);
+            Report(VerifyError::DOUBLE_COUNT, phaseId, located, update.dstRank, update.sliceId, contributor);
+            if (update.srcSlot != SELF && update.srcSlot != COMPLETE) {
+                FreeBits(update.srcSlot);
+            }
+            continue;
+        }
+        if (update.srcSlot == SELF) {
+            if (slot == EMPTY || slot == SELF) {
+                uint32_t newSlot = AllocBits();
+                if (slot == SELF) {
+                    SetBit(Bits(newSlot), update.dstRank);
+                }
+                state_[update.dstKey] = newSlot;
+                slot = newSlot;
+            }
+            uint64_t* target = Bits(slot);
+            if (TestBit(target, update.srcRank)) {
+                Report(VerifyError::DOUBLE_COUNT, phaseId, located, update.dstRank, update.sliceId, update.srcRank);
+            }
+            SetBit(target, update.srcRank);
+            SettleComplete(update.dstKey);
+            continue;
+        }
+
+        uint64_t* payload = Bits(update.srcSlot);
+        if (slot == EMPTY || slot == SELF) {
+            if (slot == SELF) {
+                if (TestBit(payload, update.dstRank)) {
+                    Report(VerifyError::DOUBLE_COUNT, phaseId, located, update.dstRank, update.sliceId,
+                           update.dstRank);
+                }
+                SetBit(payload, update.dstRank);
+            }
+            state_[update.dstKey] = update.srcSlot;
+            SettleComplete(update.dstKey);
+            continue;
+        }
+        uint64_t* target = Bits(slot);
+        uint32_t contributor = 0;
+        if (FirstCommonBit(target, payload, words_, contributor)) {
+            Report(VerifyError::DOUBLE_COUNT, phaseId, located, update.dstRank, update.sliceId, contributor);
+        }
+        for (size_t word = 0; word < words_; ++word) {
+            target[word] |= payload[word];
+        }
+        FreeBits(update.srcSlot);
+        SettleComplete(update.dstKey);
+    }
+}
+
+void SemanticVerifier::SettleComplete(size_t key)
+{
+    uint32_t slot = state_[key];
+    if (collective_ == Collective::REDUCE_SCATTER || slot == SELF || slot == EMPTY || slot == COMPLETE) {
+        return;
+    }
+    if (CountBits(Bits(slot), words_) == rankSize_) {
+        FreeBits(slot);
+        state_[key] = COMPLETE;
+    }
+}
+
+uint32_t SemanticVerifier::FirstContributor(uint32_t slot, uint32_t rankId)
+{
+    if (slot == SELF) {
+        return rankId;
+    }
+    if (slot == EMPTY || slot == COMPLETE) {
+        return 0;
+    }
+    const uint64_t* bits = Bits(slot);
+    for (size_t word = 0; word < words_; ++word) {
+        if (bits[word] != 0) {
+            return static_cast<uint32_t>(word * 64 + __builtin_ctzll(bits[word]));
+        }
+    }
+    return 0;
+}
+
+void SemanticVerifier::CheckFinalState()
+{
+    uint32_t N = rankSize_;
+    for (uint32_t chunkId = 0; chunkId < chunkNum_; ++chunkId) {
+        for (uint32_t sliceId = 0; sliceId < N; ++sliceId) {
+            uint32_t slot = state_[Key(sliceId, sliceId, chunkId)];
+            for (uint32_t rankId = 0; rankId < N; ++rankId) {
+                bool present = (slot == SELF) ? rankId == sliceId : (slot != EMPTY && TestBit(Bits(slot), rankId));
+                if (present) {
+                    continue;
+                }
+                result_.ok = false;
+                result_.error = VerifyError::MISSING_CONTRIBUTION;
+                result_.hasAction = false;
+                result_.rankId = sliceId;
+                result_.sliceId = sliceId;
+                result_.chunkId = chunkId;
+                result_.contributorId = rankId;
+                return;
+            }
+        }
+    }
+}
+
+void SemanticVerifier::CheckCompleteState()
+{
+    uint32_t N = rankSize_;
+    for (uint32_t chunkId = 0; chunkId < chunkNum_; ++chunkId) {
+        for (uint32_t sliceId = 0; sliceId < N; ++sliceId) {
+            for (uint32_t rankId = 0; rankId < N; ++rankId) {
+                uint32_t slot = state_[Key(rankId, sliceId, chunkId)];
+                if (slot == COMPLETE || (slot == SELF && N == 1)) {
+                    continue;
+                }
+                // 首个缺少的贡献者
+                uint32_t missing = 0;
+                while (missing < N && ((slot == SELF && missing == rankId) ||
+                                       (slot != SELF && slot != EMPTY && TestBit(Bits(slot), missing)))) {
+                    ++missing;
+                }
+                result_.ok = false;
+                result_.error = VerifyError::MISSING_CONTRIBUTION;
+                result_.hasAction = false;
+                result_.rankId = rankId;
+                result_.sliceId = sliceId;
+                result_.chunkId = chunkId;
+                result_.contributorId = missing;
+                return;
+            }
+        }
+    }
+}
+
+string SemanticVerifier::Describe() const
+{
+    ostringstream out;
+    out << VerifyErrorName(result_.error) << ": ";
+    if (result_.hasAction) {
+        const Action& action = result_.action;
+        out << "plane " << result_.planeId << " phase " << result_.phaseId << " action " << result_.actionIdx
+            << " (" << action.srcRank << "->" << action.dstRank << ", slice " << action.sliceId << ", chunk "
+            << action.chunkId << "/" << action.chunkNum << ")";
+    }
+    switch (result_.error) {
+        case VerifyError::DEGREE_EXCEEDED:
+            out << " rank " << result_.rankId << " 的对端数超过P";
+            break;
+        case VerifyError::SEND_WITHOUT_DATA:
+            out << " rank " << result_.rankId << " 已不持有该slice的部分和";
+            break;
+        case VerifyError::READ_BEFORE_ARRIVAL:
+            out << " rank " << result_.rankId << " 在同一phase内还会收到该slice";
+            break;
+        case VerifyError::DOUBLE_COUNT:
+            out << " rank " << result_.rankId << " 重复累加了rank " << result_.contributorId << " 的贡献";
+            break;
+        case VerifyError::MISSING_CONTRIBUTION:
+            if (collective_ == Collective::ALL_GATHER) {
+                out << "rank " << result_.rankId << " 没有收到slice " << result_.sliceId << " (chunk "
+                    << result_.chunkId << ")";
+                break;
+            }
+            out << "rank " << result_.rankId << " 的slice " << result_.sliceId << " (chunk " << result_.chunkId
+                << ") 缺少rank " << result_.contributorId << " 的贡献";
+            break;
+        default:
+            break;
+    }
+    return out.str();
+}
@@ -0,0 +1,211 @@
+//
+// 集合通信语义校验：逐phase模拟各rank持有的部分和，
+// 以位集记录每个 (rank, slice) 的部分和包含了哪些rank的贡献。
+// reduce-scatter检查最终rank i 是否恰好持有全部N个rank对slice i的贡献；
+// all-gather / all-reduce检查最终每个rank是否都持有每个slice的完整的和。
+//
+// 语义约定：
+//   - reduce-scatter / all-reduce中每个rank初始持有自己对每个slice的贡献，
+//     all-gather中rank i 初始只持有完整的slice i
+//   - action (u -> v, slice s, chunk c) 把 u 在phase开始时持有的 (s, c) 部分和整体交给 v，
+//     v 与自己持有的部分和相加，u 不再持有 (s, c)
+//   - all-gather / all-reduce中已包含全部N个贡献的 (s, c) 发送后 u 仍持有（广播），v 必须不持有 (s, c)；
+//     all-reduce中同一phase内 u 与 v 互发同一 (s, c) 为交换，双方都得到两者之和
+//   - 同一phase内收到的数据要到下一个phase才能转发（交换除外）
+//   - 不同chunk是相互独立的数据流，要求所有action的chunkNum一致
+//
+
+#ifndef CPP_SEMANTIC_VERIFIER_H
+#define CPP_SEMANTIC_VERIFIER_H
+
+#include "solution.h"
+#include "blueprint_scorer.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class VerifyError {
+    NONE,
+    INVALID_ACTION,        // rank/slice/chunk越界或planeId与所在plane不符
+    MIXED_CHUNK_NUM,       // action的chunkNum不一致
+    DEGREE_EXCEEDED,       // 某个rank的通信对端数超过P
+    SEND_WITHOUT_DATA,     // 发送的 (slice, chunk) 已经交出且之后没有再收到
+    READ_BEFORE_ARRIVAL,   // 同一phase内先转发、后收到同一 (slice, chunk)
+    DOUBLE_COUNT,          // 同一贡献被累加两次（包括同一phase内重复发送同一部分和）
+    MISSING_CONTRIBUTION   // 结束时rank i 的slice i 缺少某些rank的贡献
+};
+
+const char* VerifyErrorName(VerifyError error);
+
+struct VerifyResult {
+    bool ok{true};
+    VerifyError error{VerifyError::NONE};
+    // 首个违规action的位置；MISSING_CONTRIBUTION没有对应的action，hasAction为false
+    bool hasAction{false};
+    uint32_t planeId{0};
+    uint32_t phaseId{0};
+    size_t actionIdx{0};
+    Action action;
+    // 出错的 (rank, slice, chunk) 及首个重复/缺失的贡献者
+    uint32_t rankId{0};
+    uint32_t sliceId{0};
+    uint32_t chunkId{0};
+    uint32_t contributorId{0};
+    std::string message;
+};
+
+// 内部状态在多次校验之间复用，非线程安全，每个线程应使用独立的实例
+class SemanticVerifier {
+public:
+    template <typename BlueprintT>
+    VerifyResult Verify(const BlueprintT& bp, uint32_t N, uint32_t P,
+                        Collective collective = Collective::REDUCE_SCATTER);
+
+private:
+    struct Located {
+        uint32_t planeId;
+        uint32_t actionIdx;
+        Action action;
+    };
+
+    // 在不超过当前首个错误的位置上记录错误
+    void Report(VerifyError error, uint32_t phaseId, const Located& located, uint32_t rankId, uint32_t sliceId,
+                uint32_t contributorId);
+    bool Before(uint32_t phaseId, const Located& located) const;
+
+    void CheckAction(uint32_t phaseId, const Located& located, uint32_t N, uint32_t P);
+    void ResetState(uint32_t N);
+    size_t Key(uint32_t rankId, uint32_t sliceId, uint32_t chunkId) const
+    {
+        uint32_t diagonal = (rankId >= sliceId) ? rankId - sliceId : rankId + rankSize_ - sliceId;
+        return (static_cast<size_t>(chunkId) * rankSize_ + diagonal) * rankSize_ + rankId;
+    }
+    // 模拟一个phase（phaseActions_）中的收发
+    void RunPhase(uint32_t phaseId);
+    // all-gather / all-reduce中部分和包含全部N个贡献时记为COMPLETE
+    void SettleComplete(size_t key);
+    uint32_t FirstContributor(uint32_t slot, uint32_t rankId);
+    void CheckFinalState();
+    void CheckCompleteState();
+    std::string Describe() const;
+
+    // (rank, slice, chunk)的状态：SELF为只含自己的贡献，EMPTY为不持有，COMPLETE为包含全部N个贡献
+    // （只用于all-gather / all-reduce），其余为位集池中的编号
+    static constexpr uint32_t SELF = ~0u;
+    static constexpr uint32_t EMPTY = ~0u - 1;
+    static constexpr uint32_t COMPLETE = ~0u - 2;
+    // mark_ 的低两位：本phase是否收到/发出过该 (rank, slice, chunk)，其余位为phase标记
+    static constexpr uint32_t MARK_RECV = 1;
+    static constexpr uint32_t MARK_SEND = 2;
+
+    uint32_t AllocBits();
+    void FreeBits(uint32_t slot);
+    uint64_t* Bits(uint32_t slot) { return &pool_[static_cast<size_t>(slot) * words_]; }
+
+    VerifyResult result_;
+    Collective collective_{Collective::REDUCE_SCATTER};
+    uint16_t chunkNum_{1};
+
+    PairTable<uint8_t> pairs_;
+    std::vector<uint32_t> degree_;
+
+    uint32_t rankSize_{0};
+    size_t words_{0};
+    // 按 (chunk, (rank - slice) mod N, rank) 排列：环类算法同一phase内的访问是连续的
+    std::vector<uint32_t> state_;
+    std::vector<uint32_t> mark_;
+    std::vector<uint32_t> recvFrom_;  // all-reduce：本phase收到该 (rank, slice, chunk) 的发送方，用于识别交换
+    uint32_t stamp_{0};
+    std::vector<uint64_t> pool_;
+    std::vector<uint32_t> freeSlots_;
+
+    std::vector<Located> phaseActions_;
+    // 本phase待合并的部分和：srcSlot为发送方交出的位集，SELF时内容为 {srcRank}
+    struct Update {
+        size_t dstKey;
+        uint32_t dstRank;
+        uint32_t sliceId;
+        uint32_t srcRank;
+        uint32_t srcSlot;
+        size_t locatedIdx;
+    };
+    std::vector<Update> updates_;
+};
+
+template <typename BlueprintT>
+VerifyResult SemanticVerifier::Verify(const BlueprintT& bp, uint32_t N, uint32_t P, Collective collective)
+{
+    result_ = VerifyResult();
+    collective_ = collective;
+    pairs_.Reset(N);
+    degree_.assign(N, 0);
+    chunkNum_ = 0;
+
+    // 按 phase -> plane -> action 的顺序逐action检查合法性与度数，确定chunkNum
+    size_t phaseNum = 0;
+    for (const auto& schedule : bp) {
+        phaseNum = (schedule.size() > phaseNum) ? schedule.size() : phaseNum;
+    }
+    for (uint32_t phaseId = 0; phaseId < phaseNum && result_.ok; ++phaseId) {
+        for (uint32_t planeId = 0; planeId < bp.size(); ++planeId) {
+            if (phaseId >= bp[planeId].size()) {
+                continue;
+            }
+            const auto& phase = bp[planeId][phaseId];
+            for (size_t actionIdx = 0; actionIdx < phase.size(); ++actionIdx) {
+                Located located;
+                located.planeId = planeId;
+                located.actionIdx = static_cast<uint32_t>(actionIdx);
+                located.action = phase[actionIdx];
+                CheckAction(phaseId, located, N, P);
+            }
+        }
+    }
+    if (!result_.ok) {
+        result_.message = Describe();
+        return result_;
+    }
+    if (chunkNum_ == 0) {
+        chunkNum_ = 1;
+    }
+
+    // 不同chunk的状态互不相干，一次遍历中同时模拟
+    ResetState(N);
+    for (uint32_t phaseId = 0; phaseId < phaseNum; ++phaseId) {
+        if (!result_.ok) {
+            break;  // 之后phase的错误不会更靠前
+        }
+        phaseActions_.clear();
+        for (uint32_t planeId = 0; planeId < bp.size(); ++planeId) {
+            if (phaseId >= bp[planeId].size()) {
+                continue;
+            }
+            const auto& phase = bp[planeId][phaseId];
+            for (size_t actionIdx = 0; actionIdx < phase.size(); ++actionIdx) {
+                Located located;
+                located.action = phase[actionIdx];
+                if (located.action.srcRank == located.action.dstRank) {
+                    continue;
+                }
+                located.planeId = planeId;
+                located.actionIdx = static_cast<uint32_t>(actionIdx);
+                phaseActions_.push_back(located);
+            }
+        }
+        RunPhase(phaseId);
+    }
+    if (result_.ok) {
+        if (collective_ == Collective::REDUCE_SCATTER) {
+            CheckFinalState();
+        } else {
+            CheckCompleteState();
+        }
+    }
+    if (!result_.ok) {
+        result_.message = Describe();
+    }
+    return result_;
+}
+
+#endif // CPP_SEMANTIC_VERIFIER_H
@@ -0,0 +1,423 @@
+//
+// 向量化内核实现
+//
+
+#include "simd_kernels.h"
+#include <algorithm>
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_KERNELS_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_KERNELS_X86 0
+#endif
+
+using namespace std;
+
+// Action按5个32位字读取：src, dst, plane, slice, chunkId | chunkNum << 16
+static_assert(sizeof(Action) == 5 * sizeof(uint32_t), "Action的内存布局与向量内核的读取方式不一致");
+
+namespace {
+
+constexpr const uint32_t ACTION_WORDS = 5;
+constexpr const uint32_t CHUNK_WORD = 4;
+
+atomic<int>& ActiveLevelStorage()
+{
+    static atomic<int> level(static_cast<int>(DetectSimdLevel()));
+    return level;
+}
+
+// ---------------- 标量实现 ----------------
+
+inline uint16_t WrapAdd(uint32_t value, uint32_t offset, uint32_t rankSize)
+{
+    uint32_t sum = value + offset;
+    return static_cast<uint16_t>((sum >= rankSize) ? sum - rankSize : sum);
+}
+
+void FillAffineRingColumnsScalar(uint32_t begin, uint32_t rankSize, uint32_t dstOffset, uint32_t sliceOffset,
+                                 uint16_t* src, uint16_t* dst, uint16_t* slice)
+{
+    for (uint32_t rankId = begin; rankId < rankSize; ++rankId) {
+        src[rankId] = static_cast<uint16_t>(rankId);
+        dst[rankId] = WrapAdd(rankId, dstOffset, rankSize);
+        slice[rankId] = WrapAdd(rankId, sliceOffset, rankSize);
+    }
+}
+
+bool ComputePairKeysScalar(const Action* actions, size_t begin, size_t actionNum, uint32_t rankSize, uint32_t* keys)
+{
+    uint32_t sink = PairCountSink(rankSize);
+    for (size_t i = begin; i < actionNum; ++i) {
+        const Action& action = actions[i];
+        if (action.chunkNum != 1) {
+            return false;
+        }
+        keys[i] = (action.srcRank == action.dstRank) ? sink : action.srcRank * rankSize + action.dstRank;
+    }
+    return true;
+}
+
+void ComputeColumnKeysScalar(const uint16_t* src, const uint16_t* dst, size_t begin, size_t actionNum,
+                             uint32_t rankSize, uint32_t* keys)
+{
+    uint32_t sink = PairCountSink(rankSize);
+    for (size_t i = begin; i < actionNum; ++i) {
+        keys[i] = (src[i] == dst[i]) ? sink : src[i] * rankSize + dst[i];
+    }
+}
+
+void AccumulatePairCountsScalar(const uint32_t* keys, size_t begin, size_t keyNum, uint32_t* counts)
+{
+    for (size_t i = begin; i < keyNum; ++i) {
+        ++counts[keys[i]];
+    }
+}
+
+// 同一个键再次出现时计数已被清零，不影响最大值
+uint32_t TakeMaxPairCountScalar(const uint32_t* keys, size_t begin, size_t keyNum, uint32_t* counts)
+{
+    uint32_t maxCount = 0;
+    for (size_t i = begin; i < keyNum; ++i) {
+        uint32_t& count = counts[keys[i]];
+        maxCount = max(maxCount, count);
+        count = 0;
+    }
+    return maxCount;
+}
+
+#if SIMD_KERNELS_X86
+
+// ---------------- AVX2：16个16位lane / 8个32位lane，没有scatter，计数的写回为标量 ----------------
+
+__attribute__((target("avx2")))
+void FillAffineRingColumnsAvx2(uint32_t rankSize, uint32_t dstOffset, uint32_t sliceOffset, uint16_t* src,
+                               uint16_t* dst, uint16_t* slice)
+{
+    // i + offset >= N 时减去N：i >= N - offset 的lane取 i - (N - offset)，其余取 i + offset
+    const __m256i dstAdd = _mm256_set1_epi16(static_cast<short>(dstOffset));
+    const __m256i dstWrap = _mm256_set1_epi16(static_cast<short>(rankSize - dstOffset));
+    const __m256i sliceAdd = _mm256_set1_epi16(static_cast<short>(sliceOffset));
+    const __m256i sliceWrap = _mm256_set1_epi16(static_cast<short>(rankSize - sliceOffset));
+    const __m256i step = _mm256_set1_epi16(16);
+    __m256i rank = _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    uint32_t rankId = 0;
+    for (; rankId + 16 <= rankSize; rankId += 16) {
+        __m256i dstWrapped = _mm256_cmpeq_epi16(_mm256_max_epu16(rank, dstWrap), rank);
+        __m256i sliceWrapped = _mm256_cmpeq_epi16(_mm256_max_epu16(rank, sliceWrap), rank);
+        __m256i dstLane = _mm256_blendv_epi8(_mm256_add_epi16(rank, dstAdd), _mm256_sub_epi16(rank, dstWrap),
+                                             dstWrapped);
+        __m256i sliceLane = _mm256_blendv_epi8(_mm256_add_epi16(rank, sliceAdd),
+                                               _mm256_sub_epi16(rank, sliceWrap), sliceWrapped);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(src + rankId), rank);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + rankId), dstLane);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(slice + rankId), sliceLane);
+        rank = _mm256_add_epi16(rank, step);
+    }
+    FillAffineRingColumnsScalar(rankId, rankSize, dstOffset, sliceOffset, src, dst, slice);
+}
+
+__attribute__((target("avx2")))
+bool ComputePairKeysAvx2(const Action* actions, size_t actionNum, uint32_t rankSize, uint32_t* keys)
+{
+    const __m256i offsets = _mm256_setr_epi32(0, 5, 10, 15, 20, 25, 30, 35);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i size = _mm256_set1_epi32(static_cast<int>(rankSize));
+    const __m256i sink = _mm256_set1_epi32(static_cast<int>(PairCountSink(rankSize)));
+    size_t i = 0;
+    for (; i + 8 <= actionNum; i += 8) {
+        const int* base = reinterpret_cast<const int*>(actions + i);
+        __m256i src = _mm256_i32gather_epi32(base, offsets, 4);
+        __m256i dst = _mm256_i32gather_epi32(base + 1, offsets, 4);
+        __m256i chunkNum = _mm256_srli_epi32(_mm256_i32gather_epi32(base + CHUNK_WORD, offsets, 4), 16);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(chunkNum, one)) != -1) {
+            return false;
+        }
+        __m256i key = _mm256_add_epi32(_mm256_mullo_epi32(src, size), dst);
+        key = _mm256_blendv_epi8(key, sink, _mm256_cmpeq_epi32(src, dst));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(keys + i), key);
+    }
+    return ComputePairKeysScalar(actions, i, actionNum, rankSize, keys);
+}
+
+__attribute__((target("avx2")))
+void ComputeColumnKeysAvx2(const uint16_t* src, const uint16_t* dst, size_t actionNum, uint32_t rankSize,
+                           uint32_t* keys)
+{
+    const __m256i size = _mm256_set1_epi32(static_cast<int>(rankSize));
+    const __m256i sink = _mm256_set1_epi32(static_cast<int>(PairCountSink(rankSize)));
+    size_t i = 0;
+    for (; i + 8 <= actionNum; i += 8) {
+        __m256i srcLane = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        __m256i dstLane = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i)));
+        __m256i key = _mm256_add_epi32(_mm256_mullo_epi32(srcLane, size), dstLane);
+        key = _mm256_blendv_epi8(key, sink, _mm256_cmpeq_epi32(srcLane, dstLane));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(keys + i), key);
+    }
+    ComputeColumnKeysScalar(src, dst, i, actionNum, rankSize, keys);
+}
+
+__attribute__((target("avx2")))
+uint32_t TakeMaxPairCountAvx2(const uint32_t* keys, size_t keyNum, uint32_t* counts)
+{
+    __m256i maxLane = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= keyNum; i += 8) {
+        __m256i key = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        __m256i count = _mm256_i32gather_epi32(reinterpret_cast<const int*>(counts), key, 4);
+        maxLane = _mm256_max_epu32(maxLane, count);
+        for (size_t j = i; j < i + 8; ++j) {
+            counts[keys[j]] = 0;
+        }
+    }
+    alignas(32) uint32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), maxLane);
+    uint32_t maxCount = *max_element(lanes, lanes + 8);
+    return max(maxCount, TakeMaxPairCountScalar(keys, i, keyNum, counts));
+}
+
+// ---------------- AVX-512：32个16位lane / 16个32位lane，尾部用掩码处理 ----------------
+
+__attribute__((target("avx512f,avx512bw")))
+void FillAffineRingColumnsAvx512(uint32_t rankSize, uint32_t dstOffset, uint32_t sliceOffset, uint16_t* src,
+                                 uint16_t* dst, uint16_t* slice)
+{
+    static const uint16_t RANK_LANES[32] = {0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15,
+                                            16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31};
+    const __m512i dstAdd = _mm512_set1_epi16(static_cast<short>(dstOffset));
+    const __m512i dstWrap = _mm512_set1_epi16(static_cast<short>(rankSize - dstOffset));
+    const __m512i sliceAdd = _mm512_set1_epi16(static_cast<short>(sliceOffset));
+    const __m512i sliceWrap = _mm512_set1_epi16(static_cast<short>(rankSize - sliceOffset));
+    const __m512i step = _mm512_set1_epi16(32);
+    __m512i rank = _mm512_loadu_si512(RANK_LANES);
+    for (uint32_t rankId = 0; rankId < rankSize; rankId += 32) {
+        uint32_t laneNum = min(rankSize - rankId, 32u);
+        __mmask32 lanes = (laneNum == 32) ? ~__mmask32(0) : (__mmask32(1) << laneNum) - 1;
+        __m512i dstLane = _mm512_mask_blend_epi16(_mm512_cmpge_epu16_mask(rank, dstWrap),
+                                                  _mm512_add_epi16(rank, dstAdd), _mm512_sub_epi16(rank, dstWrap));
+        __m512i sliceLane = _mm512_mask_blend_epi16(_mm512_cmpge_epu16_mask(rank, sliceWrap),
+                                                    _mm512_add_epi16(rank, sliceAdd),
+                                                    _mm512_sub_epi16(rank, sliceWrap));
+        _mm512_mask_storeu_epi16(src + rankId, lanes, rank);
+        _mm512_mask_storeu_epi16(dst + rankId, lanes, dstLane);
+        _mm512_mask_storeu_epi16(slice + rankId, lanes, sliceLane);
+        rank = _mm512_add_epi16(rank, step);
+    }
+}
+
+__attribute__((target("avx512f")))
+bool ComputePairKeysAvx512(const Action* actions, size_t actionNum, uint32_t rankSize, uint32_t* keys)
+{
+    const __m512i offsets = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+                                               _mm512_set1_epi32(ACTION_WORDS));
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i size = _mm512_set1_epi32(static_cast<int>(rankSize));
+    const __m512i sink = _mm512_set1_epi32(static_cast<int>(PairCountSink(rankSize)));
+    for (size_t i = 0; i < actionNum; i += 16) {
+        size_t laneNum = min<size_t>(actionNum - i, 16);
+        __mmask16 lanes = (laneNum == 16) ? __mmask16(0xFFFF) : static_cast<__mmask16>((1u << laneNum) - 1);
+        const int* base = reinterpret_cast<const int*>(actions + i);
+        // 掩码外的lane不访问内存，chunkNum取1
+        __m512i src = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), lanes, offsets, base, 4);
+        __m512i dst = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), lanes, offsets, base + 1, 4);
+        __m512i chunkWord = _mm512_mask_i32gather_epi32(_mm512_set1_epi32(1 << 16), lanes, offsets,
+                                                        base + CHUNK_WORD, 4);
+        if (_mm512_cmpneq_epi32_mask(_mm512_srli_epi32(chunkWord, 16), one) != 0) {
+            return false;
+        }
+        __m512i key = _mm512_add_epi32(_mm512_mullo_epi32(src, size), dst);
+        key = _mm512_mask_blend_epi32(_mm512_cmpeq_epi32_mask(src, dst), key, sink);
+        _mm512_mask_storeu_epi32(keys + i, lanes, key);
+    }
+    return true;
+}
+
+__attribute__((target("avx512f")))
+void ComputeColumnKeysAvx512(const uint16_t* src, const uint16_t* dst, size_t actionNum, uint32_t rankSize,
+                             uint32_t* keys)
+{
+    const __m512i size = _mm512_set1_epi32(static_cast<int>(rankSize));
+    const __m512i sink = _mm512_set1_epi32(static_cast<int>(PairCountSink(rankSize)));
+    size_t i = 0;
+    for (; i + 16 <= actionNum; i += 16) {
+        __m512i srcLane = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+        __m512i dstLane = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i)));
+        __m512i key = _mm512_add_epi32(_mm512_mullo_epi32(srcLane, size), dstLane);
+        key = _mm512_mask_blend_epi32(_mm512_cmpeq_epi32_mask(srcLane, dstLane), key, sink);
+        _mm512_storeu_si512(keys + i, key);
+    }
+    ComputeColumnKeysScalar(src, dst, i, actionNum, rankSize, keys);
+}
+
+// 16个键互不相同时整组gather / +1 / scatter；组内有重复键（vpconflictd非0）时该组按标量累加
+__attribute__((target("avx512f,avx512cd")))
+void AccumulatePairCountsAvx512(const uint32_t* keys, size_t keyNum, uint32_t* counts)
+{
+    const __m512i one = _mm512_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 16 <= keyNum; i += 16) {
+        __m512i key = _mm512_loadu_si512(keys + i);
+        __m512i conflict = _mm512_conflict_epi32(key);
+        if (_mm512_test_epi32_mask(conflict, conflict) != 0) {
+            AccumulatePairCountsScalar(keys, i, i + 16, counts);
+            continue;
+        }
+        __m512i count = _mm512_i32gather_epi32(key, counts, 4);
+        _mm512_i32scatter_epi32(counts, key, _mm512_add_epi32(count, one), 4);
+    }
+    AccumulatePairCountsScalar(keys, i, keyNum, counts);
+}
+
+// 组内重复的键gather到同一个值，随后一起清零
+__attribute__((target("avx512f")))
+uint32_t TakeMaxPairCountAvx512(const uint32_t* keys, size_t keyNum, uint32_t* counts)
+{
+    __m512i maxLane = _mm512_setzero_si512();
+    const __m512i zero = _mm512_setzero_si512();
+    for (size_t i = 0; i < keyNum; i += 16) {
+        size_t laneNum = min<size_t>(keyNum - i, 16);
+        __mmask16 lanes = (laneNum == 16) ? __mmask16(0xFFFF) : static_cast<__mmask16>((1u << laneNum) - 1);
+        __m512i key = _mm512_maskz_loadu_epi32(lanes, keys + i);
+        __m512i count = _mm512_mask_i32gather_epi32(zero, lanes, key, counts, 4);
+        maxLane = _mm512_max_epu32(maxLane, count);
+        _mm512_mask_i32scatter_epi32(counts, lanes, key, zero, 4);
+    }
+    return _mm512_reduce_max_epu32(maxLane);
+}
+
+#endif // SIMD_KERNELS_X86
+
+} // namespace
+
+const char* SimdLevelName(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::SCALAR:
+            return "scalar";
+        case SimdLevel::AVX2:
+            return "avx2";
+        case SimdLevel::AVX512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+bool ParseSimdLevel(const string& name, SimdLevel& level)
+{
+    if (name == "scalar") {
+        level = SimdLevel::SCALAR;
+    } else if (name == "avx2") {
+        level = SimdLevel::AVX2;
+    } else if (name == "avx512") {
+        level = SimdLevel::AVX512;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+SimdLevel DetectSimdLevel()
+{
+#if SIMD_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd") &&
+        __builtin_cpu_supports("avx512bw")) {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+#endif
+    return SimdLevel::SCALAR;
+}
+
+SimdLevel ActiveSimdLevel()
+{
+    return static_cast<SimdLevel>(ActiveLevelStorage().load(memory_order_relaxed));
+}
+
+SimdLevel SetSimdLevel(SimdLevel level)
+{
+    SimdLevel effective = min(level, DetectSimdLevel());
+    ActiveLevelStorage().store(static_cast<int>(effective), memory_order_relaxed);
+    return effective;
+}
+
+void FillAffineRingColumns(uint32_t rankSize, uint32_t dstOffset, uint32_t sliceOffset, uint16_t* src,
+                           uint16_t* dst, uint16_t* slice)
+{
+#if SIMD_KERNELS_X86
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::AVX512:
+            FillAffineRingColumnsAvx512(rankSize, dstOffset, sliceOffset, src, dst, slice);
+            return;
+        case SimdLevel::AVX2:
+            FillAffineRingColumnsAvx2(rankSize, dstOffset, sliceOffset, src, dst, slice);
+            return;
+        default:
+            break;
+    }
+#endif
+    FillAffineRingColumnsScalar(0, rankSize, dstOffset, sliceOffset, src, dst, slice);
+}
+
+bool ComputePairKeys(const Action* actions, size_t actionNum, uint32_t rankSize, uint32_t* keys)
+{
+#if SIMD_KERNELS_X86
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::AVX512:
+            return ComputePairKeysAvx512(actions, actionNum, rankSize, keys);
+        case SimdLevel::AVX2:
+            return ComputePairKeysAvx2(actions, actionNum, rankSize, keys);
+        default:
+            break;
+    }
+#endif
+    return ComputePairKeysScalar(actions, 0, actionNum, rankSize, keys);
+}
+
+void ComputePairKeys(const uint16_t* src, const uint16_t* dst, size_t actionNum, uint32_t rankSize, uint32_t* keys)
+{
+#if SIMD_KERNELS_X86
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::AVX512:
+            ComputeColumnKeysAvx512(src, dst, actionNum, rankSize, keys);
+            return;
+        case SimdLevel::AVX2:
+            ComputeColumnKeysAvx2(src, dst, actionNum, rankSize, keys);
+            return;
+        default:
+            break;
+    }
+#endif
+    ComputeColumnKeysScalar(src, dst, 0, actionNum, rankSize, keys);
+}
+
+void AccumulatePairCounts(const uint32_t* keys, size_t keyNum, uint32_t* counts)
+{
+#if SIMD_KERNELS_X86
+    if (ActiveSimdLevel() == SimdLevel::AVX512) {
+        AccumulatePairCountsAvx512(keys, keyNum, counts);
+        return;
+    }
+#endif
+    AccumulatePairCountsScalar(keys, 0, keyNum, counts);
+}
+
+uint32_t TakeMaxPairCount(const uint32_t* keys, size_t keyNum, uint32_t rankSize, uint32_t* counts)
+{
+    counts[PairCountSink(rankSize)] = 0;
+#if SIMD_KERNELS_X86
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::AVX512:
+            return TakeMaxPairCountAvx512(keys, keyNum, counts);
+        case SimdLevel::AVX2:
+            return TakeMaxPairCountAvx2(keys, keyNum, counts);
+        default:
+            break;
+    }
+#endif
+    return TakeMaxPairCountScalar(keys, 0, keyNum, counts);
+}
@@ -0,0 +1,52 @@
+//
+// 生成与评分中规则整数流的向量化内核：ring类phase的列填充、有序对计数。
+// 各内核有标量、AVX2与AVX-512三种实现，按运行时检测到的CPU能力选择，结果与标量实现完全相同。
+// 向量实现以函数级target属性编译，不要求以-mavx2等全局选项编译；非x86或非GCC/Clang时只有标量实现。
+//
+
+#ifndef CPP_SIMD_KERNELS_H
+#define CPP_SIMD_KERNELS_H
+
+#include "solution.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class SimdLevel {
+    SCALAR,
+    AVX2,
+    AVX512  // AVX-512 F/CD/BW
+};
+
+const char* SimdLevelName(SimdLevel level);
+bool ParseSimdLevel(const std::string& name, SimdLevel& level);
+
+// 当前CPU支持的最高级别
+SimdLevel DetectSimdLevel();
+// 内核实际使用的级别，默认为DetectSimdLevel()
+SimdLevel ActiveSimdLevel();
+// 限制内核使用的级别（用于对比测试），超过CPU能力时取CPU能力；返回实际生效的级别
+SimdLevel SetSimdLevel(SimdLevel level);
+
+// ring类phase：rank i 向 (i + dstOffset) % N 发送slice (i + sliceOffset) % N，要求两个偏移均小于N、N < 65535。
+// 写入 src[i] = i, dst[i], slice[i]，i ∈ [0, N)
+void FillAffineRingColumns(uint32_t rankSize, uint32_t dstOffset, uint32_t sliceOffset, uint16_t* src,
+                           uint16_t* dst, uint16_t* slice);
+
+// 有序对 (src, dst) 在稠密计数表中的键 src * N + dst；src == dst 的action不计入冲突，映射到 PairCountSink(N)
+inline uint32_t PairCountSink(uint32_t rankSize)
+{
+    return rankSize * rankSize;
+}
+
+// keys[i] 为 actions[i] 的键；任一action切块（chunkNum != 1）时返回false，此时keys的内容无意义
+bool ComputePairKeys(const Action* actions, size_t actionNum, uint32_t rankSize, uint32_t* keys);
+// 紧凑存储的列，同上（紧凑存储中rank不超过16位）
+void ComputePairKeys(const uint16_t* src, const uint16_t* dst, size_t actionNum, uint32_t rankSize, uint32_t* keys);
+
+// 对每个键 ++counts[keys[i]]；counts至少有 PairCountSink(N) + 1 项
+void AccumulatePairCounts(const uint32_t* keys, size_t keyNum, uint32_t* counts);
+// 返回keys中各键（PairCountSink除外）计数的最大值，并把这些计数与sink清零，之后counts恢复为全0
+uint32_t TakeMaxPairCount(const uint32_t* keys, size_t keyNum, uint32_t rankSize, uint32_t* counts);
+
+#endif // CPP_SIMD_KERNELS_H
@@ -3,8 +3,18 @@
 //
 
 #include "solution.h"
+#include "flat_blueprint.h"
+#include "compact_blueprint.h"
+#include "lazy_blueprint.h"
+#include "schedule_generators.h"
+#include "instrumentation.h"
+#include "schedule_tuner.h"
+#include "simd_kernels.h"
 #include <vector>
 #include <cstdint>
+#include <atomic>
+#include <limits>
+#include <thread>
 
 using namespace std;
 
@@ -12,86 +22,487 @@ namespace SolutionUtils {
 
 constexpr const uint32_t META_PLANE_NUM = 2;
 
-enum class RingOrder {
-    CLOCKWISE,
-    COUNTER_CLOCKWISE
-};
-
-RingOrder CalcRingOrder(uint32_t planeId)
-{
-    return (planeId % 2 == 0) ? RingOrder::CLOCKWISE : RingOrder::COUNTER_CLOCKWISE;
-}
-
-Action ConstructAction(uint32_t rankSize, uint32_t rankId, uint32_t phaseId, RingOrder ringOrder)
-{
-    Action action;
-    action.planeId = DEFAULT_PLANE_ID;  // 会被外层覆盖
-    action.sliceId = INVALID_SLICE_ID;  // 会被外层覆盖
-    
-    if (ringOrder == RingOrder::CLOCKWISE) {
-        action.srcRank = rankId;
-        action.dstRank = (rankId + 1) % rankSize;
-    } else {
-        action.srcRank = rankId;
-        action.dstRank = (rankId - 1 + rankSize) % rankSize;
-    }
-    
-    return action;
-}
-
-Phase ConstructPhase(uint32_t rankSize, uint32_t phaseId, uint32_t planeId)
+template <typename RankSizeT>
+Phase ConstructPhase(const RankSizeT& rankSize, uint32_t phaseId, uint32_t planeId)
 {
     Phase phase;
-    RingOrder order = CalcRingOrder(planeId);
+    phase.reserve(rankSize.Value());
     
-    for (uint32_t rankId = 0; rankId < rankSize; ++rankId) {
-        Action action = ConstructAction(rankSize, rankId, phaseId, order);
-        action.planeId = planeId;
-        
-        // 修正sliceId的计算逻辑
-        // 在ring算法中，每个rank在phaseId阶段发送特定的slice
-        if (order == RingOrder::CLOCKWISE) {
-            // 顺时针：rank i 在phase p发送 slice (i - p - 1 + N) % N
-            action.sliceId = (rankId - phaseId - 1 + rankSize) % rankSize;
-        } else {
-            // 逆时针：rank i 在phase p发送 slice (i + p + 1) % N
-            action.sliceId = (rankId + phaseId + 1) % rankSize;
-        }
-        
-        phase.push_back(action);
+    for (uint32_t rankId = 0; rankId < rankSize.Value(); ++rankId) {
+        phase.push_back(MakeRingAction(rankSize, rankId, phaseId, planeId));
     }
     
     return phase;
 }
 
-Schedule ConstructSchedule(uint32_t rankSize, uint32_t planeId)
+template <typename RankSizeT>
+Schedule ConstructSchedule(const RankSizeT& rankSize, uint32_t planeId)
 {
     Schedule schedule;
     
     // ring算法需要rankSize-1个phase（当rankSize>1时）
-    if (rankSize <= 1) {
+    if (rankSize.Value() <= 1) {
         return schedule;  // 不需要通信
     }
     
-    for (uint32_t phaseId = 0; phaseId < rankSize - 1; ++phaseId) {
-        Phase phase = ConstructPhase(rankSize, phaseId, planeId);
-        schedule.push_back(phase);
+    schedule.reserve(rankSize.Value() - 1);
+    for (uint32_t phaseId = 0; phaseId < rankSize.Value() - 1; ++phaseId) {
+        schedule.push_back(ConstructPhase(rankSize, phaseId, planeId));
     }
     
     return schedule;
 }
 
+// 串行构造三层vector的ring Blueprint，rank数经DispatchRankSize特化
+struct RingBlueprintBuilder {
+    uint32_t planeNum;
+    Blueprint& blueprint;
+
+    template <typename RankSizeT>
+    void operator()(const RankSizeT& rankSize)
+    {
+        blueprint.reserve(planeNum);
+        // 对于每个plane（通信层），构造一个schedule
+        for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
+            blueprint.push_back(ConstructSchedule(rankSize, planeId));
+        }
+    }
+};
+
+// 三层vector的Blueprint构造适配器，预分配式构造接口与FlatBlueprint一致
+class NestedBlueprintBuilder {
+public:
+    explicit NestedBlueprintBuilder(Blueprint& blueprint) : blueprint_(blueprint) {}
+
+    void Allocate(size_t planeNum, size_t phaseNum, const vector<size_t>& actionNums, bool)
+    {
+        blueprint_.assign(planeNum, Schedule(phaseNum));
+        for (size_t planeId = 0; planeId < planeNum; ++planeId) {
+            for (size_t phaseId = 0; phaseId < phaseNum; ++phaseId) {
+                blueprint_[planeId][phaseId].resize(actionNums[planeId * phaseNum + phaseId]);
+            }
+        }
+    }
+    void SetAction(size_t planeId, size_t phaseId, size_t actionId, const Action& action)
+    {
+        blueprint_[planeId][phaseId][actionId] = action;
+    }
+    size_t MemoryBytes() const
+    {
+        size_t bytes = blueprint_.capacity() * sizeof(Schedule);
+        for (const auto& schedule : blueprint_) {
+            bytes += schedule.capacity() * sizeof(Phase);
+            for (const auto& phase : schedule) {
+                bytes += phase.capacity() * sizeof(Action);
+            }
+        }
+        return bytes;
+    }
+
+private:
+    Blueprint& blueprint_;
+};
+
+// 生成一个(plane, phase)单元，返回写入的action数
+template <typename GeneratorT, typename BlueprintT>
+size_t FillCell(const GeneratorT& generator, uint32_t planeId, uint32_t phaseId, BlueprintT& blueprint)
+{
+    size_t actionId = 0;
+    auto emit = [&](const Action& action) { blueprint.SetAction(planeId, phaseId, actionId++, action); };
+    EmitPhase(generator, planeId, phaseId, emit);
+    return actionId;
+}
+
+// ring类phase写入紧凑存储时按列整块填充（见 simd_kernels.h）；扁平存储逐个写入20字节的Action，不按此处理
+size_t FillAffineCell(const AffinePhase& phase, uint32_t rankSize, uint32_t planeId, uint32_t phaseId,
+                      CompactBlueprint& blueprint)
+{
+    CompactPhaseColumns columns = blueprint.MutablePhaseColumns(planeId, phaseId);
+    FillAffineRingColumns(rankSize, phase.dstOffset, phase.sliceOffset, columns.src, columns.dst, columns.slice);
+    return columns.size;
+}
+
+template <typename RankSizeT>
+size_t FillCell(const BasicRingGenerator<RankSizeT>& generator, uint32_t planeId, uint32_t phaseId,
+                CompactBlueprint& blueprint)
+{
+    return FillAffineCell(generator.Affine(planeId, phaseId), generator.RankSize(), planeId, phaseId, blueprint);
+}
+
+// 先按ActionNum预分配全部存储，再由threadNum个线程领取(plane, phase)单元直接写入各自的位置；
+// 单元之间不重叠，无需加锁，结果与线程数无关。threadNum为1时不创建线程
+template <typename GeneratorT, typename BlueprintT>
+void FillCells(const GeneratorT& generator, uint32_t planeNum, uint32_t threadNum, BlueprintT& blueprint)
+{
+    uint32_t phaseNum = generator.PhaseNum();
+    INSTRUMENT_SCOPE("FillCells");
+    size_t cellNum = static_cast<size_t>(planeNum) * phaseNum;
+    vector<size_t> actionNums(cellNum);
+    for (size_t cell = 0; cell < cellNum; ++cell) {
+        actionNums[cell] = generator.ActionNum(static_cast<uint32_t>(cell / phaseNum),
+                                               static_cast<uint32_t>(cell % phaseNum));
+    }
+    {
+        INSTRUMENT_SCOPE("Allocate");
+#if INSTRUMENTATION_ENABLED
+        size_t bytesBefore = blueprint.MemoryBytes();
+#endif
+        blueprint.Allocate(planeNum, phaseNum, actionNums, generator.Chunked());
+#if INSTRUMENTATION_ENABLED
+        size_t bytesAfter = blueprint.MemoryBytes();
+        INSTRUMENT_COUNT(BYTES_ALLOCATED, (bytesAfter > bytesBefore) ? bytesAfter - bytesBefore : 0);
+#endif
+    }
+
+    atomic<size_t> nextCell(0);
+    auto worker = [&]() {
+        INSTRUMENT_SCOPE("EmitCells");
+        size_t cellsBuilt = 0;
+        size_t actionsEmitted = 0;
+        for (;;) {
+            size_t cell = nextCell.fetch_add(1, memory_order_relaxed);
+            if (cell >= cellNum) {
+                break;
+            }
+            uint32_t planeId = static_cast<uint32_t>(cell / phaseNum);
+            uint32_t phaseId = static_cast<uint32_t>(cell % phaseNum);
+            actionsEmitted += FillCell(generator, planeId, phaseId, blueprint);
+            ++cellsBuilt;
+        }
+        // 每个线程结束时累加一次，不在单元循环内计数
+        INSTRUMENT_COUNT(PHASES_BUILT, cellsBuilt);
+        INSTRUMENT_COUNT(ACTIONS_EMITTED, actionsEmitted);
+    };
+
+    vector<thread> threads;
+    for (uint32_t threadId = 1; threadId < threadNum; ++threadId) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+// action数太少时线程启动开销大于收益，直接串行生成
+constexpr const size_t PARALLEL_MIN_ACTION_NUM = 1 << 16;
+
+uint32_t ResolveThreadNum(uint32_t threadNum)
+{
+    if (threadNum == 0) {
+        threadNum = thread::hardware_concurrency();
+    }
+    return (threadNum == 0) ? 1 : threadNum;
+}
+
+template <typename GeneratorT, typename BlueprintT>
+void FillWithGenerator(const GeneratorT& generator, uint32_t planeNum, const ScheduleOptions& options,
+                       BlueprintT& blueprint)
+{
+    uint32_t threadNum = ResolveThreadNum(options.threadNum);
+    size_t roughActionNum = static_cast<size_t>(planeNum) * generator.PhaseNum() * generator.RankSize();
+    if (roughActionNum < PARALLEL_MIN_ACTION_NUM) {
+        threadNum = 1;
+    }
+    FillCells(generator, planeNum, threadNum, blueprint);
+}
+
+// all-gather / all-reduce由reduce-scatter的生成器变换得到（见 schedule_generators.h）
+template <typename GeneratorT, typename BlueprintT>
+void FillCollective(const GeneratorT& generator, Collective collective, uint32_t planeNum,
+                    const ScheduleOptions& options, BlueprintT& blueprint)
+{
+    switch (collective) {
+        case Collective::ALL_GATHER:
+            FillWithGenerator(AllGatherGenerator<GeneratorT>(generator), planeNum, options, blueprint);
+            return;
+        case Collective::ALL_REDUCE:
+            FillWithGenerator(AllReduceGenerator<GeneratorT>(generator), planeNum, options, blueprint);
+            return;
+        default:
+            FillWithGenerator(generator, planeNum, options, blueprint);
+            return;
+    }
+}
+
+// ring类算法（RING / MULTI_RING / CHUNKED_RING）的生成器按DispatchRankSize给出的rank数策略实例化。
+// 编译期rank数只用于reduce-scatter：all-gather / all-reduce只用于三层vector，为控制实例化数量只用运行期rank数
+template <typename BlueprintT>
+struct RingFamilyFiller {
+    uint32_t planeNum;
+    ScheduleAlgorithm algorithm;
+    const ScheduleOptions& options;
+    Collective collective;
+    BlueprintT& blueprint;
+
+    template <typename RankSizeT>
+    void operator()(const RankSizeT& rankSize)
+    {
+        uint32_t n = rankSize.Value();
+        switch (algorithm) {
+            case ScheduleAlgorithm::MULTI_RING:
+            case ScheduleAlgorithm::CHUNKED_RING:
+                Fill(BasicChunkedRingGenerator<RankSizeT>(n, planeNum, CalcPipelineDepth(algorithm, options),
+                                                          options.ringNum, options.planeWeights),
+                     rankSize);
+                return;
+            default:
+                Fill(BasicRingGenerator<RankSizeT>(n), rankSize);
+                return;
+        }
+    }
+
+    template <typename GeneratorT>
+    void Fill(const GeneratorT& generator, const DynamicRankSize&)
+    {
+        FillCollective(generator, collective, planeNum, options, blueprint);
+    }
+    template <typename GeneratorT, uint32_t N>
+    void Fill(const GeneratorT& generator, const FixedRankSize<N>&)
+    {
+        FillWithGenerator(generator, planeNum, options, blueprint);
+    }
+};
+
+template <typename BlueprintT>
+void FillBlueprint(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm, const ScheduleOptions& options,
+                   BlueprintT& blueprint, Collective collective = Collective::REDUCE_SCATTER)
+{
+    algorithm = ResolveFeasibleAlgorithm(rankSize, planeNum, algorithm, options);
+    switch (algorithm) {
+        case ScheduleAlgorithm::HALVING:
+            FillCollective(HalvingGenerator(rankSize, planeNum), collective, planeNum, options, blueprint);
+            return;
+        case ScheduleAlgorithm::HIERARCHICAL:
+            FillCollective(HierarchicalGenerator(rankSize, planeNum, options.ranksPerNode), collective, planeNum,
+                           options, blueprint);
+            return;
+        default: {
+            RingFamilyFiller<BlueprintT> filler{planeNum, algorithm, options, collective, blueprint};
+            if (collective == Collective::REDUCE_SCATTER) {
+                DispatchRankSize(rankSize, filler);
+            } else {
+                filler(DynamicRankSize(rankSize));
+            }
+            return;
+        }
+    }
+}
+
 } // namespace SolutionUtils
 
+const char* ScheduleAlgorithmName(ScheduleAlgorithm algorithm)
+{
+    switch (algorithm) {
+        case ScheduleAlgorithm::AUTO:
+            return "auto";
+        case ScheduleAlgorithm::RING:
+            return "ring";
+        case ScheduleAlgorithm::HALVING:
+            return "halving";
+        case ScheduleAlgorithm::MULTI_RING:
+            return "multiring";
+        case ScheduleAlgorithm::CHUNKED_RING:
+            return "chunkedring";
+        case ScheduleAlgorithm::HIERARCHICAL:
+            return "hierarchical";
+    }
+    return "unknown";
+}
+
+bool ParseScheduleAlgorithm(const string& name, ScheduleAlgorithm& algorithm)
+{
+    if (name == "auto") {
+        algorithm = ScheduleAlgorithm::AUTO;
+    } else if (name == "ring") {
+        algorithm = ScheduleAlgorithm::RING;
+    } else if (name == "halving") {
+        algorithm = ScheduleAlgorithm::HALVING;
+    } else if (name == "multiring") {
+        algorithm = ScheduleAlgorithm::MULTI_RING;
+    } else if (name == "chunkedring") {
+        algorithm = ScheduleAlgorithm::CHUNKED_RING;
+    } else if (name == "hierarchical") {
+        algorithm = ScheduleAlgorithm::HIERARCHICAL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* CollectiveName(Collective collective)
+{
+    switch (collective) {
+        case Collective::REDUCE_SCATTER:
+            return "reducescatter";
+        case Collective::ALL_GATHER:
+            return "allgather";
+        case Collective::ALL_REDUCE:
+            return "allreduce";
+    }
+    return "unknown";
+}
+
+bool ParseCollective(const string& name, Collective& collective)
+{
+    if (name == "reducescatter") {
+        collective = Collective::REDUCE_SCATTER;
+    } else if (name == "allgather") {
+        collective = Collective::ALL_GATHER;
+    } else if (name == "allreduce") {
+        collective = Collective::ALL_REDUCE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+ScheduleAlgorithm Solution::SelectAlgorithm(uint32_t rankSize, uint32_t planeNum) const
+{
+    // MULTI_RING即流水深度为1的CHUNKED_RING（见 SolutionUtils::CalcPipelineDepth），不单独作为候选
+    static const ScheduleAlgorithm CANDIDATES[] = {
+        ScheduleAlgorithm::RING, ScheduleAlgorithm::HALVING, ScheduleAlgorithm::CHUNKED_RING,
+        ScheduleAlgorithm::HIERARCHICAL
+    };
+
+    ScheduleAlgorithm best = ScheduleAlgorithm::RING;
+    double bestTime = numeric_limits<double>::infinity();
+    for (ScheduleAlgorithm candidate : CANDIDATES) {
+        double time = EstimateTime(rankSize, planeNum, candidate);
+        if (time < bestTime) {
+            bestTime = time;
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+double Solution::EstimateTime(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm) const
+{
+    if (algorithm == ScheduleAlgorithm::AUTO) {
+        algorithm = SelectAlgorithm(rankSize, planeNum);
+    }
+    ScheduleOptions options = options_;
+    SolutionUtils::ApplyPlaneWeights(costModel_, planeNum, options);
+    SolutionUtils::ApplyNodeTopology(costModel_, options);
+    SolutionUtils::ScheduleEstimate estimate = SolutionUtils::EstimateSchedule(rankSize, planeNum, algorithm, options);
+    return SolutionUtils::EstimateCommunicationTime(costModel_, rankSize, planeNum, algorithm, options, estimate);
+}
+
+ScheduleAlgorithm Solution::ResolveSchedule(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm,
+                                            ScheduleOptions& options) const
+{
+    INSTRUMENT_SCOPE("ResolveSchedule");
+    options = options_;
+    SolutionUtils::ApplyPlaneWeights(costModel_, planeNum, options);
+    SolutionUtils::ApplyNodeTopology(costModel_, options);
+    if (algorithm != ScheduleAlgorithm::AUTO) {
+        return algorithm;
+    }
+    TunedSchedule tuned;
+    if (tuningTable_ && !costModel_.Heterogeneous() && !costModel_.MultiNode() &&
+        tuningTable_->Find(rankSize, planeNum, tuned)) {
+        tuned.ApplyTo(options);
+        return tuned.algorithm;
+    }
+    return SelectAlgorithm(rankSize, planeNum);
+}
+
 Blueprint Solution::ConstructBluePrint(uint32_t rankSize, uint32_t planeNum)
 {
-    Blueprint blueprint;
-    
-    // 对于每个plane（通信层），构造一个schedule
-    for (uint32_t planeId = 0; planeId < planeNum; ++planeId) {
-        Schedule schedule = SolutionUtils::ConstructSchedule(rankSize, planeId);
-        blueprint.push_back(schedule);
+    return ConstructBluePrint(rankSize, planeNum, ScheduleAlgorithm::AUTO);
+}
+
+Blueprint Solution::ConstructBluePrint(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm)
+{
+    INSTRUMENT_SCOPE("ConstructBluePrint");
+    ScheduleOptions options;
+    algorithm = ResolveSchedule(rankSize, planeNum, algorithm, options);
+    if (algorithm != ScheduleAlgorithm::RING || SolutionUtils::ResolveThreadNum(options.threadNum) > 1) {
+        Blueprint blueprint;
+        SolutionUtils::NestedBlueprintBuilder builder(blueprint);
+        SolutionUtils::FillBlueprint(rankSize, planeNum, algorithm, options, builder);
+        return blueprint;
     }
+
+    Blueprint blueprint;
+    SolutionUtils::RingBlueprintBuilder ringBuilder{planeNum, blueprint};
+    SolutionUtils::DispatchRankSize(rankSize, ringBuilder);
+#if INSTRUMENTATION_ENABLED
+    size_t phaseNum = (rankSize > 1) ? rankSize - 1 : 0;
+    SolutionUtils::NestedBlueprintBuilder builder(blueprint);
+    INSTRUMENT_COUNT(PHASES_BUILT, planeNum * phaseNum);
+    INSTRUMENT_COUNT(ACTIONS_EMITTED, planeNum * phaseNum * rankSize);
+    INSTRUMENT_COUNT(BYTES_ALLOCATED, builder.MemoryBytes());
+#endif
     
     return blueprint;
-}
\ No newline at end of file
+}
+
+Blueprint Solution::ConstructBluePrint(uint32_t rankSize, const vector<PlaneProfile>& planes,
+                                       ScheduleAlgorithm algorithm)
+{
+    // 在副本上构造，本对象的代价模型保持不变
+    Solution solution(*this);
+    CostModel costModel = costModel_;
+    costModel.planes = planes;
+    solution.SetCostModel(costModel);
+    return solution.ConstructBluePrint(rankSize, static_cast<uint32_t>(planes.size()), algorithm);
+}
+
+Blueprint Solution::ConstructAllGatherBluePrint(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm)
+{
+    INSTRUMENT_SCOPE("ConstructAllGatherBluePrint");
+    ScheduleOptions options;
+    algorithm = ResolveSchedule(rankSize, planeNum, algorithm, options);
+    Blueprint blueprint;
+    SolutionUtils::NestedBlueprintBuilder builder(blueprint);
+    SolutionUtils::FillBlueprint(rankSize, planeNum, algorithm, options, builder, Collective::ALL_GATHER);
+    return blueprint;
+}
+
+Blueprint Solution::ConstructAllReduceBluePrint(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm)
+{
+    INSTRUMENT_SCOPE("ConstructAllReduceBluePrint");
+    ScheduleOptions options;
+    algorithm = ResolveSchedule(rankSize, planeNum, algorithm, options);
+    Blueprint blueprint;
+    SolutionUtils::NestedBlueprintBuilder builder(blueprint);
+    SolutionUtils::FillBlueprint(rankSize, planeNum, algorithm, options, builder, Collective::ALL_REDUCE);
+    return blueprint;
+}
+
+void Solution::ConstructBluePrint(uint32_t rankSize, uint32_t planeNum, FlatBlueprint& blueprint,
+                                  ScheduleAlgorithm algorithm)
+{
+    INSTRUMENT_SCOPE("ConstructBluePrint");
+    ScheduleOptions options;
+    algorithm = ResolveSchedule(rankSize, planeNum, algorithm, options);
+    SolutionUtils::FillBlueprint(rankSize, planeNum, algorithm, options, blueprint);
+}
+
+bool Solution::ConstructBluePrint(uint32_t rankSize, uint32_t planeNum, CompactBlueprint& blueprint,
+                                  ScheduleAlgorithm algorithm, string* error)
+{
+    INSTRUMENT_SCOPE("ConstructBluePrint");
+    // rank与slice编号以16位存储，超出时写入会被截断
+    if (rankSize > COMPACT_MAX_VALUE) {
+        blueprint.Clear();
+        if (error != nullptr) {
+            *error = "紧凑存储要求rankSize不超过" + to_string(COMPACT_MAX_VALUE) + ": N=" + to_string(rankSize);
+        }
+        return false;
+    }
+    ScheduleOptions options;
+    algorithm = ResolveSchedule(rankSize, planeNum, algorithm, options);
+    SolutionUtils::FillBlueprint(rankSize, planeNum, algorithm, options, blueprint);
+    return true;
+}
+
+LazyBlueprint Solution::ConstructLazyBluePrint(uint32_t rankSize, uint32_t planeNum,
+                                               ScheduleAlgorithm algorithm) const
+{
+    ScheduleOptions options;
+    algorithm = ResolveSchedule(rankSize, planeNum, algorithm, options);
+    return LazyBlueprint(rankSize, planeNum, algorithm, options);
+}
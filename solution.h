@@ -5,7 +5,11 @@
 #ifndef CPP_SOLUTION_H
 #define CPP_SOLUTION_H
 
+#include "cost_model.h"
 #include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 constexpr const uint32_t DEFAULT_PLANE_ID = 65535;
@@ -17,16 +21,120 @@ struct Action {
     uint32_t dstRank{INVALID_RANK_ID};
     uint32_t planeId{DEFAULT_PLANE_ID};
     uint32_t sliceId{INVALID_SLICE_ID};
+    // slice被切成chunkNum块时，本action只搬运第chunkId块（数据量为 S/N/chunkNum）
+    uint16_t chunkId{0};
+    uint16_t chunkNum{1};
 };
 
 using Phase = std::vector<Action>;
 using Schedule = std::vector<Phase>;
 using Blueprint = std::vector<Schedule>;
 
+// 调度算法族
+enum class ScheduleAlgorithm {
+    AUTO,     // 按代价模型在下列算法中自动选择
+    RING,        // 双向ring，N-1个phase
+    HALVING,     // 递归减半（N为2的幂）/ Bruck（其它N），ceil(log2 N)个phase
+    MULTI_RING,  // 最多P/2个步长互异的边不相交ring，每个ring正反两个方向，每个slice切成P块，
+                 // 每个plane沿自己的ring只搬运其中一块，N-1个phase；即pipelineDepth为1的CHUNKED_RING
+    CHUNKED_RING, // MULTI_RING的切块方式，另按pipelineDepth分份流水
+    HIERARCHICAL  // 两级ring：先在节点内reduce-scatter，再在各节点同位置的rank之间跨节点reduce-scatter，
+                  // 需要ScheduleOptions::ranksPerNode整除N；phase数为 (R-1) + (N/R-1)
+};
+
+// 算法族之外的可调参数
+struct ScheduleOptions {
+    // CHUNKED_RING：每个plane上的块再切成pipelineDepth份，第d份推迟d个phase启动，
+    // 使一份的第k+1步与另一份的第k步重叠；phase数为 N-1 + pipelineDepth-1
+    uint32_t pipelineDepth{1};
+    // 生成线程数：1为串行，0为使用全部硬件线程；并行生成的结果与串行完全相同
+    uint32_t threadNum{1};
+    // 按度数预算内的并行边拓扑（见 edge_allocator.h）估计冲突率并选择算法，
+    // 而不是评测程序的每对一条边；只影响AUTO的选择与EstimateTime，不改变生成的action
+    bool parallelEdges{false};
+    // MULTI_RING / CHUNKED_RING使用的环数上限，0为最多P/2个；环数少时每rank度数低，
+    // 但同一(步长, 方向)上的plane更多
+    uint32_t ringNum{0};
+    // CHUNKED_RING各plane搬运的块数之比，下标为planeId，为空时各plane相同；
+    // 代价模型给出异构plane时由Solution按带宽设置（见 SolutionUtils::CalcPlaneWeights），权重为0的plane不搬运数据
+    std::vector<uint32_t> planeWeights;
+    // HIERARCHICAL的每节点rank数，并用于估计各算法的跨节点phase；为0时由Solution取代价模型的ranksPerNode
+    // （见 SolutionUtils::ApplyNodeTopology）
+    uint32_t ranksPerNode{0};
+};
+
+const char* ScheduleAlgorithmName(ScheduleAlgorithm algorithm);
+bool ParseScheduleAlgorithm(const std::string& name, ScheduleAlgorithm& algorithm);
+
+// 集合通信类型，各rank持有的数据均按N个slice划分
+enum class Collective {
+    REDUCE_SCATTER,  // 最终rank i 持有全部rank对slice i的贡献之和
+    ALL_GATHER,      // rank i 初始持有完整的slice i，最终每个rank持有全部slice
+    ALL_REDUCE       // reduce-scatter后接all-gather，最终每个rank持有全部slice的和
+};
+
+const char* CollectiveName(Collective collective);
+bool ParseCollective(const std::string& name, Collective& collective);
+
+class FlatBlueprint;     // 见 flat_blueprint.h
+class CompactBlueprint;  // 见 compact_blueprint.h
+class LazyBlueprint;     // 见 lazy_blueprint.h
+class TuningTable;       // 见 schedule_tuner.h
+
 // Solution 类声明
 class Solution {
 public:
+    Solution() = default;
+    explicit Solution(const CostModel& costModel) : costModel_(costModel) {}
+
+    void SetScheduleOptions(const ScheduleOptions& options) { options_ = options; }
+    const ScheduleOptions& GetScheduleOptions() const { return options_; }
+    // AUTO时优先使用调优表中 (N, P) 的算法与参数，表中没有该形状时按代价模型选择
+    void SetTuningTable(std::shared_ptr<const TuningTable> table) { tuningTable_ = std::move(table); }
+    const std::shared_ptr<const TuningTable>& GetTuningTable() const { return tuningTable_; }
+
     Blueprint ConstructBluePrint(uint32_t rankSize, uint32_t planeNum);
+    // 指定算法族；若该算法所需的每rank度数超过planeNum，则先退回MULTI_RING，仍不可行时退回RING
+    Blueprint ConstructBluePrint(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm);
+    // 直接填充扁平Blueprint，复用blueprint已有的内存
+    void ConstructBluePrint(uint32_t rankSize, uint32_t planeNum, FlatBlueprint& blueprint,
+                            ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO);
+    // 紧凑模式：16位列存储，rankSize超过COMPACT_MAX_VALUE时清空blueprint并返回false，在error中给出原因
+    bool ConstructBluePrint(uint32_t rankSize, uint32_t planeNum, CompactBlueprint& blueprint,
+                            ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO, std::string* error = nullptr);
+    // 异构plane：planeNum为planes.size()，以planes替换代价模型的planes后构造，CHUNKED_RING按各plane的带宽分配块数；
+    // 只作用于本次构造，不修改本对象的代价模型。之后的估计与构造也需使用这些plane时请用SetCostModel设置，
+    // 评分时使用同一代价模型（见 blueprint_scorer.h）
+    Blueprint ConstructBluePrint(uint32_t rankSize, const std::vector<PlaneProfile>& planes,
+                                 ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO);
+    // all-gather：把所选算法的reduce-scatter逐phase倒序、每个action反向，phase数与reduce-scatter相同
+    Blueprint ConstructAllGatherBluePrint(uint32_t rankSize, uint32_t planeNum,
+                                          ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO);
+    // all-reduce：reduce-scatter后接上述all-gather，前者的最后一个phase与后者的第一个phase合并，
+    // 共 2K-1 个phase（K为reduce-scatter的phase数）。算法按reduce-scatter的代价选择
+    Blueprint ConstructAllReduceBluePrint(uint32_t rankSize, uint32_t planeNum,
+                                          ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO);
+    // 不构造Blueprint，返回按需计算各rank action的视图，AUTO按代价模型解析
+    LazyBlueprint ConstructLazyBluePrint(uint32_t rankSize, uint32_t planeNum,
+                                         ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO) const;
+
+    // 按代价模型估算各候选算法的通信时间，返回最小者（闭式计算，不构造Blueprint）
+    ScheduleAlgorithm SelectAlgorithm(uint32_t rankSize, uint32_t planeNum) const;
+    // 估算指定算法的通信时间，算法不可行（度数超过planeNum）时返回无穷大
+    double EstimateTime(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm) const;
+    // 构造时实际请求的算法与选项：AUTO先查调优表（命中时覆盖options中的调优参数），再按代价模型选择；
+    // 调优表按单节点的同构plane调优，代价模型为异构plane或多节点时不查表。
+    // 异构plane时同时填写options.planeWeights，多节点时填写options.ranksPerNode
+    ScheduleAlgorithm ResolveSchedule(uint32_t rankSize, uint32_t planeNum, ScheduleAlgorithm algorithm,
+                                      ScheduleOptions& options) const;
+
+    void SetCostModel(const CostModel& costModel) { costModel_ = costModel; }
+    const CostModel& GetCostModel() const { return costModel_; }
+
+private:
+    CostModel costModel_;
+    ScheduleOptions options_;
+    std::shared_ptr<const TuningTable> tuningTable_;
 };
 
 
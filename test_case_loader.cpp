@@ -0,0 +1,568 @@
+//
+// 测试用例文件的流式读取实现
+//
+
+#include "test_case_loader.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+using namespace std;
+
+constexpr size_t TestCaseReader::BUFFER_SIZE;
+
+namespace {
+
+// 数字字面量的最大长度，超过时视为格式错误
+constexpr const size_t MAX_NUMBER_LENGTH = 64;
+
+void SetError(string* error, const string& message)
+{
+    if (error != nullptr) {
+        *error = message;
+    }
+}
+
+bool IsNumberChar(int c)
+{
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+int HexValue(int c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+void AppendUtf8(string& value, uint32_t codePoint)
+{
+    if (codePoint < 0x80) {
+        value.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        value.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        value.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+} // namespace
+
+vector<TestCase> DefaultTestCases()
+{
+    static const uint32_t SHAPES[][2] = {
+        {4, 2}, {4, 6}, {5, 2}, {5, 4}, {10, 4},
+        {10, 10}, {32, 6}, {33, 4}, {64, 8}, {128, 18}
+    };
+    vector<TestCase> testCases;
+    for (const auto& shape : SHAPES) {
+        TestCase testCase;
+        testCase.rankSize = shape[0];
+        testCase.planeNum = shape[1];
+        testCases.push_back(testCase);
+    }
+    return testCases;
+}
+
+TestCaseReader::~TestCaseReader()
+{
+    Close();
+}
+
+TestCaseReader::TestCaseReader(TestCaseReader&& other)
+{
+    Swap(other);
+}
+
+TestCaseReader& TestCaseReader::operator=(TestCaseReader&& other)
+{
+    if (this != &other) {
+        Close();
+        Swap(other);
+    }
+    return *this;
+}
+
+void TestCaseReader::Swap(TestCaseReader& other)
+{
+    swap(file_, other.file_);
+    path_.swap(other.path_);
+    buffer_.swap(other.buffer_);
+    swap(pos_, other.pos_);
+    swap(end_, other.end_);
+    swap(line_, other.line_);
+    swap(state_, other.state_);
+    swap(rootIsObject_, other.rootIsObject_);
+    swap(firstElement_, other.firstElement_);
+    swap(caseCount_, other.caseCount_);
+    error_.swap(other.error_);
+    key_.swap(other.key_);
+}
+
+bool TestCaseReader::Open(const string& path, string* error)
+{
+    Close();
+    file_ = fopen(path.c_str(), "rb");
+    if (file_ == nullptr) {
+        SetError(error, "无法打开文件: " + path);
+        return false;
+    }
+    path_ = path;
+    buffer_.resize(BUFFER_SIZE);
+    return true;
+}
+
+void TestCaseReader::Close()
+{
+    if (file_ != nullptr) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+    path_.clear();
+    pos_ = 0;
+    end_ = 0;
+    line_ = 1;
+    state_ = State::START;
+    rootIsObject_ = false;
+    firstElement_ = true;
+    caseCount_ = 0;
+    error_.clear();
+}
+
+bool TestCaseReader::Next(TestCase& testCase)
+{
+    if (file_ == nullptr || state_ == State::DONE) {
+        return false;
+    }
+    if (state_ == State::START) {
+        if (!EnterList()) {
+            state_ = State::DONE;
+            return false;
+        }
+        state_ = State::LIST;
+        firstElement_ = true;
+    }
+
+    if (SkipWhitespace() == ']') {
+        Get();
+        state_ = State::DONE;
+        FinishRoot();
+        return false;
+    }
+    if (!firstElement_ && !Expect(',')) {
+        state_ = State::DONE;
+        return false;
+    }
+    firstElement_ = false;
+    if (!ParseCase(testCase)) {
+        state_ = State::DONE;
+        return false;
+    }
+    ++caseCount_;
+    return true;
+}
+
+bool TestCaseReader::Refill()
+{
+    pos_ = 0;
+    end_ = fread(buffer_.data(), 1, buffer_.size(), file_);
+    return end_ > 0;
+}
+
+int TestCaseReader::Peek()
+{
+    if (pos_ == end_ && !Refill()) {
+        return EOF;
+    }
+    return static_cast<unsigned char>(buffer_[pos_]);
+}
+
+int TestCaseReader::Get()
+{
+    int c = Peek();
+    if (c != EOF) {
+        ++pos_;
+        if (c == '\n') {
+            ++line_;
+        }
+    }
+    return c;
+}
+
+int TestCaseReader::SkipWhitespace()
+{
+    int c = Peek();
+    while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        Get();
+        c = Peek();
+    }
+    return c;
+}
+
+bool TestCaseReader::Expect(char expected)
+{
+    if (SkipWhitespace() != expected) {
+        return Fail(string("期望 '") + expected + "'");
+    }
+    Get();
+    return true;
+}
+
+bool TestCaseReader::Fail(const string& message)
+{
+    if (error_.empty()) {
+        error_ = path_ + ":" + to_string(line_) + ": " + message;
+    }
+    return false;
+}
+
+bool TestCaseReader::ParseString(string* value)
+{
+    if (!Expect('"')) {
+        return false;
+    }
+    if (value != nullptr) {
+        value->clear();
+    }
+    while (true) {
+        int c = Get();
+        if (c == EOF || c == '\n') {
+            return Fail("字符串未结束");
+        }
+        if (c == '"') {
+            return true;
+        }
+        if (c != '\\') {
+            if (value != nullptr) {
+                value->push_back(static_cast<char>(c));
+            }
+            continue;
+        }
+        c = Get();
+        char decoded;
+        switch (c) {
+            case '"': decoded = '"'; break;
+            case '\\': decoded = '\\'; break;
+            case '/': decoded = '/'; break;
+            case 'b': decoded = '\b'; break;
+            case 'f': decoded = '\f'; break;
+            case 'n': decoded = '\n'; break;
+            case 'r': decoded = '\r'; break;
+            case 't': decoded = '\t'; break;
+            case 'u': {
+                // 代理对按两个码元分别编码，键名与算法名只用到ASCII
+                uint32_t codePoint = 0;
+                for (int i = 0; i < 4; ++i) {
+                    int digit = HexValue(Get());
+                    if (digit < 0) {
+                        return Fail("非法的\\u转义");
+                    }
+                    codePoint = (codePoint << 4) | static_cast<uint32_t>(digit);
+                }
+                if (value != nullptr) {
+                    AppendUtf8(*value, codePoint);
+                }
+                continue;
+            }
+            default:
+                return Fail("非法的转义字符");
+        }
+        if (value != nullptr) {
+            value->push_back(decoded);
+        }
+    }
+}
+
+bool TestCaseReader::ParseNumber(double& value)
+{
+    char text[MAX_NUMBER_LENGTH + 1];
+    size_t length = 0;
+    SkipWhitespace();
+    while (IsNumberChar(Peek())) {
+        if (length == MAX_NUMBER_LENGTH) {
+            return Fail("数字过长");
+        }
+        text[length++] = static_cast<char>(Get());
+    }
+    text[length] = '\0';
+    char* parsedEnd = nullptr;
+    value = strtod(text, &parsedEnd);
+    if (length == 0 || parsedEnd != text + length) {
+        return Fail("期望数字");
+    }
+    return true;
+}
+
+bool TestCaseReader::ParseNumberArray(vector<double>& values)
+{
+    values.clear();
+    if (!Expect('[')) {
+        return false;
+    }
+    if (SkipWhitespace() == ']') {
+        Get();
+        return true;
+    }
+    for (;;) {
+        double value;
+        if (!ParseNumber(value)) {
+            return false;
+        }
+        values.push_back(value);
+        int c = SkipWhitespace();
+        Get();
+        if (c == ']') {
+            return true;
+        }
+        if (c != ',') {
+            return Fail("期望 ',' 或 ']'");
+        }
+    }
+}
+
+bool TestCaseReader::ParseLiteral(const char* literal)
+{
+    for (const char* c = literal; *c != '\0'; ++c) {
+        if (Get() != *c) {
+            return Fail(string("期望 ") + literal);
+        }
+    }
+    return true;
+}
+
+bool TestCaseReader::SkipValue()
+{
+    int c = SkipWhitespace();
+    if (c == '"') {
+        return ParseString(nullptr);
+    }
+    if (c == 't') {
+        return ParseLiteral("true");
+    }
+    if (c == 'f') {
+        return ParseLiteral("false");
+    }
+    if (c == 'n') {
+        return ParseLiteral("null");
+    }
+    if (c != '{' && c != '[') {
+        double ignored;
+        return ParseNumber(ignored);
+    }
+
+    // 容器只核对括号配对，内部的逗号、冒号与标量逐字节跳过，字符串单独处理以免误认其中的括号
+    string closers;
+    do {
+        c = SkipWhitespace();
+        if (c == EOF) {
+            return Fail("文件意外结束");
+        }
+        if (c == '"') {
+            if (!ParseString(nullptr)) {
+                return false;
+            }
+            continue;
+        }
+        Get();
+        if (c == '{') {
+            closers.push_back('}');
+        } else if (c == '[') {
+            closers.push_back(']');
+        } else if (c == '}' || c == ']') {
+            if (closers.empty() || closers.back() != c) {
+                return Fail("括号不匹配");
+            }
+            closers.pop_back();
+        }
+    } while (!closers.empty());
+    return true;
+}
+
+bool TestCaseReader::EnterList()
+{
+    int c = SkipWhitespace();
+    if (c == '[') {
+        Get();
+        rootIsObject_ = false;
+        return true;
+    }
+    if (!Expect('{')) {
+        return false;
+    }
+    rootIsObject_ = true;
+    for (bool first = true; ; first = false) {
+        if (SkipWhitespace() == '}') {
+            return Fail("找不到test_case_list");
+        }
+        if (!first && !Expect(',')) {
+            return false;
+        }
+        if (!ParseString(&key_) || !Expect(':')) {
+            return false;
+        }
+        if (key_ == "test_case_list") {
+            return Expect('[');
+        }
+        if (!SkipValue()) {
+            return false;
+        }
+    }
+}
+
+bool TestCaseReader::ParseCase(TestCase& testCase)
+{
+    testCase = TestCase();
+    if (!Expect('{')) {
+        return false;
+    }
+    bool hasRankSize = false;
+    bool hasPlaneNum = false;
+    vector<double> planeBandwidths;
+    vector<double> planeLatencies;
+    double interNodeLatency = 0.0;  // 0为未给出
+    double interNodeBandwidth = 0.0;
+    for (bool first = true; ; first = false) {
+        if (SkipWhitespace() == '}') {
+            Get();
+            break;
+        }
+        if (!first && !Expect(',')) {
+            return false;
+        }
+        if (!ParseString(&key_) || !Expect(':')) {
+            return false;
+        }
+
+        if (key_ == "rank_size" || key_ == "plane_num" || key_ == "ranks_per_node") {
+            double value;
+            if (!ParseNumber(value)) {
+                return false;
+            }
+            if (!(value >= 0.0 && value <= UINT32_MAX && value == floor(value))) {
+                return Fail(key_ + " 必须是非负整数");
+            }
+            // ranks_per_node为0表示单节点，rank数与plane数至少为1
+            if (key_ != "ranks_per_node" && value < 1.0) {
+                return Fail(key_ + " 必须是正整数");
+            }
+            if (key_ == "rank_size") {
+                testCase.rankSize = static_cast<uint32_t>(value);
+                hasRankSize = true;
+            } else if (key_ == "ranks_per_node") {
+                testCase.costModel.ranksPerNode = static_cast<uint32_t>(value);
+            } else {
+                testCase.planeNum = static_cast<uint32_t>(value);
+                hasPlaneNum = true;
+            }
+        } else if (key_ == "S" || key_ == "data_size" || key_ == "B" || key_ == "bandwidth" ||
+                   key_ == "L" || key_ == "phase_latency" || key_ == "inter_node_bandwidth" ||
+                   key_ == "inter_node_latency") {
+            double value;
+            if (!ParseNumber(value)) {
+                return false;
+            }
+            if (!(value > 0.0) || std::isinf(value)) {
+                return Fail(key_ + " 必须是正数");
+            }
+            if (key_ == "S" || key_ == "data_size") {
+                testCase.costModel.dataSize = value;
+            } else if (key_ == "B" || key_ == "bandwidth") {
+                testCase.costModel.bandwidth = value;
+            } else if (key_ == "inter_node_bandwidth") {
+                interNodeBandwidth = value;
+            } else if (key_ == "inter_node_latency") {
+                interNodeLatency = value;
+            } else {
+                testCase.costModel.phaseLatency = value;
+            }
+        } else if (key_ == "algorithm" || key_ == "algo") {
+            string name;
+            if (!ParseString(&name)) {
+                return false;
+            }
+            if (!ParseScheduleAlgorithm(name, testCase.algorithm)) {
+                return Fail("未知算法: " + name);
+            }
+            testCase.hasAlgorithm = true;
+        } else if (key_ == "plane_bandwidth" || key_ == "plane_latency") {
+            vector<double>& values = (key_ == "plane_bandwidth") ? planeBandwidths : planeLatencies;
+            if (!ParseNumberArray(values)) {
+                return false;
+            }
+            for (double value : values) {
+                // 带宽为0表示该plane不可用；时延可以为0
+                if (!(value >= 0.0) || std::isinf(value)) {
+                    return Fail(key_ + " 必须是非负数");
+                }
+            }
+        } else if (!SkipValue()) {
+            return false;
+        }
+    }
+    if (!hasRankSize || !hasPlaneNum) {
+        return Fail("用例缺少 rank_size 或 plane_num");
+    }
+    // 未给出的跨节点参数取用例的B / L
+    testCase.costModel.interNodeBandwidth = (interNodeBandwidth > 0.0) ? interNodeBandwidth :
+                                            testCase.costModel.bandwidth;
+    testCase.costModel.interNodeLatency = (interNodeLatency > 0.0) ? interNodeLatency :
+                                          testCase.costModel.phaseLatency;
+    if (!planeBandwidths.empty() || !planeLatencies.empty()) {
+        if ((!planeBandwidths.empty() && planeBandwidths.size() != testCase.planeNum) ||
+            (!planeLatencies.empty() && planeLatencies.size() != testCase.planeNum)) {
+            return Fail("plane_bandwidth / plane_latency 的长度必须等于 plane_num");
+        }
+        // 未给出的一项取用例的B / L
+        testCase.costModel.planes.resize(testCase.planeNum);
+        for (uint32_t planeId = 0; planeId < testCase.planeNum; ++planeId) {
+            PlaneProfile& plane = testCase.costModel.planes[planeId];
+            plane.bandwidth = planeBandwidths.empty() ? testCase.costModel.bandwidth : planeBandwidths[planeId];
+            plane.phaseLatency = planeLatencies.empty() ? testCase.costModel.phaseLatency : planeLatencies[planeId];
+        }
+    }
+    return true;
+}
+
+bool TestCaseReader::FinishRoot()
+{
+    if (rootIsObject_) {
+        while (SkipWhitespace() != '}') {
+            if (!Expect(',') || !ParseString(&key_) || !Expect(':') || !SkipValue()) {
+                return false;
+            }
+        }
+        Get();
+    }
+    if (SkipWhitespace() != EOF) {
+        return Fail("根之后存在多余内容");
+    }
+    return true;
+}
+
+bool LoadTestCases(const string& path, vector<TestCase>& testCases, string* error)
+{
+    TestCaseReader reader;
+    if (!reader.Open(path, error)) {
+        return false;
+    }
+    TestCase testCase;
+    while (reader.Next(testCase)) {
+        testCases.push_back(testCase);
+    }
+    if (!reader.Error().empty()) {
+        SetError(error, reader.Error());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,114 @@
+//
+// 测试用例文件的流式读取：单遍扫描，固定大小的读缓冲，不把整个文件读入内存，
+// 每次Next()解析出一个用例，可以边读边评测。
+//
+// 支持的格式（根对象中的其它字段、用例中的未知字段可为任意JSON值，含嵌套数组/对象，均被跳过）：
+//   {"test_case_list": [{"rank_size": 4, "plane_num": 2, "S": ..., "B": ..., "L": ..., "algorithm": "ring"}, ...]}
+//   或直接以用例数组为根：[{"rank_size": 4, "plane_num": 2}, ...]
+// 用例字段：
+//   rank_size / plane_num        必需，正整数
+//   S / data_size                可选，数据量，单位同 cost_model.h
+//   B / bandwidth                可选，带宽，单位同 cost_model.h
+//   L / phase_latency            可选，阶段启动时延，单位同 cost_model.h
+//   algorithm / algo             可选，算法提示，取值同 --algo
+//   plane_bandwidth              可选，长度为plane_num的数组，各plane的带宽（0为不可用），此时B为参考带宽
+//   plane_latency                可选，长度为plane_num的数组，各plane的启动时延
+//   两者给出任一项即为异构plane（CostModel::planes），未给出的一项各plane取B / L
+//   ranks_per_node               可选，非负整数，每个节点的rank数，0（默认）为单节点
+//   inter_node_bandwidth         可选，跨节点链路的带宽，默认取B
+//   inter_node_latency           可选，有跨节点通信的phase的启动时延，默认取L
+//
+
+#ifndef CPP_TEST_CASE_LOADER_H
+#define CPP_TEST_CASE_LOADER_H
+
+#include "solution.h"
+#include "cost_model.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct TestCase {
+    uint32_t rankSize{0};
+    uint32_t planeNum{0};
+    CostModel costModel;  // 未给出的字段取默认值
+    ScheduleAlgorithm algorithm{ScheduleAlgorithm::AUTO};
+    bool hasAlgorithm{false};  // 文件中是否给出了algorithm
+};
+
+// 与sample.json相同的内置用例，文件无法打开时使用
+std::vector<TestCase> DefaultTestCases();
+
+// 流式读取器，非线程安全。对象可移动不可复制，析构时关闭文件
+class TestCaseReader {
+public:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    TestCaseReader() = default;
+    ~TestCaseReader();
+    TestCaseReader(TestCaseReader&& other);
+    TestCaseReader& operator=(TestCaseReader&& other);
+    TestCaseReader(const TestCaseReader&) = delete;
+    TestCaseReader& operator=(const TestCaseReader&) = delete;
+
+    // 失败时返回false并在error中给出原因
+    bool Open(const std::string& path, std::string* error = nullptr);
+    void Close();
+    bool IsOpen() const { return file_ != nullptr; }
+
+    // 读取下一个用例；用例读完或出错时返回false，出错时Error()非空
+    bool Next(TestCase& testCase);
+    const std::string& Error() const { return error_; }
+    // 已读出的用例数
+    size_t CaseCount() const { return caseCount_; }
+
+private:
+    enum class State {
+        START,  // 尚未读取根
+        LIST,   // 位于用例数组内
+        DONE
+    };
+
+    void Swap(TestCaseReader& other);
+
+    // 字节层：行号只用于错误信息
+    int Peek();
+    int Get();
+    bool Refill();
+    int SkipWhitespace();
+    bool Expect(char expected);
+    bool Fail(const std::string& message);
+
+    // 词法/语法层
+    bool ParseString(std::string* value);  // value为nullptr时只跳过
+    bool ParseNumber(double& value);
+    bool ParseNumberArray(std::vector<double>& values);
+    bool ParseLiteral(const char* literal);
+    bool SkipValue();  // 任意JSON值，嵌套深度只受内存限制
+
+    // 在根对象中找到test_case_list并进入数组；根本身为数组时直接进入
+    bool EnterList();
+    bool ParseCase(TestCase& testCase);
+    // 数组结束后检查根对象的剩余部分
+    bool FinishRoot();
+
+    std::FILE* file_{nullptr};
+    std::string path_;
+    std::vector<char> buffer_;
+    size_t pos_{0};
+    size_t end_{0};
+    size_t line_{1};
+    State state_{State::START};
+    bool rootIsObject_{false};
+    bool firstElement_{true};
+    size_t caseCount_{0};
+    std::string error_;
+    std::string key_;  // 复用的键缓冲
+};
+
+// 读取全部用例，失败时返回false并在error中给出原因（已读出的用例保留在testCases中）
+bool LoadTestCases(const std::string& path, std::vector<TestCase>& testCases, std::string* error = nullptr);
+
+#endif // CPP_TEST_CASE_LOADER_H
@@ -1,8 +1,21 @@
 // evaluator.cpp - 完整评测程序
 #include "solution.h"
+#include "flat_blueprint.h"
+#include "compact_blueprint.h"
+#include "cost_model.h"
+#include "blueprint_scorer.h"
+#include "network_simulator.h"
+#include "semantic_verifier.h"
+#include "edge_allocator.h"
+#include "test_case_loader.h"
+#include "batch_evaluator.h"
+#include "instrumentation.h"
+#include "schedule_tuner.h"
+#include "blueprint_replanner.h"
+#include "blueprint_file.h"
+#include "schedule_generators.h"
 #include <iostream>
 #include <vector>
-#include <map>
 #include <cmath>
 #include <chrono>
 #include <algorithm>
@@ -11,91 +24,48 @@
 
 using namespace std;
 
-// 评测常量
-constexpr double L = 0.002;  // 阶段启动时延 ms
-constexpr double S = 40.0 * 1024.0 * 1024.0;  // 40 MB
-constexpr double B = 400.0 * 1024.0 * 1024.0 * 1024.0;  // 400 GB/s
-constexpr double BETA = 1.5;
-constexpr double SCORE_MAX = 100.0;
+// --simulate: 额外用离散事件仿真回放Blueprint（不影响得分）
+bool SIMULATE = false;
+// --verify: 额外校验集合通信语义（不影响得分）
+bool VERIFY = false;
+// --collective: 评测的集合通信类型，影响构造的Blueprint、理论最小时间与语义校验
+Collective COLLECTIVE = Collective::REDUCE_SCATTER;
+// --parallel-edges: 在度数预算内为热点对分配并行边后再评分（评测规则为每对一条边）
+bool PARALLEL_EDGES = false;
+// --fail-planes / --fail-links: 评分后按给定的故障增量重排（只对三层vector存储），输出重排结果（不影响得分）
+FailureSet FAILURES;
+// --save / --load: 把各用例生成的Blueprint写入目录 / 从目录映射之前写入的文件评分，不重新生成
+string SAVE_DIR;
+string LOAD_DIR;
 
-// 手动解析sample.json（避免依赖外部库）
-vector<pair<uint32_t, uint32_t>> LoadTestCases(const string& filename) {
-    vector<pair<uint32_t, uint32_t>> test_cases;
-    ifstream file(filename);
-    
-    if (!file.is_open()) {
-        cerr << "无法打开文件: " << filename << endl;
-        // 使用硬编码的测试用例
-        test_cases = {
-            {4, 2}, {4, 6}, {5, 2}, {5, 4}, {10, 4},
-            {10, 10}, {32, 6}, {33, 4}, {64, 8}, {128, 18}
-        };
-        cout << "使用内置测试用例" << endl;
-        return test_cases;
-    }
-    
-    string line, content;
-    while (getline(file, line)) {
-        content += line;
-    }
-    file.close();
-    
-    // 简单解析JSON
-    size_t pos = content.find("\"test_case_list\"");
-    if (pos == string::npos) {
-        cerr << "JSON格式错误" << endl;
-        return test_cases;
-    }
-    
-    pos = content.find('[', pos);
-    size_t end_pos = content.find(']', pos);
-    
-    if (pos == string::npos || end_pos == string::npos) {
-        cerr << "JSON格式错误" << endl;
-        return test_cases;
-    }
-    
-    string array_content = content.substr(pos, end_pos - pos + 1);
-    
-    // 解析每个测试用例
-    pos = 0;
-    while ((pos = array_content.find("\"rank_size\"", pos)) != string::npos) {
-        // rank_size
-        size_t colon_pos = array_content.find(':', pos);
-        size_t comma_pos = array_content.find(',', colon_pos);
-        string rank_str = array_content.substr(colon_pos + 1, comma_pos - colon_pos - 1);
-        
-        // plane_num
-        pos = array_content.find("\"plane_num\"", comma_pos);
-        colon_pos = array_content.find(':', pos);
-        comma_pos = array_content.find(',', colon_pos);
-        if (comma_pos == string::npos) {
-            comma_pos = array_content.find('}', colon_pos);
-        }
-        string plane_str = array_content.substr(colon_pos + 1, comma_pos - colon_pos - 1);
-        
-        // 转换为数字
-        try {
-            uint32_t rank_size = stoi(rank_str);
-            uint32_t plane_num = stoi(plane_str);
-            test_cases.push_back({rank_size, plane_num});
-        } catch (...) {
-            cerr << "解析数字失败" << endl;
-        }
+// 每个评测线程独立的状态，其中的计数表跨用例复用
+struct EvalContext {
+    CostModel costModel;  // 当前用例的L/S/B（见 cost_model.h），用例文件未给出时取默认值
+    BlueprintScorer scorer;
+    NetworkSimulator simulator;
+    SemanticVerifier verifier;
+    EdgeAllocator allocator;
+    BlueprintReplanner replanner;
+    Solution solution;
+
+    void SetCostModel(const CostModel& model) {
+        costModel = model;
+        scorer.SetCostModel(model);
+        simulator.SetModel(NetworkModel::FromCostModel(model));
+        solution.SetCostModel(model);
     }
-    
-    return test_cases;
-}
+};
 
-// 验证Blueprint基本正确性
-bool ValidateBlueprint(const Blueprint& bp, uint32_t N, uint32_t P, bool verbose = false) {
+// 验证Blueprint基本正确性（Blueprint与FlatBlueprint均可）
+template <typename BlueprintT>
+bool ValidateBlueprint(const BlueprintT& bp, uint32_t N, uint32_t P, ostream& out, bool verbose = false) {
     if (bp.size() != P) {
-        if (verbose) cerr << "错误: plane数量不正确 (" << bp.size() << " != " << P << ")" << endl;
+        if (verbose) out << "错误: plane数量不正确 (" << bp.size() << " != " << P << ")" << endl;
         return false;
     }
     
     if (bp.empty()) {
-        if (verbose) cerr << "错误: Blueprint为空" << endl;
+        if (verbose) out << "错误: Blueprint为空" << endl;
         return false;
     }
     
@@ -103,19 +73,23 @@ bool ValidateBlueprint(const Blueprint& bp, uint32_t N, uint32_t P, bool verbose
     size_t expected_phases = bp[0].size();
     for (size_t p = 1; p < bp.size(); ++p) {
         if (bp[p].size() != expected_phases) {
-            if (verbose) cerr << "错误: plane " << p << "的phase数不一致" << endl;
+            if (verbose) out << "错误: plane " << p << "的phase数不一致" << endl;
             return false;
         }
     }
     
-    // 检查每个phase的action数
+    // 检查每个action的合法性
+    // 非ring算法（如递归减半）每个phase的action数不固定，可能一个rank发送多个slice，也可能为空
     for (size_t p = 0; p < bp.size(); ++p) {
         for (size_t ph = 0; ph < bp[p].size(); ++ph) {
-            // 每个phase应该有N个action
-            if (bp[p][ph].size() != N) {
-                if (verbose) cerr << "错误: plane " << p << " phase " << ph 
-                                 << "有" << bp[p][ph].size() << "个action，但N=" << N << endl;
-                return false;
+            for (const auto& action : bp[p][ph]) {
+                if (action.srcRank >= N || action.dstRank >= N || action.sliceId >= N ||
+                    action.planeId != p || action.chunkNum == 0 || action.chunkId >= action.chunkNum) {
+                    if (verbose) out << "错误: plane " << p << " phase " << ph
+                                     << "存在非法action (" << action.srcRank << "->" << action.dstRank
+                                     << ", plane " << action.planeId << ", slice " << action.sliceId << ")" << endl;
+                    return false;
+                }
             }
         }
     }
@@ -123,197 +97,444 @@ bool ValidateBlueprint(const Blueprint& bp, uint32_t N, uint32_t P, bool verbose
     return true;
 }
 
-// 计算理论最小时间（保守估计）
-double CalculateTheoreticalMinTime(uint32_t N, uint32_t P) {
-    // 最小阶段数：log2(N)向上取整，但不能小于N-1
-    double min_phases;
-    if ((N & (N - 1)) == 0) { // 2的幂
-        min_phases = log2(N);
-    } else {
-        min_phases = ceil(log2(N));
+// 模拟拓扑生成和冲突率计算
+// 评分规则见 blueprint_scorer.h：
+//   1. 阶段启动时间 T1 = K * L
+//   2. 统计有通信的rank对 w(u,v)
+//   3. 为每个有通信的pair分配1条边 m(u,v)，度数超过P则无效（返回1e100）；
+//      --parallel-edges时改用EdgeAllocator在度数预算内分配的 m(u,v) >= 1
+//   4. 每个阶段取最大链路冲突率 max_cr（无通信的阶段记为1）
+//   5. T2 = S / (N * B) * Σ max_cr
+template <typename BlueprintT>
+double CalculateCommunicationTime(EvalContext& ctx, const BlueprintT& bp, uint32_t N, uint32_t P) {
+    if (!PARALLEL_EDGES) {
+        return ctx.scorer.CalculateCommunicationTime(bp, N, P);
     }
-    
-    double T1_min = min_phases * L;
-    
-    // 数据传输最小时间：总数据量 / (带宽 * 并行度)
-    // 每个rank需要发送和接收(N-1)个数据块，每个数据块大小为S/N
-    double total_data_per_rank = (N - 1) * S / N;
-    
-    // 理想情况下，所有P个plane并行，所有链路满载
-    double T2_min = total_data_per_rank / (B * P);
-    
-    return T1_min + T2_min;
+    EdgeAllocation allocation = ctx.allocator.Allocate(bp, N, P);
+    return ctx.scorer.CalculateCommunicationTime(bp, N, P, allocation);
 }
 
-// 模拟拓扑生成和冲突率计算
-double CalculateCommunicationTime(const Blueprint& bp, uint32_t N, uint32_t P) {
-    uint32_t K = bp[0].size(); // 阶段数
-    
-    // 1. 阶段启动时间
-    double T1 = K * L;
-    
-    // 2. 统计总通信量 w(u,v)
-    map<pair<uint32_t, uint32_t>, uint32_t> w;
-    for (const auto& schedule : bp) {
-        for (const auto& phase : schedule) {
+// 通信时间为无穷大的原因：有通信的plane或跨节点链路带宽不为正（见 CostModel::PlaneTimeRatio）
+template <typename BlueprintT>
+string DescribeInfiniteTime(const CostModel& model, const BlueprintT& bp) {
+    for (size_t p = 0; p < bp.size(); ++p) {
+        if (!isinf(model.PlaneTimeRatio(static_cast<uint32_t>(p)))) {
+            continue;
+        }
+        for (const auto& phase : bp[p]) {
             for (const auto& action : phase) {
                 if (action.srcRank != action.dstRank) {
-                    w[{action.srcRank, action.dstRank}]++;
+                    return "plane " + to_string(p) + " 带宽为0但承载了通信";
                 }
             }
         }
     }
-    
-    // 3. 分配边 m(u,v) - 简化算法
-    map<pair<uint32_t, uint32_t>, uint32_t> m;
-    map<uint32_t, uint32_t> degree; // 每个group的度数
-    
-    // 先为每个有通信的pair分配1条边
-    for (const auto& item : w) {
-        uint32_t u = item.first.first;
-        uint32_t v = item.first.second;
-        
-        auto edge_key = make_pair(min(u, v), max(u, v));
-        if (m[edge_key] == 0) {
-            m[edge_key] = 1;
-            degree[u]++;
-            degree[v]++;
+    return "跨节点带宽为0但有跨节点通信";
+}
+
+// 验证并计算单个Blueprint的得分
+template <typename BlueprintT>
+double ScoreBlueprint(EvalContext& ctx, const BlueprintT& bp, uint32_t N, uint32_t P, ostream& out, bool verbose) {
+    // 验证Blueprint
+    if (!ValidateBlueprint(bp, N, P, out, verbose)) {
+        if (verbose) {
+            out << "  ❌ 验证失败，得0分" << endl;
         }
+        return 0.0;
     }
     
-    // 检查度数约束
-    for (uint32_t u = 0; u < N; ++u) {
-        if (degree[u] > P) {
-            // 度数超过P，尝试重新分配
-            return 1e100; // 返回一个大数表示无效
-        }
-    }
+    // 计算理论最小时间
+    double T_min = CalcTheoreticalMinTime(N, P, ctx.costModel, COLLECTIVE);
     
-    // 4. 计算每个阶段的链路冲突率
-    double sum_T2_prime = 0.0;
+    // 计算实际通信时间
+    double T = CalculateCommunicationTime(ctx, bp, N, P);
     
-    for (uint32_t phase_idx = 0; phase_idx < K; ++phase_idx) {
-        map<pair<uint32_t, uint32_t>, uint32_t> cr_phase;
-        
-        // 统计该阶段的通信量
-        for (const auto& schedule : bp) {
-            if (phase_idx < schedule.size()) {
-                const auto& phase = schedule[phase_idx];
-                for (const auto& action : phase) {
-                    if (action.srcRank != action.dstRank) {
-                        cr_phase[{action.srcRank, action.dstRank}]++;
-                    }
-                }
-            }
+    if (isinf(T)) {
+        if (verbose) {
+            out << "  ❌ " << DescribeInfiniteTime(ctx.costModel, bp) << "，得0分" << endl;
         }
-        
-        // 计算该阶段的最大冲突率
-        double max_cr = 0.0;
-        for (const auto& item : cr_phase) {
-            uint32_t u = item.first.first;
-            uint32_t v = item.first.second;
-            auto edge_key = make_pair(min(u, v), max(u, v));
-            
-            if (m.find(edge_key) != m.end() && m[edge_key] > 0) {
-                double cr = static_cast<double>(item.second) / m[edge_key];
-                if (cr > max_cr) max_cr = cr;
-            }
+        return 0.0;
+    }
+    if (T >= INVALID_COMMUNICATION_TIME) { // 无效方案
+        if (verbose) {
+            out << "  ❌ 无效方案（度数超过P），得0分" << endl;
         }
-        
-        // 如果max_cr为0（可能该阶段没有通信），设置为1
-        if (max_cr < 1e-6) max_cr = 1.0;
-        
-        sum_T2_prime += max_cr;
+        return 0.0;
     }
     
-    // 5. 计算总数据传输时间
-    double T2 = (S / (N * B)) * sum_T2_prime;
+    // 计算得分
+    double score = CalcScore(T, T_min);
     
-    return T1 + T2;
-}
-
-// 计算单个测试用例的得分
-double EvaluateTestCase(uint32_t N, uint32_t P, Solution& solution, bool verbose = false) {
     if (verbose) {
-        cout << "  运行算法..." << endl;
+        out << fixed;
+        out.precision(3);
+        out << "  阶段数: " << bp[0].size() << endl;
+        out << "  理论最小时间: " << T_min << " ms" << endl;
+        out << "  实际通信时间: " << T << " ms" << endl;
+        out.precision(2);
+        out << "  得分: " << score << "/100" << endl;
+    }
+    if (verbose && SIMULATE) {
+        SimulationResult sim = ctx.simulator.Simulate(bp, N, P);
+        streamsize precision = out.precision(3);
+        out << "  仿真完成时间: " << sim.makespan << " ms（关键路径 " << sim.criticalPath.size()
+             << " 步，最大链路利用率 " << sim.maxLinkUtilisation * 100 << "%）" << endl;
+        out.precision(precision);
+    }
+    if (verbose && VERIFY) {
+        VerifyResult check = ctx.verifier.Verify(bp, N, P, COLLECTIVE);
+        out << "  语义校验: " << (check.ok ? "通过" : check.message) << endl;
     }
     
+    return score;
+}
+
+// 按FAILURES增量重排，输出耗时（不含故障前的Prepare）、改动的plane以及存活plane数下的通信时间
+void ReportReplan(EvalContext& ctx, Blueprint bp, uint32_t N, ostream& out) {
+    ReplanStats stats;
+    string error;
+    ctx.replanner.Prepare(bp, N);
     auto start = chrono::high_resolution_clock::now();
-    Blueprint bp = solution.ConstructBluePrint(N, P);
+    bool ok = ctx.replanner.Replan(bp, N, FAILURES, &stats, &error);
     auto end = chrono::high_resolution_clock::now();
-    auto duration = chrono::duration_cast<chrono::microseconds>(end - start);
-    
-    if (verbose) {
-        cout << "  运行时间: " << duration.count() / 1000.0 << " ms" << endl;
+    if (!ok) {
+        out << "  故障重排: 失败（" << error << "）" << endl;
+        return;
     }
-    
-    // 验证Blueprint
-    if (!ValidateBlueprint(bp, N, P, verbose)) {
-        if (verbose) {
-            cout << "  ❌ 验证失败，得0分" << endl;
-        }
+    // 本函数的格式只用于以下几行，之后恢复，不影响调用方输出的得分
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    out << fixed;
+    out.precision(3);
+    out << "  故障重排: " << ReplanModeName(stats.mode) << "，耗时 "
+        << chrono::duration<double, micro>(end - start).count() << " us，改动 " << stats.rebuiltPlanes.size()
+        << " 个plane，搬移 " << stats.movedActionNum << " 个action，度数 " << stats.rankDegree << "/"
+        << stats.alivePlaneNum << endl;
+    double T = ctx.scorer.CalculateCommunicationTime(bp, N, stats.alivePlaneNum);
+    if (T >= INVALID_COMMUNICATION_TIME) {
+        out << "  重排后: 无效方案（度数超过存活plane数）" << endl;
+    } else {
+        out << "  重排后通信时间: " << T << " ms" << endl;
+    }
+    if (VERIFY) {
+        VerifyResult check = ctx.verifier.Verify(bp, N, static_cast<uint32_t>(bp.size()), COLLECTIVE);
+        out << "  重排后语义校验: " << (check.ok ? "通过" : check.message) << endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+// 实际生成的算法：按调优表/代价模型解析后，不可行的算法与生成时一样退回MULTI_RING或RING
+ScheduleAlgorithm GeneratedAlgorithm(const Solution& solution, uint32_t N, uint32_t P, ScheduleAlgorithm algorithm) {
+    ScheduleOptions resolved_options;
+    ScheduleAlgorithm selected = solution.ResolveSchedule(N, P, algorithm, resolved_options);
+    return SolutionUtils::ResolveFeasibleAlgorithm(N, P, selected, resolved_options);
+}
+
+// 第index个用例（从0开始）的Blueprint文件
+string BlueprintFilePath(const string& dir, size_t index) {
+    return dir + "/case_" + to_string(index + 1) + ".bp";
+}
+
+// 映射--save写入的文件并评分，文件头中的N、P须与用例一致
+double EvaluateMappedCase(EvalContext& ctx, const string& path, uint32_t N, uint32_t P, ostream& out) {
+    MappedBlueprint bp;
+    string error;
+    auto start = chrono::high_resolution_clock::now();
+    bool opened = bp.Open(path, &error);
+    auto end = chrono::high_resolution_clock::now();
+    if (!opened) {
+        out << "  ❌ " << error << "，得0分" << endl;
         return 0.0;
     }
-    
-    // 计算理论最小时间
-    double T_min = CalculateTheoreticalMinTime(N, P);
-    
-    // 计算实际通信时间
-    double T = CalculateCommunicationTime(bp, N, P);
-    
-    if (T > 1e50) { // 无效方案
-        if (verbose) {
-            cout << "  ❌ 无效方案（度数超过P），得0分" << endl;
-        }
+    if (bp.RankSize() != N || bp.size() != P) {
+        out << "  ❌ " << path << " 的形状 (N=" << bp.RankSize() << ", P=" << bp.size() << ") 与用例不一致，得0分"
+            << endl;
         return 0.0;
     }
+    out << "  映射 " << path << " (" << ScheduleAlgorithmName(bp.Algorithm()) << ", " << bp.MappedBytes()
+        << " 字节)..." << endl;
+    out << "  映射时间: " << chrono::duration_cast<chrono::microseconds>(end - start).count() / 1000.0 << " ms"
+        << endl;
+    return ScoreBlueprint(ctx, bp, N, P, out, true);
+}
+
+// Blueprint的存储方式
+enum class StorageMode {
+    NESTED,   // 三层vector
+    FLAT,     // FlatBlueprint
+    COMPACT   // CompactBlueprint
+};
+
+// 计算单个测试用例的得分
+// save_path非空时把生成的Blueprint写入该文件（只支持扁平与紧凑存储）
+double EvaluateTestCase(EvalContext& ctx, uint32_t N, uint32_t P, ostream& out, bool verbose = false,
+                        StorageMode mode = StorageMode::NESTED,
+                        ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO, const string& save_path = string()) {
+    Solution& solution = ctx.solution;
+    if (verbose) {
+        out << "  运行算法 (" << ScheduleAlgorithmName(GeneratedAlgorithm(solution, N, P, algorithm)) << ")..." << endl;
+    }
     
-    // 计算得分
-    double score;
-    if (T <= T_min) {
-        score = SCORE_MAX;
+    Blueprint bp;
+    FlatBlueprint flat_bp;
+    CompactBlueprint compact_bp;
+    string error;
+    auto start = chrono::high_resolution_clock::now();
+    if (mode == StorageMode::FLAT) {
+        solution.ConstructBluePrint(N, P, flat_bp, algorithm);
+    } else if (mode == StorageMode::COMPACT) {
+        if (!solution.ConstructBluePrint(N, P, compact_bp, algorithm, &error)) {
+            if (verbose) {
+                out << "  ❌ " << error << "，得0分" << endl;
+            }
+            return 0.0;
+        }
+    } else if (COLLECTIVE == Collective::ALL_GATHER) {
+        bp = solution.ConstructAllGatherBluePrint(N, P, algorithm);
+    } else if (COLLECTIVE == Collective::ALL_REDUCE) {
+        bp = solution.ConstructAllReduceBluePrint(N, P, algorithm);
     } else {
-        double ratio = T / T_min;
-        score = SCORE_MAX * exp(-BETA * (ratio - 1));
+        bp = solution.ConstructBluePrint(N, P, algorithm);
     }
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::microseconds>(end - start);
     
     if (verbose) {
-        cout << fixed;
-        cout.precision(3);
-        cout << "  阶段数: " << bp[0].size() << endl;
-        cout << "  理论最小时间: " << T_min << " ms" << endl;
-        cout << "  实际通信时间: " << T << " ms" << endl;
-        cout.precision(2);
-        cout << "  得分: " << score << "/100" << endl;
+        out << "  运行时间: " << duration.count() / 1000.0 << " ms" << endl;
+    }
+    if (!save_path.empty()) {
+        ScheduleAlgorithm selected = GeneratedAlgorithm(solution, N, P, algorithm);
+        bool saved = (mode == StorageMode::FLAT) ? WriteBlueprintFile(save_path, flat_bp, N, selected, &error) :
+                     WriteBlueprintFile(save_path, compact_bp, N, selected, &error);
+        out << "  保存: " << (saved ? save_path : error) << endl;
     }
     
+    if (mode == StorageMode::FLAT) {
+        return ScoreBlueprint(ctx, flat_bp, N, P, out, verbose);
+    }
+    if (mode == StorageMode::COMPACT) {
+        return ScoreBlueprint(ctx, compact_bp, N, P, out, verbose);
+    }
+    double score = ScoreBlueprint(ctx, bp, N, P, out, verbose);
+    if (verbose && (!FAILURES.planes.empty() || !FAILURES.links.empty())) {
+        ReportReplan(ctx, bp, N, out);
+    }
     return score;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // --flat: 使用FlatBlueprint构造和评分
+    // --compact: 使用CompactBlueprint构造和评分
+    // --algo <auto|ring|halving|multiring|chunkedring|hierarchical>: 指定调度算法族，默认按代价模型自动选择
+    // --pipeline <D>: chunkedring的流水深度
+    // --threads <T>: 生成Blueprint的线程数（0为全部硬件线程）
+    // --simulate: 输出离散事件仿真的完成时间
+    // --verify: 输出集合通信语义校验结果
+    // --collective <reducescatter|allgather|allreduce>: 集合通信类型，默认reducescatter，
+    //     allgather / allreduce只支持三层vector存储
+    // --parallel-edges: 按度数预算内分配的并行边拓扑选择算法并评分
+    // --ranks-per-node <R>: 每个节点的rank数，覆盖用例文件中的ranks_per_node（跨节点带宽与时延仍取用例中的值）
+    // --cases <path>: 测试用例文件，默认sample.json
+    // --jobs <J>: 同时评测的用例数（0为全部硬件线程），输出顺序与J无关
+    // --tuning <path>: AUTO时使用autotune生成的调优表
+    // --profile <path> / --trace <path>: 输出生成过程的计时与计数（JSON / Chrome trace），需以INSTRUMENT=1编译
+    // --save <dir>: 把各用例的Blueprint写入 <dir>/case_<i>.bp（见 blueprint_file.h），需配合--flat或--compact
+    // --load <dir>: 映射--save写入的文件评分，不重新生成Blueprint
+    // --fail-planes <p,...>: 评分后假设这些plane失效并增量重排（见 blueprint_replanner.h）
+    // --fail-links <u-v,...>: 评分后假设这些rank对之间的链路在所有plane上失效并增量重排
+    StorageMode mode = StorageMode::NESTED;
+    ScheduleAlgorithm algorithm = ScheduleAlgorithm::AUTO;
+    ScheduleOptions options;
+    bool algorithm_forced = false;
+    string cases_path = "sample.json";
+    uint32_t job_num = 1;
+    uint32_t ranks_per_node = 0;
+    string profile_path;
+    string tuning_path;
+    string trace_path;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--flat") {
+            mode = StorageMode::FLAT;
+        } else if (arg == "--compact") {
+            mode = StorageMode::COMPACT;
+        } else if (arg == "--algo" && i + 1 < argc) {
+            if (!ParseScheduleAlgorithm(argv[++i], algorithm)) {
+                cerr << "未知算法: " << argv[i] << endl;
+                return 1;
+            }
+            algorithm_forced = true;
+        } else if (arg == "--pipeline" && i + 1 < argc) {
+            options.pipelineDepth = static_cast<uint32_t>(stoul(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threadNum = static_cast<uint32_t>(stoul(argv[++i]));
+        } else if (arg == "--simulate") {
+            SIMULATE = true;
+        } else if (arg == "--verify") {
+            VERIFY = true;
+        } else if (arg == "--collective" && i + 1 < argc) {
+            if (!ParseCollective(argv[++i], COLLECTIVE)) {
+                cerr << "未知集合通信类型: " << argv[i] << endl;
+                return 1;
+            }
+        } else if (arg == "--parallel-edges") {
+            PARALLEL_EDGES = true;
+            options.parallelEdges = true;
+        } else if (arg == "--ranks-per-node" && i + 1 < argc) {
+            ranks_per_node = static_cast<uint32_t>(stoul(argv[++i]));
+        } else if (arg == "--cases" && i + 1 < argc) {
+            cases_path = argv[++i];
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            job_num = static_cast<uint32_t>(stoul(argv[++i]));
+        } else if (arg == "--tuning" && i + 1 < argc) {
+            tuning_path = argv[++i];
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (arg == "--save" && i + 1 < argc) {
+            SAVE_DIR = argv[++i];
+        } else if (arg == "--load" && i + 1 < argc) {
+            LOAD_DIR = argv[++i];
+        } else if (arg == "--fail-planes" && i + 1 < argc) {
+            istringstream list(argv[++i]);
+            string item;
+            while (getline(list, item, ',')) {
+                FAILURES.planes.push_back(static_cast<uint32_t>(stoul(item)));
+            }
+        } else if (arg == "--fail-links" && i + 1 < argc) {
+            istringstream list(argv[++i]);
+            string item;
+            while (getline(list, item, ',')) {
+                LinkFailure link;
+                size_t dash = item.find('-');
+                // 两端都必须是数字，缺少'-'时不能当成u == v的自环
+                if (dash == 0 || dash == string::npos || dash + 1 == item.size() ||
+                    item.find_first_not_of("0123456789-") != string::npos ||
+                    item.find('-', dash + 1) != string::npos) {
+                    cerr << "非法的链路: " << item << "（应为u-v）" << endl;
+                    return 1;
+                }
+                link.u = static_cast<uint32_t>(stoul(item.substr(0, dash)));
+                link.v = static_cast<uint32_t>(stoul(item.substr(dash + 1)));
+                FAILURES.links.push_back(link);
+            }
+        }
+    }
+    
+    if (COLLECTIVE != Collective::REDUCE_SCATTER && mode != StorageMode::NESTED) {
+        cerr << CollectiveName(COLLECTIVE) << " 只支持三层vector存储" << endl;
+        return 1;
+    }
+    if (!SAVE_DIR.empty() && mode == StorageMode::NESTED) {
+        cerr << "--save 只支持--flat或--compact存储" << endl;
+        return 1;
+    }
+    if (!LOAD_DIR.empty() && COLLECTIVE != Collective::REDUCE_SCATTER) {
+        cerr << "--load 只支持reducescatter" << endl;
+        return 1;
+    }
+    
     cout << "========================================" << endl;
     cout << "  多平面 reduce_scatter 通信编排评测系统" << endl;
     cout << "========================================" << endl;
+    if (COLLECTIVE != Collective::REDUCE_SCATTER) {
+        cout << "集合通信类型: " << CollectiveName(COLLECTIVE) << endl;
+    }
     
-    // 加载测试用例
-    vector<pair<uint32_t, uint32_t>> test_cases = LoadTestCases("sample.json");
-    cout << "加载 " << test_cases.size() << " 个测试用例" << endl;
+    // 流式读取测试用例，读出一个评测一个；文件无法打开时使用内置用例
+    TestCaseReader reader;
+    vector<TestCase> fallback_cases;
+    string error;
+    if (!reader.Open(cases_path, &error)) {
+        cerr << error << endl;
+        fallback_cases = DefaultTestCases();
+        cout << "使用内置测试用例" << endl;
+    }
     
-    Solution solution;
+    BatchEvaluator batch(job_num);
+    vector<EvalContext> contexts(batch.JobNum());
+    shared_ptr<TuningTable> tuning_table;
+    if (!tuning_path.empty()) {
+        tuning_table = make_shared<TuningTable>();
+        if (!tuning_table->Load(tuning_path, &error)) {
+            cerr << error << endl;
+            return 1;
+        }
+        cout << "使用调优表 " << tuning_path << "（" << tuning_table->size() << " 个形状）" << endl;
+    }
+    for (auto& ctx : contexts) {
+        ctx.solution.SetScheduleOptions(options);
+        ctx.solution.SetTuningTable(tuning_table);
+    }
     double total_score = 0.0;
+    size_t fallback_index = 0;
     
-    // 评测每个测试用例
-    for (size_t i = 0; i < test_cases.size(); i++) {
-        uint32_t N = test_cases[i].first;
-        uint32_t P = test_cases[i].second;
+    // 评测每个测试用例：各线程独立生成与评分，报告按用例顺序输出
+    auto next_case = [&](TestCase& test_case) {
+        if (reader.IsOpen()) {
+            return reader.Next(test_case);
+        }
+        if (fallback_index >= fallback_cases.size()) {
+            return false;
+        }
+        test_case = fallback_cases[fallback_index++];
+        return true;
+    };
+    auto evaluate = [&](uint32_t worker_id, CaseResult& result) {
+        EvalContext& ctx = contexts[worker_id];
+        const TestCase& test_case = result.testCase;
+        uint32_t N = test_case.rankSize;
+        uint32_t P = test_case.planeNum;
+        CostModel cost_model = test_case.costModel;
+        if (ranks_per_node > 0) {
+            cost_model.ranksPerNode = ranks_per_node;
+        }
+        ctx.SetCostModel(cost_model);
         
-        cout << "\n[测试用例 " << (i+1) << "/" << test_cases.size() << "]" << endl;
-        cout << "  N=" << N << ", P=" << P << endl;
+        ostringstream out;
+        out << "\n[测试用例 " << (result.index + 1) << "]" << endl;
+        out << "  N=" << N << ", P=" << P << endl;
         
-        double score = EvaluateTestCase(N, P, solution, true);
-        total_score += score;
+        // 命令行的--algo优先于用例中的算法提示
+        ScheduleAlgorithm case_algorithm = (test_case.hasAlgorithm && !algorithm_forced) ? test_case.algorithm : algorithm;
+        if (!LOAD_DIR.empty()) {
+            result.score = EvaluateMappedCase(ctx, BlueprintFilePath(LOAD_DIR, result.index), N, P, out);
+        } else {
+            string save_path = SAVE_DIR.empty() ? string() : BlueprintFilePath(SAVE_DIR, result.index);
+            result.score = EvaluateTestCase(ctx, N, P, out, true, mode, case_algorithm, save_path);
+        }
         
-        cout << "  ✅ 本用例得分: " << score << "/100" << endl;
+        out << "  ✅ 本用例得分: " << result.score << "/100" << endl;
+        result.report = out.str();
+    };
+    auto report = [&](const CaseResult& result) {
+        cout << result.report;
+        total_score += result.score;
+    };
+    size_t case_count = batch.Run(next_case, evaluate, report);
+    if (!reader.Error().empty()) {
+        cerr << "用例文件解析错误: " << reader.Error() << endl;
+    }
+    if (case_count == 0) {
+        cerr << "没有可评测的测试用例" << endl;
+        return 1;
+    }
+    
+    if (!profile_path.empty() || !trace_path.empty()) {
+        if (!INSTRUMENTATION_ENABLED) {
+            cerr << "未启用计时与计数（以INSTRUMENT=1 ./compile.sh 编译），输出为空" << endl;
+        }
+        Instrumentation::Snapshot snapshot = Instrumentation::Collect();
+        if (!profile_path.empty()) {
+            ofstream profile(profile_path);
+            Instrumentation::WriteJson(snapshot, profile);
+        }
+        if (!trace_path.empty()) {
+            ofstream trace(trace_path);
+            Instrumentation::WriteChromeTrace(snapshot, trace);
+        }
     }
     
     // 输出总结果
@@ -323,11 +544,11 @@ int main() {
     
     cout << fixed;
     cout.precision(2);
-    cout << "总得分: " << total_score << "/" << (test_cases.size() * 100) << endl;
-    cout << "平均分: " << total_score / test_cases.size() << endl;
+    cout << "总得分: " << total_score << "/" << (case_count * 100) << endl;
+    cout << "平均分: " << total_score / case_count << endl;
     
     // 根据得分给出评级
-    double avg_score = total_score / test_cases.size();
+    double avg_score = total_score / case_count;
     cout << "\n评级: ";
     if (avg_score >= 90) {
         cout << "★★★★★ 优秀" << endl;